@@ -0,0 +1,299 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "AnalysisCheckpoint.h"
+#include "IncidentIndex.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+namespace
+{
+	const uint32 CheckpointMagic = 'I' | ('R' << 8) | ('C' << 16) | ('K' << 24);
+}
+
+AnalysisCheckpoint::~AnalysisCheckpoint()
+{
+	Flush();
+}
+
+void AnalysisCheckpoint::Begin(const FString& checkpointPath, float intervalSeconds, uint64 configurationHash, uint32 extendedFailWindowSeconds)
+{
+	Flush();
+	if (!bResuming)
+	{
+		tail.Reset();
+		bHasTail = false;
+		nextFrame = 0;
+		lastTimeStampMs = 0;
+		timeOrigin = 0;
+	}
+	path = checkpointPath;
+	contentHash = configurationHash;
+	tailMs = (extendedFailWindowSeconds + 1) * 1000;
+	intervalMs = static_cast<uint32>(FMath::Max(intervalSeconds, 0.f) * 1000.f);
+	lastSaveMs = lastTimeStampMs;
+}
+
+void AnalysisCheckpoint::PushFrame(const cv::Mat& sourceFrame, const cv::Mat& analysisFrame, const iris::FrameData& frameData)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisCheckpointFrame);
+
+	if (analysisFrame.empty() && !bHasTail)
+	{
+		return;
+	}
+	FIrisCheckpointFrame tailFrame;
+	tailFrame.frame = frameData.Frame;
+	tailFrame.timeStampMs = static_cast<uint32>(frameData.TimeStampVal);
+	nextFrame = tailFrame.frame + 1;
+	lastTimeStampMs = tailFrame.timeStampMs;
+
+	//The analysis reuses its buffers and the raw frames belong to the caller, the worker gets a copy
+	cv::Mat frameCopy;
+	if (!analysisFrame.empty())
+	{
+		tailFrame.bHalfFloat = sourceFrame.depth() == CV_16F;
+		(tailFrame.bHalfFloat ? sourceFrame : analysisFrame).copyTo(frameCopy);
+		frameSize = frameCopy.size();
+		bHasTail = true;
+	}
+
+	if (pendingFrames >= MaxPendingFrames)
+	{
+		TRACE_CPUPROFILER_EVENT_SCOPE(IrisCheckpointWait);
+		lastWriteTask.Wait();
+	}
+	pendingFrames++;
+	lastWriteTask = writePipe.Launch(UE_SOURCE_LOCATION, [this, tailFrame = MoveTemp(tailFrame), frameCopy]() mutable
+		{
+			if (!frameCopy.empty())
+			{
+				EncodeFrame(frameCopy, tailFrame);
+			}
+			AddTailFrame(MoveTemp(tailFrame));
+			pendingFrames--;
+		});
+}
+
+void AnalysisCheckpoint::EncodeFrame(const cv::Mat& frame, FIrisCheckpointFrame& outTailFrame)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisCheckpointEncode);
+
+	if (outTailFrame.bHalfFloat)
+	{
+		//Lossless, the copy is continuous
+		const int32 rawSize = static_cast<int32>(frame.total() * frame.elemSize());
+		int32 compressedSize = FCompression::CompressMemoryBound(NAME_Zlib, rawSize);
+		outTailFrame.data.SetNumUninitialized(compressedSize);
+		if (!FCompression::CompressMemory(NAME_Zlib, outTailFrame.data.GetData(), compressedSize, frame.data, rawSize, COMPRESS_BiasSpeed))
+		{
+			compressedSize = 0;
+		}
+		outTailFrame.data.SetNum(compressedSize);
+	}
+	else
+	{
+		//Fast compression
+		cv::imencode(".png", frame, encodeBuffer, { cv::IMWRITE_PNG_COMPRESSION, 1 });
+		outTailFrame.data.Append(encodeBuffer.data(), encodeBuffer.size());
+	}
+}
+
+void AnalysisCheckpoint::AddTailFrame(FIrisCheckpointFrame&& tailFrame)
+{
+	tail.Add(MoveTemp(tailFrame));
+	const uint32 newestMs = tail.Last().timeStampMs;
+
+	int32 framesToRemove = 0;
+	while (framesToRemove < tail.Num() - 1 && newestMs - tail[framesToRemove].timeStampMs > tailMs)
+	{
+		framesToRemove++;
+	}
+	if (framesToRemove > 0)
+	{
+		//The new first frame gets the content it repeats
+		int32 lastEncoded = framesToRemove;
+		while (lastEncoded > 0 && tail[lastEncoded].data.IsEmpty())
+		{
+			lastEncoded--;
+		}
+		if (lastEncoded != framesToRemove)
+		{
+			tail[framesToRemove].bHalfFloat = tail[lastEncoded].bHalfFloat;
+			tail[framesToRemove].data = MoveTemp(tail[lastEncoded].data);
+		}
+		tail.RemoveAt(0, framesToRemove);
+	}
+}
+
+bool AnalysisCheckpoint::Save(IncidentIndex& incidents)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisCheckpointSave);
+	lastSaveMs = lastTimeStampMs;
+	if (path.IsEmpty())
+	{
+		return false;
+	}
+
+	//The values of the frames pushed so far, the tail is written by the worker once they are encoded
+	TArray<uint8> header;
+	FMemoryWriter writer(header);
+	uint32 magic = CheckpointMagic;
+	uint32 version = Version;
+	int32 width = frameSize.width;
+	int32 height = frameSize.height;
+	writer << magic << version << contentHash << width << height << nextFrame << lastTimeStampMs << timeOrigin;
+	TArray<uint8> incidentsData;
+	FMemoryWriter incidentsWriter(incidentsData);
+	incidents.Serialize(incidentsWriter);
+
+	lastWriteTask = writePipe.Launch(UE_SOURCE_LOCATION, [this, filePath = path, header = MoveTemp(header), incidentsData = MoveTemp(incidentsData)]()
+		{
+			WriteFile(filePath, header, incidentsData);
+		});
+	return true;
+}
+
+void AnalysisCheckpoint::WriteFile(const FString& filePath, const TArray<uint8>& header, const TArray<uint8>& incidentsData)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisCheckpointWrite);
+
+	TArray<uint8> data(header);
+	data.Append(incidentsData);
+	FMemoryWriter writer(data, false, true);
+	int32 tailFrames = tail.Num();
+	writer << tailFrames;
+	for (FIrisCheckpointFrame& tailFrame : tail)
+	{
+		writer << tailFrame.frame << tailFrame.timeStampMs << tailFrame.bHalfFloat << tailFrame.data;
+	}
+
+	const FString tempPath = filePath + TEXT(".tmp");
+	if (!FFileHelper::SaveArrayToFile(data, *tempPath) || !IFileManager::Get().Move(*filePath, *tempPath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Iris checkpoint could not be written to %s"), *filePath);
+		return;
+	}
+	UE_LOG(LogTemp, Verbose, TEXT("Iris checkpoint at frame %u: %d tail frames, %.1f KB"), tail.Num() > 0 ? tail.Last().frame + 1 : 0, tail.Num(), data.Num() / 1024.0);
+}
+
+void AnalysisCheckpoint::Flush()
+{
+	if (lastWriteTask.IsValid())
+	{
+		lastWriteTask.Wait();
+	}
+}
+
+bool AnalysisCheckpoint::Load(const FString& checkpointPath, uint64 configurationHash)
+{
+	Reset();
+	TArray<uint8> data;
+	if (!FFileHelper::LoadFileToArray(data, *checkpointPath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Iris checkpoint %s could not be read"), *checkpointPath);
+		return false;
+	}
+
+	FMemoryReader reader(data);
+	uint32 magic = 0, version = 0;
+	uint64 hash = 0;
+	int32 width = 0, height = 0;
+	reader << magic << version;
+	if (magic != CheckpointMagic || version != Version)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Iris checkpoint %s is not a version %u checkpoint"), *checkpointPath, Version);
+		return false;
+	}
+	reader << hash << width << height << nextFrame << lastTimeStampMs << timeOrigin;
+	if (hash != configurationHash)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Iris checkpoint %s was written with another appsettings.json"), *checkpointPath);
+		Reset();
+		return false;
+	}
+
+	//The incidents are restored once the tail has been replayed, their serialized state is kept until then
+	const int64 incidentsOffset = reader.Tell();
+	IncidentIndex incidents;
+	incidents.Serialize(reader);
+	incidentState = TArray<uint8>(data.GetData() + incidentsOffset, reader.Tell() - incidentsOffset);
+
+	int32 tailFrames = 0;
+	reader << tailFrames;
+	tail.SetNum(FMath::Clamp(tailFrames, 0, data.Num()));
+	for (FIrisCheckpointFrame& tailFrame : tail)
+	{
+		reader << tailFrame.frame << tailFrame.timeStampMs << tailFrame.bHalfFloat << tailFrame.data;
+	}
+	if (reader.IsError() || (!tail.IsEmpty() && tail[0].data.IsEmpty()))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Iris checkpoint %s is corrupted"), *checkpointPath);
+		Reset();
+		return false;
+	}
+
+	frameSize = cv::Size(width, height);
+	bHasTail = !tail.IsEmpty();
+	path = checkpointPath;
+	contentHash = hash;
+	bResuming = true;
+	UE_LOG(LogTemp, Log, TEXT("Iris checkpoint %s loaded: resuming at frame %u (%.3f s), %d warm-up frames"), *checkpointPath, nextFrame, lastTimeStampMs / 1000.0, tail.Num());
+	return true;
+}
+
+void AnalysisCheckpoint::GetTailFrames(TArray<FIrisFrame>& outFrames) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisCheckpointDecode);
+
+	outFrames.SetNum(tail.Num());
+	cv::Mat lastFrame;
+	for (int32 i = 0; i < tail.Num(); i++)
+	{
+		const TArray<uint8>& data = tail[i].data;
+		if (tail[i].bHalfFloat && !data.IsEmpty())
+		{
+			//A buffer per frame, create() would reuse the one shared with the previous frames
+			cv::Mat decoded(frameSize, CV_16FC4);
+			if (!FCompression::UncompressMemory(NAME_Zlib, decoded.data, static_cast<int32>(decoded.total() * decoded.elemSize()), data.GetData(), data.Num()))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Iris checkpoint frame %u could not be decompressed"), tail[i].frame);
+				decoded.setTo(cv::Scalar::all(0));
+			}
+			lastFrame = decoded;
+		}
+		else if (!data.IsEmpty())
+		{
+			lastFrame = cv::imdecode(cv::Mat(1, data.Num(), CV_8UC1, const_cast<uint8*>(data.GetData())), cv::IMREAD_COLOR);
+		}
+		outFrames[i].frameMatrix = lastFrame;
+		outFrames[i].frameData = iris::FrameData(tail[i].frame, tail[i].timeStampMs);
+	}
+}
+
+void AnalysisCheckpoint::EndResume(IncidentIndex& incidents)
+{
+	FMemoryReader reader(incidentState);
+	incidents.Serialize(reader);
+	incidentState.Empty();
+	bResuming = false;
+}
+
+void AnalysisCheckpoint::Reset()
+{
+	Flush();
+	path.Empty();
+	intervalMs = 0;
+	lastSaveMs = 0;
+	tail.Reset();
+	bHasTail = false;
+	frameSize = cv::Size();
+	nextFrame = 0;
+	lastTimeStampMs = 0;
+	bResuming = false;
+	incidentState.Empty();
+	timeOrigin = 0;
+}
@@ -1,7 +1,24 @@
 //Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
 
 #include "AsyncAnalysis.h"
-#include "IrisEA.h"
+#include "IrisAnalysisContext.h"
+#include "ConfigurationSnapshot.h"
+#include "TieredAnalysis.h"
+#include "DataChart.h"
+#include "SessionResultsWriter.h"
+#include "VideoRecorder.h"
+#include "HalfFloatConversion.h"
+#include "AnalysisCheckpoint.h"
+#include "Tasks/Task.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include <atomic>
+
+THIRD_PARTY_INCLUDES_START
+#include "iris/VideoAnalyser.h"
+#include "src/ConfigurationParams.h"
+#include "utils/FrameConverter.h"
+THIRD_PARTY_INCLUDES_END
 
 bool AsyncAnalysis::Init()
 {
@@ -10,52 +27,360 @@ bool AsyncAnalysis::Init()
 
 uint32 AsyncAnalysis::Run()
 {
-	FIrisEAModule* instance = FIrisEAModule::GetInstance();
-	while (instance->IsIrisActive())
+	BeginAnalysis();
+
+	while (context.bActive)
 	{
 
 		//Analyse all frames in the frameQueue
-		while (!instance->GetFramesToAnalyse()->IsEmpty())
+		while (!context.framesToAnalyse.IsEmpty())
 		{
-			TRACE_CPUPROFILER_EVENT_SCOPE(AsyncIrisAnalysis);
+			AnalyseFrame(*context.framesToAnalyse.Peek());
+			context.framesToAnalyse.Pop();
+		}
+	}
+	//Analysis completed, reset Iris parameters
+	EndAnalysis();
+
+	return 0;
+}
+
+void AsyncAnalysis::BeginAnalysis()
+{
+	const FIrisConfigurationSnapshot& settings = context.configurationSnapshot->GetSnapshot();
+	tileGrid.Initialize(settings);
+	tileGrid.SetDisplayTransform(context.displayTransform);
+	videoFrames = 0;
+
+	if (context.checkpoint != nullptr && context.checkpoint->IsResuming())
+	{
+		ResumeFromCheckpoint();
+	}
+}
+
+void AsyncAnalysis::ResumeFromCheckpoint()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisResumeFromCheckpoint);
+	const double startTime = FPlatformTime::Seconds();
 
-			FIrisFrame* frame = instance->GetFramesToAnalyse()->Peek();
-			instance->GetVideoAnalyser()->AnalyseFrame(frame->frameMatrix, frame->frameData.Frame, frame->frameData);
+	AnalysisCheckpoint& checkpoint = *context.checkpoint;
+	const cv::Size checkpointSize = checkpoint.GetFrameSize();
+	if (cv::Size(checkpointSize.height, checkpointSize.width) != context.analysisFrameSize)
+	{
+		//The windows can not be rebuilt from frames of another size, only the numbering and the incidents are resumed
+		UE_LOG(LogTemp, Warning, TEXT("Iris checkpoint frames are %dx%d, the session analyses %dx%d frames: the analysis resumes without warm-up"),
+			checkpointSize.width, checkpointSize.height, context.analysisFrameSize.height, context.analysisFrameSize.width);
+	}
+	else
+	{
+		TArray<FIrisFrame> tailFrames;
+		checkpoint.GetTailFrames(tailFrames);
+		bWarmingUp = true;
+		AnalyseFrames(tailFrames);
+		bWarmingUp = false;
+		UE_LOG(LogTemp, Log, TEXT("Iris analysis resumed at frame %u, %d warm-up frames replayed in %.1f ms"), checkpoint.GetNextFrame(), tailFrames.Num(),
+			(FPlatformTime::Seconds() - startTime) * 1000.0);
+	}
+	checkpoint.EndResume(context.incidentIndex);
+}
+
+void AsyncAnalysis::AnalyseFrame(FIrisFrame& frame)
+{
+	//The captured frames are checksummed here rather than on the game thread
+	if (frame.tileSignatures.Num() != FrameTileGrid::TileCount)
+	{
+		FrameTileGrid::ComputeTileSignatures(frame.frameMatrix, frame.tileSignatures);
+		frame.frameSignature = StaticFrameFilter::ComputeSignature(frame.tileSignatures);
+	}
+	AnalysePreparedFrame(frame, nullptr);
+}
+
+void AsyncAnalysis::AnalyseFrames(TArrayView<FIrisFrame> frames)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisAnalyseFrames);
 
-			FString lumResult;
-			FString redResult;
-			FString patternResult;
-			//Log frame result
-			if (frame->frameData.luminanceFrameResult == iris::FlashResult::FlashFail ||
-				frame->frameData.luminanceFrameResult == iris::FlashResult::ExtendedFail)
+	for (int32 first = 0; first < frames.Num(); first += BatchChunkFrames)
+	{
+		const int32 count = FMath::Min(BatchChunkFrames, frames.Num() - first);
+		const double prepareStart = FPlatformTime::Seconds();
+		batchPrepareFrameSeconds += PrepareFrames(frames, first, count);
+		const double orderedStart = FPlatformTime::Seconds();
+		batchPrepareSeconds += orderedStart - prepareStart;
+
+		for (int32 i = 0; i < count; i++)
+		{
+			AnalysePreparedFrame(frames[first + i], preparedFrames[i].bPrepared ? &preparedFrames[i] : nullptr);
+			preparedFrames[i].analysisFrame.release();
+		}
+		batchOrderedSeconds += FPlatformTime::Seconds() - orderedStart;
+	}
+	batchFrames += frames.Num();
+}
+
+double AsyncAnalysis::PrepareFrames(TArrayView<FIrisFrame> frames, int32 first, int32 count)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisPrepareFrames);
+
+	std::atomic<uint64> frameCycles{ 0 };
+	ParallelFor(count, [&frames, first, &frameCycles](int32 i)
+		{
+			const uint64 startCycles = FPlatformTime::Cycles64();
+			FIrisFrame& frame = frames[first + i];
+			if (frame.tileSignatures.Num() != FrameTileGrid::TileCount)
 			{
-				lumResult = "Luminance" + resultString[static_cast<int>(frame->frameData.luminanceFrameResult)];
-				UE_LOG(LogTemp, Error, TEXT("Iris %s trigger"), *lumResult)
+				FrameTileGrid::ComputeTileSignatures(frame.frameMatrix, frame.tileSignatures);
+				frame.frameSignature = StaticFrameFilter::ComputeSignature(frame.tileSignatures);
 			}
-			if (frame->frameData.redFrameResult == iris::FlashResult::FlashFail ||
-				frame->frameData.redFrameResult == iris::FlashResult::ExtendedFail)
+			frameCycles += FPlatformTime::Cycles64() - startCycles;
+		});
+
+	//A frame identical to the previous one is skipped by the static frame filter unless the analysis is busy, it is only
+	//converted if it is analysed. The tiles are converted against the previous frame of the batch, the first one against
+	//the last frame of the grid; the grid converts the tiles it finds dirty against another frame on its own
+	preparedFrames.SetNum(FMath::Max(preparedFrames.Num(), count));
+	const bool bTileGrid = NeedsTileGrid();
+	const TArray<uint64>* gridSignatures = tileGrid.GetLastSignatures();
+	ParallelFor(count, [this, &frames, first, bTileGrid, gridSignatures, &frameCycles](int32 i)
+		{
+			const uint64 startCycles = FPlatformTime::Cycles64();
+			const int32 index = first + i;
+			FIrisPreparedFrame& prepared = preparedFrames[i];
+			prepared.bPrepared = index == 0 || frames[index].frameSignature != frames[index - 1].frameSignature;
+			prepared.bPlanes = prepared.bPrepared && bTileGrid;
+			if (prepared.bPlanes)
 			{
-				redResult = "Red" + resultString[static_cast<int>(frame->frameData.redFrameResult)];
-				UE_LOG(LogTemp, Error, TEXT("Iris %s trigger"), *redResult);
+				tileGrid.ConvertTiles(frames[index].frameMatrix, frames[index].tileSignatures, index == 0 ? gridSignatures : &frames[index - 1].tileSignatures, prepared.tiles);
 			}
-			if (frame->frameData.patternFrameResult == iris::PatternResult::Fail)
+			if (prepared.bPrepared)
 			{
-				patternResult = "PatternFail";
-				UE_LOG(LogTemp, Error, TEXT("Iris %s trigger"), *patternResult);
+				ConvertAnalysisFrame(frames[index].frameMatrix, prepared.bgrFrame, prepared.analysisFrame);
 			}
+			frameCycles += FPlatformTime::Cycles64() - startCycles;
+		});
+	return FPlatformTime::ToSeconds64(frameCycles);
+}
+
+bool AsyncAnalysis::NeedsTileGrid() const
+{
+	return context.bRegionTracking || (context.bPatternDetection && tileGrid.GetLuminanceModel() == EIrisLuminanceModel::Relative);
+}
 
-			instance->GetChartManager()->PushFrameDataToArray(frame->frameData);
-			if (instance->GetIsVideoRecording())
+void AsyncAnalysis::ConvertAnalysisFrame(const cv::Mat& frameMatrix, cv::Mat& buffer, cv::Mat& outAnalysisFrame) const
+{
+	//The IRIS library takes 8 bit BGR frames, converted once from the readback view (BGR sources are used as they are,
+	//half float frames are display transformed and sRGB encoded). The tiered analysis keeps its frames so it gets a
+	//new buffer each time, otherwise the buffer is reused
+	if (frameMatrix.depth() == CV_16F || frameMatrix.channels() == 4)
+	{
+		if (context.bTieredAnalysis)
+		{
+			buffer.release();
+		}
+		if (frameMatrix.depth() == CV_16F)
+		{
+			HalfFloatConversion::EncodeFrameBGR(frameMatrix, context.displayTransform, buffer);
+		}
+		else
+		{
+			cv::cvtColor(frameMatrix, buffer, cv::COLOR_BGRA2BGR);
+		}
+		outAnalysisFrame = buffer;
+	}
+	else
+	{
+		outAnalysisFrame = context.bTieredAnalysis ? frameMatrix.clone() : frameMatrix;
+	}
+}
+
+void AsyncAnalysis::AnalysePreparedFrame(FIrisFrame& frame, FIrisPreparedFrame* prepared)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(AsyncIrisAnalysis);
+
+	const bool bRegionTracking = context.bRegionTracking;
+	cv::Mat analysisFrame; //empty for the skipped static frames
+
+	//Split screen views are analysed on the task graph workers while the whole frame is analysed here
+	UE::Tasks::FTask splitScreenTask;
+	const bool bSplitScreen = !frame.views.IsEmpty() || context.splitScreen.GetViewCount() > 0;
+	if (bSplitScreen)
+	{
+		splitScreenTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, &frame]()
 			{
-				instance->GetVideoRecorder()->EnqueueLastFrameAndCheck(*frame, TCHAR_TO_UTF8(*lumResult), TCHAR_TO_UTF8(*redResult), TCHAR_TO_UTF8(*patternResult));
-			}
-			instance->GetFramesToAnalyse()->Pop();
+				context.splitScreen.Update(frame);
+			});
+	}
+	//The frame rate windows of a video session count every frame
+	if (!context.IsVideoSession() && staticFrameFilter.TryReuseLastVerdict(frame))
+	{
+		if (bRegionTracking)
+		{
+			context.regionTracker.AdvanceStatic(frame.frameData.TimeStampVal);
+		}
+		if (context.bPatternDetection && context.patternDetection.AdvanceStatic(frame.frameData.TimeStampVal))
+		{
+			frame.frameData.patternFrameResult = iris::PatternResult::Fail;
 		}
 	}
-	//Analysis completed, reset Iris parameters
-	instance->IrisReset();
+	else
+	{
+		if (NeedsTileGrid())
+		{
+			const bool bPlanes = prepared != nullptr && prepared->bPlanes;
+			tileGrid.Update(frame.frameMatrix, frame.tileSignatures, bPlanes ? &prepared->tiles : nullptr);
+		}
+		else
+		{
+			//Converted in full again by the next frame that needs it
+			tileGrid.Invalidate();
+		}
+		if (bRegionTracking)
+		{
+			context.regionTracker.Update(tileGrid.GetTileStats(), frame.frameData.TimeStampVal);
+		}
 
-	return 0;
+		if (prepared != nullptr)
+		{
+			analysisFrame = prepared->analysisFrame;
+		}
+		else
+		{
+			ConvertAnalysisFrame(frame.frameMatrix, bgrFrame, analysisFrame);
+		}
+
+		//Pattern detection reads the luminance plane, the captured frame and the pixels of the IRIS library frame through a
+		//header of its own, it runs while the flash analysis fills the frameData. The library converts its frame into
+		//planes of its own and only gets a header copy, so a header it reassigns is not seen by the pattern task
+		const bool bPatternDetection = context.bPatternDetection;
+		FPatternFrameResult patternFrameResult(frame.frameData);
+		UE::Tasks::FTask patternTask;
+		if (bPatternDetection)
+		{
+			auto detectPatterns = [this, &frame, &patternFrameResult, patternFrame = analysisFrame]()
+				{
+					//The pattern detection works on relative luminance, the CD sessions convert it separately
+					if (tileGrid.GetLuminanceModel() != EIrisLuminanceModel::Relative)
+					{
+						tileGrid.ConvertRelativeLuminance(frame.frameMatrix, relativeLuminance);
+						context.patternDetection.AnalyseFrame(relativeLuminance, FrameTileGrid::LuminanceScale, patternFrame, patternFrameResult);
+					}
+					else
+					{
+						context.patternDetection.AnalyseFrame(tileGrid.GetLuminancePlane(), FrameTileGrid::LuminanceScale, patternFrame, patternFrameResult);
+					}
+				};
+			//A tier switch re-initializing the IRIS library finishes first
+			const bool bSwitching = context.bTieredAnalysis && context.tieredAnalysis->GetSwitchTask().IsValid() && !context.tieredAnalysis->GetSwitchTask().IsCompleted();
+			patternTask = bSwitching ? UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(detectPatterns), UE::Tasks::Prerequisites(context.tieredAnalysis->GetSwitchTask()))
+				: UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(detectPatterns));
+		}
+
+		cv::Mat libraryFrame = analysisFrame;
+		if (context.bTieredAnalysis)
+		{
+			//A tier switch re-initializes the IRIS library once the pattern detection of the frame is done
+			context.tieredAnalysis->AnalyseFrame(libraryFrame, frame.frameData, patternTask);
+		}
+		else if (context.IsVideoSession())
+		{
+			//The library gets the frame positions from the first frame of the session as with AnalyseVideo, the frame
+			//keeps its number in the video
+			unsigned int libraryFrameIndex = videoFrames++;
+			const unsigned int videoFrame = frame.frameData.Frame;
+			context.videoAnalyser->AnalyseFrame(libraryFrame, libraryFrameIndex, frame.frameData);
+			frame.frameData.Frame = videoFrame;
+		}
+		else
+		{
+			context.videoAnalyser->AnalyseFrame(libraryFrame, frame.frameData.Frame, frame.frameData);
+		}
+		if (bPatternDetection)
+		{
+			patternTask.Wait();
+			patternFrameResult.MergeInto(frame.frameData);
+		}
+		staticFrameFilter.SetAnalysedFrame(frame);
+	}
+
+	if (bSplitScreen)
+	{
+		splitScreenTask.Wait();
+	}
+	if (bWarmingUp)
+	{
+		return;
+	}
+	if (AnalysisCheckpoint* checkpoint = context.checkpoint)
+	{
+		checkpoint->PushFrame(frame.frameMatrix, analysisFrame, frame.frameData);
+	}
+
+	//Failing frames are merged into incidents, logged when they start and end
+	context.incidentIndex.Update(frame.frameData, bRegionTracking ? &context.regionTracker : nullptr);
+
+	if (context.chart != nullptr)
+	{
+		context.chart->PushFrameDataToArray(frame.frameData);
+	}
+	if (context.resultsWriter != nullptr && context.resultsWriter->IsOpen())
+	{
+		context.resultsWriter->PushFrameData(frame.frameData);
+	}
+	if (VideoRecorder* videoRecorder = context.videoRecorder)
+	{
+		std::string lumResult;
+		std::string redResult;
+		std::string patternResult;
+		if (frame.frameData.luminanceFrameResult == iris::FlashResult::FlashFail ||
+			frame.frameData.luminanceFrameResult == iris::FlashResult::ExtendedFail)
+		{
+			lumResult = "Luminance" + resultString[static_cast<int>(frame.frameData.luminanceFrameResult)];
+		}
+		if (frame.frameData.redFrameResult == iris::FlashResult::FlashFail ||
+			frame.frameData.redFrameResult == iris::FlashResult::ExtendedFail)
+		{
+			redResult = "Red" + resultString[static_cast<int>(frame.frameData.redFrameResult)];
+		}
+		if (frame.frameData.patternFrameResult == iris::PatternResult::Fail)
+		{
+			patternResult = "PatternFail";
+		}
+		videoRecorder->EnqueueLastFrameAndCheck(frame, analysisFrame, lumResult, redResult, patternResult);
+	}
+
+	//Written once the frame is in the incidents
+	if (context.checkpoint != nullptr && context.checkpoint->IsDue(frame.frameData.TimeStampVal))
+	{
+		context.checkpoint->Save(context.incidentIndex);
+	}
+}
+
+void AsyncAnalysis::EndAnalysis()
+{
+	if (batchFrames > 0)
+	{
+		//Frames per second of the batches, the preparation scaling over the task graph workers and the ordered stages
+		//(IRIS library conversion and analysis included), which bound the batch speedup
+		const double batchSeconds = batchPrepareSeconds + batchOrderedSeconds;
+		UE_LOG(LogTemp, Log, TEXT("Iris batch analysis: %d frames at %.1f fps, preparation %.3f ms per frame (x%.2f on %d workers), ordered stages %.3f ms per frame"),
+			batchFrames, batchSeconds > 0.0 ? batchFrames / batchSeconds : 0.0, batchPrepareSeconds * 1000.0 / batchFrames,
+			batchPrepareSeconds > 0.0 ? batchPrepareFrameSeconds / batchPrepareSeconds : 0.0, FTaskGraphInterface::Get().GetNumWorkerThreads(),
+			batchOrderedSeconds * 1000.0 / batchFrames);
+	}
+	batchFrames = 0;
+	batchPrepareSeconds = 0.0;
+	batchPrepareFrameSeconds = 0.0;
+	batchOrderedSeconds = 0.0;
+
+	staticFrameFilter.Reset();
+	tileGrid.Reset();
+	bgrFrame.release();
+	preparedFrames.Empty();
+	if (context.checkpoint != nullptr)
+	{
+		//The last checkpoint is written before the session ends
+		context.checkpoint->Flush();
+	}
+	context.EndSession();
 }
 
 void AsyncAnalysis::Stop()
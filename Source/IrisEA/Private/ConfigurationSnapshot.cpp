@@ -0,0 +1,141 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "ConfigurationSnapshot.h"
+#include "Hash/CityHash.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "iris/Configuration.h"
+#include "src/ConfigurationParams.h"
+#include "utils/FrameConverter.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+	void CopyTable(const EA::EACC::Utils::FrameConverterParams* params, float* table)
+	{
+		if (params == nullptr)
+		{
+			return;
+		}
+		const int32 count = FMath::Min<int32>(256, params->values.size());
+		FMemory::Memcpy(table, params->values.data(), count * sizeof(float));
+	}
+}
+
+FIrisSharedConfiguration::FIrisSharedConfiguration() : configuration(MakeUnique<iris::Configuration>())
+{
+}
+
+FIrisSharedConfiguration::~FIrisSharedConfiguration()
+{
+}
+
+namespace
+{
+	uint64 LoadContentHash(const FString& configurationDir, bool& bOutLoaded)
+	{
+		TArray<uint8> json;
+		bOutLoaded = FFileHelper::LoadFileToArray(json, *(configurationDir / TEXT("appsettings.json")));
+		return bOutLoaded ? CityHash64(reinterpret_cast<const char*>(json.GetData()), json.Num()) : 0;
+	}
+}
+
+bool ConfigurationSnapshot::Load(iris::Configuration& configuration, const FString& configurationDir)
+{
+	//The configuration is parsed with the IRIS defaults when the file can not be read
+	bool bLoadedFile = false;
+	const uint64 contentHash = LoadContentHash(configurationDir, bLoadedFile);
+	configuration.Init(TCHAR_TO_UTF8(*configurationDir));
+	Store(configuration, contentHash);
+	return bLoadedFile;
+}
+
+TSharedPtr<FIrisSharedConfiguration, ESPMode::ThreadSafe> ConfigurationSnapshot::LoadShared(const FString& configurationDir)
+{
+	static FCriticalSection cacheLock;
+	static TMap<uint64, TSharedPtr<FIrisSharedConfiguration, ESPMode::ThreadSafe>> cache;
+
+	bool bLoadedFile = false;
+	const uint64 contentHash = LoadContentHash(configurationDir, bLoadedFile);
+	if (!bLoadedFile)
+	{
+		return nullptr;
+	}
+	//The parse reads the other files of the directory, so the directory is part of the key
+	const FString fullDir = FPaths::ConvertRelativePathToFull(configurationDir);
+	const uint64 key = CityHash64WithSeed(reinterpret_cast<const char*>(*fullDir), fullDir.Len() * sizeof(TCHAR), contentHash);
+
+	FScopeLock lock(&cacheLock);
+	if (const TSharedPtr<FIrisSharedConfiguration, ESPMode::ThreadSafe>* cached = cache.Find(key))
+	{
+		return *cached;
+	}
+	TSharedPtr<FIrisSharedConfiguration, ESPMode::ThreadSafe> shared = MakeShared<FIrisSharedConfiguration, ESPMode::ThreadSafe>();
+	shared->configuration->Init(TCHAR_TO_UTF8(*configurationDir));
+	shared->snapshot.Store(*shared->configuration, contentHash);
+	cache.Add(key, shared);
+	return shared;
+}
+
+void ConfigurationSnapshot::Store(iris::Configuration& configuration, uint64 contentHash)
+{
+	FIrisConfigurationSnapshot& newSnapshot = snapshot;
+	newSnapshot = FIrisConfigurationSnapshot();
+
+	//Identifies the configuration of checkpoints and shards
+	newSnapshot.contentHash = contentHash;
+
+	const iris::FlashParams* luminanceParams = configuration.GetLuminanceFlashParams();
+	newSnapshot.luminanceFlashThreshold = luminanceParams->flashThreshold;
+	newSnapshot.luminanceAreaProportion = luminanceParams->areaProportion;
+	newSnapshot.luminanceDarkThreshold = luminanceParams->darkThreshold;
+	const iris::FlashParams* redParams = configuration.GetRedSaturationFlashParams();
+	newSnapshot.redFlashThreshold = redParams->flashThreshold;
+	newSnapshot.redAreaProportion = redParams->areaProportion;
+	newSnapshot.redDarkThreshold = redParams->darkThreshold;
+
+	const iris::TransitionTrackerParams* transitionParams = configuration.GetTransitionTrackerParams();
+	newSnapshot.maxTransitions = transitionParams->maxTransitions;
+	newSnapshot.minTransitions = transitionParams->minTransitions;
+	newSnapshot.extendedFailSeconds = transitionParams->extendedFailSeconds;
+	newSnapshot.extendedFailWindow = transitionParams->extendedFailWindow;
+	newSnapshot.warningTransitions = transitionParams->warningTransitions;
+
+	const iris::PatternDetectionParams* patternParams = configuration.GetPatternDetectionParams();
+	newSnapshot.patternMinStripes = patternParams->minStripes;
+	newSnapshot.patternDarkLuminanceThreshold = patternParams->darkLuminanceThreshold;
+	newSnapshot.patternTimeThreshold = patternParams->timeThreshold;
+	newSnapshot.patternAreaProportion = patternParams->areaProportion;
+
+	newSnapshot.luminanceType = static_cast<uint8>(configuration.GetLuminanceType());
+	newSnapshot.bPatternDetectionEnabled = configuration.PatternDetectionEnabled();
+	newSnapshot.bAnalyseByTime = configuration.AnalyseByTimeEnabled();
+	CopyTable(configuration.GetFrameSrgbConverterParams(), newSnapshot.sRgbValues);
+	CopyTable(configuration.GetFrameCDLuminanceConverterParams(), newSnapshot.cdLuminanceValues);
+
+	bLoaded = true;
+}
+
+iris::FlashParams ConfigurationSnapshot::GetLuminanceFlashParams() const
+{
+	return iris::FlashParams(snapshot.luminanceFlashThreshold, snapshot.luminanceAreaProportion, snapshot.luminanceDarkThreshold);
+}
+
+iris::FlashParams ConfigurationSnapshot::GetRedSaturationFlashParams() const
+{
+	return iris::FlashParams(snapshot.redFlashThreshold, snapshot.redAreaProportion, snapshot.redDarkThreshold);
+}
+
+iris::TransitionTrackerParams ConfigurationSnapshot::GetTransitionTrackerParams() const
+{
+	return iris::TransitionTrackerParams(snapshot.maxTransitions, snapshot.minTransitions, snapshot.extendedFailSeconds,
+		snapshot.extendedFailWindow, snapshot.warningTransitions);
+}
+
+void ConfigurationSnapshot::Reset()
+{
+	snapshot = FIrisConfigurationSnapshot();
+	bLoaded = false;
+}
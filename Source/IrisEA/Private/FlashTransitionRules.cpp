@@ -0,0 +1,104 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "FlashTransitionRules.h"
+#include "ConfigurationSnapshot.h"
+
+void FFlashTransitionParams::Initialize(const FIrisConfigurationSnapshot& settings)
+{
+	maxTransitions = settings.maxTransitions;
+	minTransitions = settings.minTransitions;
+	warningTransitions = settings.warningTransitions;
+	extendedFailMs = settings.extendedFailSeconds * 1000;
+	extendedFailWindowMs = settings.extendedFailWindow * 1000;
+}
+
+iris::FlashResult FlashTransitionRules::GetFlashResult(uint32 transitions, uint32 overMinMs, const FFlashTransitionParams& params)
+{
+	if (transitions > params.maxTransitions)
+	{
+		return iris::FlashResult::FlashFail;
+	}
+	if (overMinMs >= params.extendedFailMs)
+	{
+		return iris::FlashResult::ExtendedFail;
+	}
+	return transitions >= params.warningTransitions ? iris::FlashResult::PassWithWarning : iris::FlashResult::Pass;
+}
+
+TransitionWindow::TransitionWindow(int32 channels)
+	: channelCount(channels)
+{
+	Reset();
+}
+
+void TransitionWindow::Push(unsigned long timeStampMs, const uint8* newTransitions)
+{
+	//Remove the frames that are out of the one second window
+	int32 rowsToRemove = 0;
+	while (rowsToRemove < timeStamps.Num() && timeStampMs - timeStamps[rowsToRemove] >= 1000)
+	{
+		const uint8* row = &history[rowsToRemove * channelCount];
+		for (int32 channel = 0; channel < channelCount; channel++)
+		{
+			transitions[channel] -= row[channel];
+		}
+		rowsToRemove++;
+	}
+	if (rowsToRemove > 0)
+	{
+		timeStamps.RemoveAt(0, rowsToRemove, EAllowShrinking::No);
+		history.RemoveAt(0, rowsToRemove * channelCount, EAllowShrinking::No);
+	}
+
+	timeStamps.Add(timeStampMs);
+	history.Append(newTransitions, channelCount);
+	for (int32 channel = 0; channel < channelCount; channel++)
+	{
+		transitions[channel] += newTransitions[channel];
+	}
+}
+
+void TransitionWindow::Reset()
+{
+	history.Reset();
+	timeStamps.Reset();
+	transitions.Reset();
+	transitions.SetNumZeroed(channelCount);
+}
+
+void ExtendedFailWindow::Initialize(uint32 windowMs)
+{
+	extendedFailWindowMs = windowMs;
+	Reset();
+}
+
+uint32 ExtendedFailWindow::AddFrame(unsigned long timeStampMs, bool bOverMinTransitions)
+{
+	const uint32 frameMs = bHasLastFrame ? timeStampMs - lastTimeStamp : 0;
+	const uint32 overMinFrameMs = bOverMinTransitions ? frameMs : 0;
+	timeStamps.Add(timeStampMs);
+	frameOverMinMs.Add(overMinFrameMs);
+	overMinMs += overMinFrameMs;
+
+	int32 expired = 0;
+	while (expired < timeStamps.Num() && timeStampMs - timeStamps[expired] >= extendedFailWindowMs)
+	{
+		overMinMs -= frameOverMinMs[expired];
+		expired++;
+	}
+	timeStamps.RemoveAt(0, expired, EAllowShrinking::No);
+	frameOverMinMs.RemoveAt(0, expired, EAllowShrinking::No);
+
+	lastTimeStamp = timeStampMs;
+	bHasLastFrame = true;
+	return overMinMs;
+}
+
+void ExtendedFailWindow::Reset()
+{
+	timeStamps.Reset();
+	frameOverMinMs.Reset();
+	overMinMs = 0;
+	bHasLastFrame = false;
+	lastTimeStamp = 0;
+}
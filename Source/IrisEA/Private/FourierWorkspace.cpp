@@ -0,0 +1,84 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "FourierWorkspace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+void FourierWorkspace::Initialize(const cv::Size& size, int32 minFrequency)
+{
+	frameSize = size;
+	dftSize = cv::Size(cv::getOptimalDFTSize(size.width), cv::getOptimalDFTSize(size.height));
+
+	padded = cv::Mat::zeros(dftSize, CV_32F);
+	spectrum.create(dftSize, CV_32FC2);
+	power.create(dftSize, CV_32F);
+	bandMask.create(dftSize, CV_8U);
+
+	//fftshift as index remapping, DC is moved to (cols / 2, rows / 2)
+	const int32 centerX = dftSize.width / 2;
+	const int32 centerY = dftSize.height / 2;
+	shiftRows.SetNumUninitialized(dftSize.height);
+	shiftCols.SetNumUninitialized(dftSize.width);
+	for (int32 y = 0; y < dftSize.height; y++)
+	{
+		shiftRows[y] = (y - centerY + dftSize.height) % dftSize.height;
+	}
+	for (int32 x = 0; x < dftSize.width; x++)
+	{
+		shiftCols[x] = (x - centerX + dftSize.width) % dftSize.width;
+	}
+
+	//Frequencies are scaled back to cycles per frame, the padding increases the spectrum resolution
+	const float scaleX = static_cast<float>(size.width) / dftSize.width;
+	const float scaleY = static_cast<float>(size.height) / dftSize.height;
+	for (int32 y = 0; y < dftSize.height; y++)
+	{
+		uint8* maskRow = bandMask.ptr<uint8>(y);
+		for (int32 x = 0; x < dftSize.width; x++)
+		{
+			const float frequency = FMath::Max(FMath::Abs(x - centerX) * scaleX, FMath::Abs(y - centerY) * scaleY);
+			maskRow[x] = frequency >= minFrequency ? 255 : 0;
+		}
+	}
+}
+
+void FourierWorkspace::ComputePowerSpectrum(const cv::Mat& luminance, double scale)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisPatternPowerSpectrum);
+
+	//The mean is removed so the zero padding does not add a step at the frame borders
+	cv::Mat input = padded(cv::Rect(0, 0, frameSize.width, frameSize.height));
+	luminance.convertTo(input, CV_32F, 1.0 / scale);
+	input -= cv::mean(input);
+
+	//Real input, the output buffer has the same size and type on every frame so it is not reallocated
+	cv::dft(padded, spectrum, cv::DFT_COMPLEX_OUTPUT);
+
+	for (int32 y = 0; y < dftSize.height; y++)
+	{
+		const cv::Vec2f* spectrumRow = spectrum.ptr<cv::Vec2f>(shiftRows[y]);
+		float* powerRow = power.ptr<float>(y);
+		for (int32 x = 0; x < dftSize.width; x++)
+		{
+			const cv::Vec2f& value = spectrumRow[shiftCols[x]];
+			powerRow[x] = value[0] * value[0] + value[1] * value[1];
+		}
+	}
+}
+
+float FourierWorkspace::GetPeakRatio() const
+{
+	double peak = 0.0;
+	cv::minMaxLoc(power, nullptr, &peak, nullptr, nullptr, bandMask);
+	const double mean = cv::mean(power, bandMask)[0];
+	return mean > 0.0 ? static_cast<float>(peak / mean) : 0.f;
+}
+
+void FourierWorkspace::Reset()
+{
+	padded.release();
+	spectrum.release();
+	power.release();
+	bandMask.release();
+	shiftRows.Empty();
+	shiftCols.Empty();
+}
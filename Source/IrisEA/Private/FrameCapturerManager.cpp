@@ -4,7 +4,9 @@
 #include "PixelCaptureOutputFrameBGR.h"
 #include "PixelCaptureInputFrameRHI.h"
 #include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Engine/LocalPlayer.h"
 #include "IrisEA.h"
+#include "HalfFloatConversion.h"
 
 
 FrameCapturerManager::FrameCapturerManager()
@@ -18,12 +20,25 @@ FrameCapturerManager::~FrameCapturerManager()
 {
 }
 
-void FrameCapturerManager::Initialize()
+void FrameCapturerManager::Initialize(int firstFrame, float sessionTimeMs)
 {
     frameCounter = -1;
+    firstFrameNumber = firstFrame;
+    currentSessionTime = sessionTimeMs;
 
     viewport = GEngine->GameViewport->Viewport;
 
+    //The capturer and its textures are kept warm between sessions with the same capture resolution and format
+    float captureResizeProportion = FIrisEAModule::GetInstance()->GetFrameResizeProportion();
+    EPixelFormat format = FIrisEAModule::GetInstance()->IsHdrCaptureActive() ? PF_FloatRGBA : PF_B8G8R8A8;
+    if (captureResizeProportion != resizeProportion || viewport->GetSizeXY() != capturerViewportSize || format != captureFormat)
+    {
+        resizeProportion = captureResizeProportion;
+        capturerViewportSize = viewport->GetSizeXY();
+        captureFormat = format;
+        pixelCapturer = PixelCaptureCapturerRHIToBGRMat::Create(resizeProportion, captureFormat);
+    }
+
 #if LOCAL_SAVE_FRAMES
     CreateVideosDir();
 #endif
@@ -31,7 +46,6 @@ void FrameCapturerManager::Initialize()
 
 void FrameCapturerManager::EndSession()
 {
-    pixelCapturer = PixelCaptureCapturerRHIToBGRMat::Create(resizeProportion);
     if (FIrisEAModule::GetInstance()->IsDebugFrameActive())
     {
         cv::destroyWindow("LastFrame");
@@ -79,8 +93,8 @@ void FrameCapturerManager::Tick(float DeltaTime)
             if (frameCounter == -1)
             {
                 initialViewportSize = viewportSize;
-                CaptureFrame(frame.frameMatrix);
-                frameCounter = 0;
+                CaptureFrame(frame);
+                frameCounter = firstFrameNumber;
                 return;
             }
             else if (ViewportResized(viewportSize))
@@ -91,22 +105,48 @@ void FrameCapturerManager::Tick(float DeltaTime)
 
             TRACE_CPUPROFILER_EVENT_SCOPE(TotalTickIrisCapturer);
 
-            CaptureFrame(frame.frameMatrix);
+            //The tile checksums are computed on the analysis thread
+            CaptureFrame(frame);
 
             //DeltaTime to ms
             currentSessionTime += DeltaTime * 1000;
             frame.frameData = iris::FrameData(frameCounter, currentSessionTime);           //Number and time of the frame
+            if (irisEA->IsSplitScreenActive())
+            {
+                GetSplitScreenViews(frame.views);
+            }
             irisEA->EnqueueIrisFrame(frame);   //Enqueue the frame in order to analyze it
             frameCounter++;
 
             if (irisEA->IsDebugFrameActive())
             {
-                cv::imshow("LastFrame", frame.frameMatrix);
+                if (frame.frameMatrix.depth() == CV_16F)
+                {
+                    //HDR frames are shown as the analysis sees them
+                    cv::Mat debugFrame;
+                    HalfFloatConversion::EncodeFrameBGR(frame.frameMatrix, irisEA->GetDisplayTransform(), debugFrame);
+                    if (irisEA->IsRegionTrackingActive())
+                    {
+                        irisEA->GetRegionTracker()->DrawHeatmap(debugFrame);
+                    }
+                    cv::imshow("LastFrame", debugFrame);
+                }
+                else if (irisEA->IsRegionTrackingActive())
+                {
+                    //The captured frame is shared with the analysis queue, the heatmap is drawn on a copy
+                    cv::Mat debugFrame = frame.frameMatrix.clone();
+                    irisEA->GetRegionTracker()->DrawHeatmap(debugFrame);
+                    cv::imshow("LastFrame", debugFrame);
+                }
+                else
+                {
+                    cv::imshow("LastFrame", frame.frameMatrix);
+                }
             }
         });
 }
 
-void FrameCapturerManager::CaptureFrame(cv::Mat& MatDest)
+void FrameCapturerManager::CaptureFrame(FIrisFrame& frame)
 {
     TRACE_CPUPROFILER_EVENT_SCOPE(IrisCaptureFrame);
     
@@ -118,7 +158,27 @@ void FrameCapturerManager::CaptureFrame(cv::Mat& MatDest)
     );
     FlushRenderingCommands();
     TSharedPtr<PixelCaptureOutputFrameBGR> outputFrame = StaticCastSharedPtr<PixelCaptureOutputFrameBGR>(pixelCapturer->ReadOutput());
-    MatDest = outputFrame->GetMat();
+    outputFrame->TakeMat(frame.frameMatrix, frame.readbackSlot);
+}
+
+void FrameCapturerManager::GetSplitScreenViews(TArray<FBox2f, TInlineAllocator<4>>& outViews) const
+{
+    outViews.Reset();
+    if (GEngine->GameViewport->IsSplitscreenForceDisabled())
+    {
+        return;
+    }
+    const TArray<ULocalPlayer*>& players = GEngine->GetGamePlayers(GEngine->GameViewport);
+    if (players.Num() < 2)
+    {
+        return;
+    }
+    //Origin and size of the player views are normalized to the viewport, the captured frame covers the whole viewport
+    for (const ULocalPlayer* player : players)
+    {
+        const FVector2f origin(player->Origin);
+        outViews.Add(FBox2f(origin, origin + FVector2f(player->Size)));
+    }
 }
 
 bool FrameCapturerManager::ViewportResized(const FIntPoint& newViewportSize)
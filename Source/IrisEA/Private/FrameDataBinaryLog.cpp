@@ -0,0 +1,610 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "FrameDataBinaryLog.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformTime.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Algo/LowerBound.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+namespace
+{
+	const uint8 HeaderMagic[4] = { 'I', 'R', 'I', 'S' };
+	const uint8 IndexMagic[4] = { 'I', 'R', 'I', 'X' };
+	const uint8 BlockMagic[4] = { 'I', 'R', 'I', 'B' };
+	constexpr int64 HeaderSize = 12;
+	constexpr int64 TrailerSize = 16;
+	constexpr int64 BlockHeaderSize = 8; //magic and byte size of the rest of the block
+	constexpr int64 IndexEntrySize = 28;
+
+	FORCEINLINE uint64 FloatToBits(float value)
+	{
+		uint32 bits;
+		FMemory::Memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	FORCEINLINE float BitsToFloat(uint64 value)
+	{
+		const uint32 bits = static_cast<uint32>(value);
+		float result;
+		FMemory::Memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+	//"12.34%" (iris::FrameData::proportionToPercentage) <-> 1234
+	uint64 PercentageToHundredths(const std::string& percentage)
+	{
+		uint64 whole = 0, decimals = 0;
+		int32 decimalDigits = -1;
+		for (char c : percentage)
+		{
+			if (c == '.')
+			{
+				decimalDigits = 0;
+			}
+			else if (c >= '0' && c <= '9')
+			{
+				if (decimalDigits < 0)
+				{
+					whole = whole * 10 + (c - '0');
+				}
+				else if (decimalDigits < 2)
+				{
+					decimals = decimals * 10 + (c - '0');
+					decimalDigits++;
+				}
+			}
+		}
+		return whole * 100 + decimals;
+	}
+
+	std::string HundredthsToPercentage(uint64 hundredths)
+	{
+		const uint64 decimals = hundredths % 100;
+		return std::to_string(hundredths / 100) + (decimals < 10 ? ".0" : ".") + std::to_string(decimals) + '%';
+	}
+
+	FORCEINLINE void WriteVarint(TArray<uint8>& out, uint64 value)
+	{
+		while (value >= 0x80)
+		{
+			out.Add(static_cast<uint8>(value) | 0x80);
+			value >>= 7;
+		}
+		out.Add(static_cast<uint8>(value));
+	}
+
+	FORCEINLINE bool ReadVarint(const uint8*& data, const uint8* end, uint64& value)
+	{
+		value = 0;
+		for (int32 shift = 0; shift < 64 && data < end; shift += 7)
+		{
+			const uint8 byte = *data++;
+			value |= static_cast<uint64>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	FORCEINLINE uint64 ZigZag(int64 value) { return (static_cast<uint64>(value) << 1) ^ static_cast<uint64>(value >> 63); }
+	FORCEINLINE int64 UnZigZag(uint64 value) { return static_cast<int64>(value >> 1) ^ -static_cast<int64>(value & 1); }
+
+	void EncodeColumn(FrameDataBinaryLog::EColumnEncoding encoding, const uint64* values, int32 count, TArray<uint8>& out)
+	{
+		uint64 previous = 0;
+		for (int32 i = 0; i < count; i++)
+		{
+			switch (encoding)
+			{
+			case FrameDataBinaryLog::EColumnEncoding::Delta:
+				WriteVarint(out, ZigZag(static_cast<int64>(values[i] - previous)));
+				previous = values[i];
+				break;
+			case FrameDataBinaryLog::EColumnEncoding::Xor:
+				WriteVarint(out, values[i] ^ previous);
+				previous = values[i];
+				break;
+			case FrameDataBinaryLog::EColumnEncoding::RunLength:
+			{
+				int32 run = 1;
+				while (i + run < count && values[i + run] == values[i])
+				{
+					run++;
+				}
+				WriteVarint(out, values[i]);
+				WriteVarint(out, run);
+				i += run - 1;
+				break;
+			}
+			}
+		}
+	}
+
+	bool DecodeColumn(FrameDataBinaryLog::EColumnEncoding encoding, const uint8* data, const uint8* end, int32 count, uint64* values)
+	{
+		uint64 previous = 0;
+		for (int32 i = 0; i < count;)
+		{
+			uint64 value;
+			if (!ReadVarint(data, end, value))
+			{
+				return false;
+			}
+			switch (encoding)
+			{
+			case FrameDataBinaryLog::EColumnEncoding::Delta:
+				previous += static_cast<uint64>(UnZigZag(value));
+				values[i++] = previous;
+				break;
+			case FrameDataBinaryLog::EColumnEncoding::Xor:
+				previous ^= value;
+				values[i++] = previous;
+				break;
+			case FrameDataBinaryLog::EColumnEncoding::RunLength:
+			{
+				uint64 run;
+				if (!ReadVarint(data, end, run) || run == 0 || i + run > static_cast<uint64>(count))
+				{
+					return false;
+				}
+				for (uint64 r = 0; r < run; r++)
+				{
+					values[i++] = value;
+				}
+				break;
+			}
+			}
+		}
+		return data == end;
+	}
+}
+
+void FrameDataBinaryLog::ToRecord(const iris::FrameData& frameData, FIrisFrameRecord& record)
+{
+	record.frame = frameData.Frame;
+	record.timeStampMs = static_cast<uint32>(frameData.TimeStampVal);
+	record.luminanceAverage = frameData.LuminanceAverage;
+	record.averageLuminanceDiff = frameData.AverageLuminanceDiff;
+	record.averageLuminanceDiffAcc = frameData.AverageLuminanceDiffAcc;
+	record.redAverage = frameData.RedAverage;
+	record.averageRedDiff = frameData.AverageRedDiff;
+	record.averageRedDiffAcc = frameData.AverageRedDiffAcc;
+	record.luminanceTransitions = frameData.LuminanceTransitions;
+	record.redTransitions = frameData.RedTransitions;
+	record.luminanceExtendedFailCount = frameData.LuminanceExtendedFailCount;
+	record.redExtendedFailCount = frameData.RedExtendedFailCount;
+	record.patternDetectedLines = frameData.patternDetectedLines;
+	record.luminanceFlashArea = static_cast<uint16>(PercentageToHundredths(frameData.LuminanceFlashArea));
+	record.redFlashArea = static_cast<uint16>(PercentageToHundredths(frameData.RedFlashArea));
+	record.patternArea = static_cast<uint16>(PercentageToHundredths(frameData.patternArea));
+	record.luminanceFrameResult = static_cast<uint8>(frameData.luminanceFrameResult);
+	record.redFrameResult = static_cast<uint8>(frameData.redFrameResult);
+	record.patternFrameResult = static_cast<uint8>(frameData.patternFrameResult);
+}
+
+void FrameDataBinaryLog::FromRecord(const FIrisFrameRecord& record, iris::FrameData& frameData)
+{
+	frameData = iris::FrameData(record.frame, record.timeStampMs);
+	frameData.LuminanceAverage = record.luminanceAverage;
+	frameData.LuminanceFlashArea = HundredthsToPercentage(record.luminanceFlashArea);
+	frameData.AverageLuminanceDiff = record.averageLuminanceDiff;
+	frameData.AverageLuminanceDiffAcc = record.averageLuminanceDiffAcc;
+	frameData.RedAverage = record.redAverage;
+	frameData.RedFlashArea = HundredthsToPercentage(record.redFlashArea);
+	frameData.AverageRedDiff = record.averageRedDiff;
+	frameData.AverageRedDiffAcc = record.averageRedDiffAcc;
+	frameData.LuminanceTransitions = record.luminanceTransitions;
+	frameData.RedTransitions = record.redTransitions;
+	frameData.LuminanceExtendedFailCount = record.luminanceExtendedFailCount;
+	frameData.RedExtendedFailCount = record.redExtendedFailCount;
+	frameData.luminanceFrameResult = static_cast<iris::FlashResult>(record.luminanceFrameResult);
+	frameData.redFrameResult = static_cast<iris::FlashResult>(record.redFrameResult);
+	frameData.patternArea = HundredthsToPercentage(record.patternArea);
+	frameData.patternDetectedLines = record.patternDetectedLines;
+	frameData.patternFrameResult = static_cast<iris::PatternResult>(record.patternFrameResult);
+}
+
+void FrameDataBinaryLog::ToColumnValues(const FIrisFrameRecord& record, uint64* values)
+{
+	values[0] = record.frame;
+	values[1] = record.timeStampMs;
+	values[2] = FloatToBits(record.luminanceAverage);
+	values[3] = record.luminanceFlashArea;
+	values[4] = FloatToBits(record.averageLuminanceDiff);
+	values[5] = FloatToBits(record.averageLuminanceDiffAcc);
+	values[6] = FloatToBits(record.redAverage);
+	values[7] = record.redFlashArea;
+	values[8] = FloatToBits(record.averageRedDiff);
+	values[9] = FloatToBits(record.averageRedDiffAcc);
+	values[10] = record.luminanceTransitions;
+	values[11] = record.redTransitions;
+	values[12] = record.luminanceExtendedFailCount;
+	values[13] = record.redExtendedFailCount;
+	values[14] = record.luminanceFrameResult;
+	values[15] = record.redFrameResult;
+	values[16] = record.patternArea;
+	values[17] = static_cast<uint32>(record.patternDetectedLines);
+	values[18] = record.patternFrameResult;
+}
+
+void FrameDataBinaryLog::FromColumnValues(const uint64* values, iris::FrameData& frameData)
+{
+	FIrisFrameRecord record;
+	record.frame = static_cast<uint32>(values[0]);
+	record.timeStampMs = static_cast<uint32>(values[1]);
+	record.luminanceAverage = BitsToFloat(values[2]);
+	record.luminanceFlashArea = static_cast<uint16>(values[3]);
+	record.averageLuminanceDiff = BitsToFloat(values[4]);
+	record.averageLuminanceDiffAcc = BitsToFloat(values[5]);
+	record.redAverage = BitsToFloat(values[6]);
+	record.redFlashArea = static_cast<uint16>(values[7]);
+	record.averageRedDiff = BitsToFloat(values[8]);
+	record.averageRedDiffAcc = BitsToFloat(values[9]);
+	record.luminanceTransitions = static_cast<uint32>(values[10]);
+	record.redTransitions = static_cast<uint32>(values[11]);
+	record.luminanceExtendedFailCount = static_cast<uint32>(values[12]);
+	record.redExtendedFailCount = static_cast<uint32>(values[13]);
+	record.luminanceFrameResult = static_cast<uint8>(values[14]);
+	record.redFrameResult = static_cast<uint8>(values[15]);
+	record.patternArea = static_cast<uint16>(values[16]);
+	record.patternDetectedLines = static_cast<int32>(static_cast<uint32>(values[17]));
+	record.patternFrameResult = static_cast<uint8>(values[18]);
+	FromRecord(record, frameData);
+}
+
+FrameDataBinaryLog::EColumnEncoding FrameDataBinaryLog::GetColumnEncoding(int32 column)
+{
+	switch (column)
+	{
+	case 0: case 1: case 3: case 7:
+		return EColumnEncoding::Delta;
+	case 2: case 4: case 5: case 6: case 8: case 9:
+		return EColumnEncoding::Xor;
+	default:
+		return EColumnEncoding::RunLength;
+	}
+}
+
+FrameDataLogWriter::~FrameDataLogWriter()
+{
+	Close();
+}
+
+bool FrameDataLogWriter::Open(const FString& path)
+{
+	Close();
+	file.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*path));
+	if (!file)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris binary log: %s could not be created"), *path);
+		return false;
+	}
+	filePath = path;
+
+	const uint32 header[2] = { FrameDataBinaryLog::Version, FrameDataBinaryLog::BlockFrames };
+	if (!Write(HeaderMagic, sizeof(HeaderMagic)) || !Write(reinterpret_cast<const uint8*>(header), sizeof(header)))
+	{
+		return false;
+	}
+	bytes = HeaderSize;
+
+	for (TArray<uint64>& column : blockValues)
+	{
+		column.SetNumUninitialized(FrameDataBinaryLog::BlockFrames);
+	}
+	blockFrames = 0;
+	index.Reset();
+	frames = 0;
+	writeSeconds = 0.0;
+	return true;
+}
+
+bool FrameDataLogWriter::Write(const uint8* data, int64 size)
+{
+	if (file && file->Write(data, size))
+	{
+		return true;
+	}
+	if (file)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris binary log: write failed, %s is closed at %lld frames and recovered from its complete blocks"), *filePath, frames);
+		file.Reset();
+	}
+	return false;
+}
+
+void FrameDataLogWriter::Append(const FIrisFrameRecord& record)
+{
+	if (!file)
+	{
+		return;
+	}
+	uint64 values[FrameDataBinaryLog::ColumnCount];
+	FrameDataBinaryLog::ToColumnValues(record, values);
+	for (int32 column = 0; column < FrameDataBinaryLog::ColumnCount; column++)
+	{
+		blockValues[column][blockFrames] = values[column];
+	}
+	frames++;
+
+	if (++blockFrames == FrameDataBinaryLog::BlockFrames)
+	{
+		WriteBlock();
+	}
+}
+
+void FrameDataLogWriter::WriteBlock()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisBinaryLogBlock);
+	const double startTime = FPlatformTime::Seconds();
+
+	FrameDataBinaryLog::FBlockIndex blockIndex;
+	blockIndex.firstTimeStampMs = blockValues[1][0];
+	blockIndex.lastTimeStampMs = blockValues[1][blockFrames - 1];
+	blockIndex.offset = bytes;
+	blockIndex.frames = blockFrames;
+
+	encoded.Reset();
+	encoded.Append(BlockMagic, sizeof(BlockMagic));
+	encoded.AddZeroed(sizeof(uint32));
+	encoded.Append(reinterpret_cast<const uint8*>(&blockFrames), sizeof(int32));
+	for (int32 column = 0; column < FrameDataBinaryLog::ColumnCount; column++)
+	{
+		//Byte size of the column, written once it is encoded
+		const int32 sizePosition = encoded.AddZeroed(sizeof(uint32));
+		EncodeColumn(FrameDataBinaryLog::GetColumnEncoding(column), blockValues[column].GetData(), blockFrames, encoded);
+		const uint32 columnSize = encoded.Num() - sizePosition - sizeof(uint32);
+		FMemory::Memcpy(&encoded[sizePosition], &columnSize, sizeof(columnSize));
+	}
+	const uint32 blockSize = encoded.Num() - BlockHeaderSize;
+	FMemory::Memcpy(&encoded[sizeof(BlockMagic)], &blockSize, sizeof(blockSize));
+	blockFrames = 0;
+	if (!Write(encoded.GetData(), encoded.Num()))
+	{
+		return;
+	}
+	index.Add(blockIndex);
+	bytes += encoded.Num();
+
+	writeSeconds += FPlatformTime::Seconds() - startTime;
+}
+
+void FrameDataLogWriter::Close()
+{
+	if (!file)
+	{
+		return;
+	}
+	if (blockFrames > 0)
+	{
+		WriteBlock();
+	}
+
+	//Time index and trailer, a log whose index is not complete is recovered by the reader
+	const int64 indexOffset = bytes;
+	for (const FrameDataBinaryLog::FBlockIndex& blockIndex : index)
+	{
+		if (!Write(reinterpret_cast<const uint8*>(&blockIndex.firstTimeStampMs), sizeof(uint64))
+			|| !Write(reinterpret_cast<const uint8*>(&blockIndex.lastTimeStampMs), sizeof(uint64))
+			|| !Write(reinterpret_cast<const uint8*>(&blockIndex.offset), sizeof(int64))
+			|| !Write(reinterpret_cast<const uint8*>(&blockIndex.frames), sizeof(int32)))
+		{
+			return;
+		}
+	}
+	const uint32 blockCount = index.Num();
+	if (!Write(reinterpret_cast<const uint8*>(&indexOffset), sizeof(indexOffset)) || !Write(reinterpret_cast<const uint8*>(&blockCount), sizeof(blockCount))
+		|| !Write(IndexMagic, sizeof(IndexMagic)))
+	{
+		return;
+	}
+	bytes += index.Num() * IndexEntrySize + TrailerSize;
+	if (!file->Flush())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris binary log: %s could not be flushed"), *filePath);
+	}
+	file.Reset();
+
+	if (frames > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Iris binary log: %lld frames, %.1f KB (%.1f bytes per frame), encoded and written at %.1f MB/s to %s"),
+			frames, bytes / 1024.0, static_cast<double>(bytes) / frames, writeSeconds > 0.0 ? bytes / (writeSeconds * 1024.0 * 1024.0) : 0.0, *filePath);
+	}
+}
+
+FrameDataLogReader::~FrameDataLogReader()
+{
+	Close();
+}
+
+bool FrameDataLogReader::Open(const FString& path)
+{
+	Close();
+	file.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*path));
+	if (!file)
+	{
+		return false;
+	}
+	fileSize = file->Size();
+
+	uint8 magic[4];
+	uint32 header[2];
+	if (fileSize < HeaderSize || !file->Read(magic, sizeof(magic)) || FMemory::Memcmp(magic, HeaderMagic, sizeof(magic)) != 0
+		|| !file->Read(reinterpret_cast<uint8*>(header), sizeof(header)) || header[0] != FrameDataBinaryLog::Version)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris binary log: %s is not a version %u log"), *path, FrameDataBinaryLog::Version);
+		Close();
+		return false;
+	}
+
+	if (!ReadIndex() && !RecoverIndex())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris binary log: %s has no time index and no complete block"), *path);
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool FrameDataLogReader::ReadIndex()
+{
+	int64 indexOffset = 0;
+	uint32 blockCount = 0;
+	uint8 magic[4];
+	if (!file->Seek(fileSize - TrailerSize) || !file->Read(reinterpret_cast<uint8*>(&indexOffset), sizeof(indexOffset))
+		|| !file->Read(reinterpret_cast<uint8*>(&blockCount), sizeof(blockCount)) || !file->Read(magic, sizeof(magic))
+		|| FMemory::Memcmp(magic, IndexMagic, sizeof(magic)) != 0 || indexOffset < HeaderSize
+		|| indexOffset + static_cast<int64>(blockCount) * IndexEntrySize + TrailerSize != fileSize || !file->Seek(indexOffset))
+	{
+		return false;
+	}
+
+	//Blocks in file order, each one at least a block header long
+	index.SetNum(blockCount);
+	int64 minOffset = HeaderSize;
+	for (FrameDataBinaryLog::FBlockIndex& blockIndex : index)
+	{
+		if (!file->Read(reinterpret_cast<uint8*>(&blockIndex.firstTimeStampMs), sizeof(uint64))
+			|| !file->Read(reinterpret_cast<uint8*>(&blockIndex.lastTimeStampMs), sizeof(uint64))
+			|| !file->Read(reinterpret_cast<uint8*>(&blockIndex.offset), sizeof(int64))
+			|| !file->Read(reinterpret_cast<uint8*>(&blockIndex.frames), sizeof(int32))
+			|| blockIndex.offset < minOffset || blockIndex.offset + BlockHeaderSize > indexOffset
+			|| blockIndex.frames <= 0 || blockIndex.frames > FrameDataBinaryLog::BlockFrames)
+		{
+			index.Reset();
+			return false;
+		}
+		minOffset = blockIndex.offset + BlockHeaderSize;
+	}
+	indexEnd = indexOffset;
+	return true;
+}
+
+bool FrameDataLogReader::RecoverIndex()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisBinaryLogRecovery);
+
+	//Blocks are read in order until the end of the file or the first incomplete one (write interrupted by a crash)
+	index.Reset();
+	int64 offset = HeaderSize;
+	int64 blockSize = 0;
+	int32 frames = 0;
+	while (DecodeBlock(offset, fileSize - offset, blockSize, frames))
+	{
+		FrameDataBinaryLog::FBlockIndex& blockIndex = index.AddDefaulted_GetRef();
+		blockIndex.firstTimeStampMs = blockValues[1][0];
+		blockIndex.lastTimeStampMs = blockValues[1][frames - 1];
+		blockIndex.offset = offset;
+		blockIndex.frames = frames;
+		offset += blockSize;
+	}
+	indexEnd = offset;
+
+	UE_LOG(LogTemp, Warning, TEXT("Iris binary log: no time index (session not closed), %d blocks recovered by a forward scan, %lld bytes after the last complete block"),
+		index.Num(), fileSize - offset);
+	return !index.IsEmpty();
+}
+
+void FrameDataLogReader::Close()
+{
+	file.Reset();
+	fileSize = 0;
+	indexEnd = 0;
+	index.Reset();
+}
+
+int32 FrameDataLogReader::FindBlock(uint64 timeStampMs) const
+{
+	//First block whose last time stamp is not before the searched one
+	const int32 block = Algo::LowerBound(index, timeStampMs, [](const FrameDataBinaryLog::FBlockIndex& blockIndex, uint64 value) { return blockIndex.lastTimeStampMs < value; });
+	return block < index.Num() ? block : INDEX_NONE;
+}
+
+bool FrameDataLogReader::ReadBlock(int32 block, TArray<iris::FrameData>& outFrames)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisBinaryLogRead);
+	if (!file || !index.IsValidIndex(block))
+	{
+		return false;
+	}
+
+	const FrameDataBinaryLog::FBlockIndex& blockIndex = index[block];
+	const int64 blockEnd = index.IsValidIndex(block + 1) ? index[block + 1].offset : indexEnd;
+	int64 blockSize = 0;
+	int32 frames = 0;
+	if (!DecodeBlock(blockIndex.offset, blockEnd - blockIndex.offset, blockSize, frames) || frames != blockIndex.frames)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris binary log: block %d is corrupted"), block);
+		return false;
+	}
+
+	uint64 values[FrameDataBinaryLog::ColumnCount];
+	for (int32 frame = 0; frame < frames; frame++)
+	{
+		for (int32 column = 0; column < FrameDataBinaryLog::ColumnCount; column++)
+		{
+			values[column] = blockValues[column][frame];
+		}
+		FrameDataBinaryLog::FromColumnValues(values, outFrames.AddDefaulted_GetRef());
+	}
+	return true;
+}
+
+bool FrameDataLogReader::DecodeBlock(int64 offset, int64 maxSize, int64& outBlockSize, int32& outFrames)
+{
+	//Block header, then the rest of the block in one read
+	uint8 header[BlockHeaderSize];
+	uint32 size = 0;
+	if (maxSize < BlockHeaderSize + static_cast<int64>(sizeof(int32)) || !file->Seek(offset) || !file->Read(header, BlockHeaderSize)
+		|| FMemory::Memcmp(header, BlockMagic, sizeof(BlockMagic)) != 0)
+	{
+		return false;
+	}
+	FMemory::Memcpy(&size, header + sizeof(BlockMagic), sizeof(size));
+	if (size < sizeof(int32) || BlockHeaderSize + size > maxSize)
+	{
+		return false;
+	}
+	encoded.SetNumUninitialized(size);
+	if (!file->Read(encoded.GetData(), size))
+	{
+		return false;
+	}
+
+	const uint8* data = encoded.GetData();
+	const uint8* end = data + encoded.Num();
+	int32 frames = 0;
+	FMemory::Memcpy(&frames, data, sizeof(frames));
+	data += sizeof(frames);
+	if (frames <= 0 || frames > FrameDataBinaryLog::BlockFrames)
+	{
+		return false;
+	}
+	for (int32 column = 0; column < FrameDataBinaryLog::ColumnCount; column++)
+	{
+		uint32 columnSize = 0;
+		if (data + sizeof(columnSize) > end)
+		{
+			return false;
+		}
+		FMemory::Memcpy(&columnSize, data, sizeof(columnSize));
+		data += sizeof(columnSize);
+		blockValues[column].SetNumUninitialized(frames);
+		if (columnSize > static_cast<uint64>(end - data) || !DecodeColumn(FrameDataBinaryLog::GetColumnEncoding(column), data, data + columnSize, frames, blockValues[column].GetData()))
+		{
+			return false;
+		}
+		data += columnSize;
+	}
+	if (data != end)
+	{
+		return false;
+	}
+	outBlockSize = BlockHeaderSize + size;
+	outFrames = frames;
+	return true;
+}
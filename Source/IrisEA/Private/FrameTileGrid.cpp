@@ -0,0 +1,493 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "FrameTileGrid.h"
+#include "HalfFloatConversion.h"
+#include "Hash/xxhash.h"
+#include "HAL/PlatformTime.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ConfigurationSnapshot.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "iris/Configuration.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+	//Same conversion as the IRIS RelativeLuminance / CDLuminance and RedSaturation flash values, on sRGB linearized values
+	template<EIrisLuminanceModel Model>
+	FORCEINLINE void ConvertPixel(const uint8* bgr, const float* sRgbTable, const float* cdLuminanceTable, float& luminance, float& red)
+	{
+		const float b = sRgbTable[bgr[0]];
+		const float g = sRgbTable[bgr[1]];
+		const float r = sRgbTable[bgr[2]];
+
+		if constexpr (Model == EIrisLuminanceModel::Relative)
+		{
+			//Y = 0.0722 * B + 0.7152 * G + 0.2126 * R
+			luminance = 0.0722f * b + 0.7152f * g + 0.2126f * r;
+		}
+		else
+		{
+			//8 bit gray with the cv::COLOR_BGR2GRAY fixed point weights, then its cd/m2 value
+			luminance = cdLuminanceTable[(bgr[0] * 1868 + bgr[1] * 9617 + bgr[2] * 4899 + (1 << 13)) >> 14];
+		}
+
+		//if R / (R + G + B) >= 0.8 => pixel is saturated red, (R - G - B) * 320 is the value to check for transitions
+		const float sum = r + g + b;
+		const float redValue = (r - g - b) * 320.f;
+		red = (sum > 0.f && r >= 0.8f * sum && redValue > 0.f) ? redValue : 0.f;
+	}
+
+	template<EIrisLuminanceModel Model>
+	constexpr float GetModelScale()
+	{
+		return Model == EIrisLuminanceModel::CD ? FrameTileGrid::CdLuminanceScale : FrameTileGrid::LuminanceScale;
+	}
+
+	//Converts a row of BGR (3 channels) or BGRA (4 channels, read in place from the readback buffer) pixels
+	template<EIrisLuminanceModel Model, int32 Channels>
+	FORCEINLINE void ConvertRow(const uint8* bgr, int32 pixels, const float* sRgbTable, const float* cdLuminanceTable,
+		FrameTileGrid::PlaneValue* luminanceRow, FrameTileGrid::PlaneValue* redRow)
+	{
+		for (int32 col = 0; col < pixels; col++, bgr += Channels)
+		{
+			float luminanceValue, redValue;
+			ConvertPixel<Model>(bgr, sRgbTable, cdLuminanceTable, luminanceValue, redValue);
+			luminanceRow[col] = FrameTileGrid::EncodePlaneValue(luminanceValue, GetModelScale<Model>());
+			redRow[col] = FrameTileGrid::EncodePlaneValue(redValue, FrameTileGrid::RedScale);
+		}
+	}
+
+	//Conversion before the luminance model specialisation, the benchmark reference: rows templated on the channel count
+	//only, relative luminance whatever the session model
+	template<int32 Channels>
+	void ConvertRows(const cv::Mat& region, const float* sRgbTable, cv::Mat& luminance, cv::Mat& red)
+	{
+		for (int32 row = 0; row < region.rows; row++)
+		{
+			const uint8* bgr = region.ptr<uint8>(row);
+			FrameTileGrid::PlaneValue* luminanceRow = luminance.ptr<FrameTileGrid::PlaneValue>(row);
+			FrameTileGrid::PlaneValue* redRow = red.ptr<FrameTileGrid::PlaneValue>(row);
+
+			for (int32 col = 0; col < region.cols; col++, bgr += Channels)
+			{
+				float luminanceValue, redValue;
+				ConvertPixel<EIrisLuminanceModel::Relative>(bgr, sRgbTable, nullptr, luminanceValue, redValue);
+				luminanceRow[col] = FrameTileGrid::EncodePlaneValue(luminanceValue, FrameTileGrid::LuminanceScale);
+				redRow[col] = FrameTileGrid::EncodePlaneValue(redValue, FrameTileGrid::RedScale);
+			}
+		}
+	}
+
+	void ConvertRegionPrevious(const cv::Mat& region, const float* sRgbTable, const FIrisDisplayTransform& transform, cv::Mat& luminance, cv::Mat& red)
+	{
+		if (region.depth() == CV_16F)
+		{
+			//Linear values, no sRGB decode
+			for (int32 row = 0; row < region.rows; row++)
+			{
+				HalfFloatConversion::ConvertRow(region.ptr<FFloat16>(row), region.cols, transform,
+					luminance.ptr<FrameTileGrid::PlaneValue>(row), red.ptr<FrameTileGrid::PlaneValue>(row));
+			}
+		}
+		else if (region.channels() == 4)
+		{
+			ConvertRows<4>(region, sRgbTable, luminance, red);
+		}
+		else
+		{
+			ConvertRows<3>(region, sRgbTable, luminance, red);
+		}
+	}
+}
+
+template<EIrisLuminanceModel Model, FrameTileGrid::EInputFormat Input>
+void FrameTileGrid::ConvertRegionTyped(const FrameTileGrid& grid, const cv::Mat& region, cv::Mat& luminance, cv::Mat& red)
+{
+	//Rows of the CD half float regions, encoded to 8 bit first
+	TArray<uint8, TInlineAllocator<1024>> bgrRow;
+	if constexpr (Input == EInputFormat::RGBA16F && Model == EIrisLuminanceModel::CD)
+	{
+		bgrRow.SetNumUninitialized(region.cols * 3);
+	}
+
+	for (int32 row = 0; row < region.rows; row++)
+	{
+		PlaneValue* luminanceRow = luminance.ptr<PlaneValue>(row);
+		PlaneValue* redRow = red.ptr<PlaneValue>(row);
+
+		if constexpr (Input == EInputFormat::RGBA16F && Model == EIrisLuminanceModel::Relative)
+		{
+			//Linear values, no sRGB decode
+			HalfFloatConversion::ConvertRow(region.ptr<FFloat16>(row), region.cols, grid.displayTransform, luminanceRow, redRow);
+		}
+		else if constexpr (Input == EInputFormat::RGBA16F)
+		{
+			HalfFloatConversion::EncodeRowBGR(region.ptr<FFloat16>(row), region.cols, grid.displayTransform, bgrRow.GetData());
+			ConvertRow<Model, 3>(bgrRow.GetData(), region.cols, grid.sRgbTable, grid.cdLuminanceTable, luminanceRow, redRow);
+		}
+		else
+		{
+			ConvertRow<Model, Input == EInputFormat::BGRA8 ? 4 : 3>(region.ptr<uint8>(row), region.cols, grid.sRgbTable, grid.cdLuminanceTable, luminanceRow, redRow);
+		}
+	}
+}
+
+const FrameTileGrid::ConvertRegionFunction FrameTileGrid::RelativeConversions[] =
+{
+	&FrameTileGrid::ConvertRegionTyped<EIrisLuminanceModel::Relative, EInputFormat::BGR8>,
+	&FrameTileGrid::ConvertRegionTyped<EIrisLuminanceModel::Relative, EInputFormat::BGRA8>,
+	&FrameTileGrid::ConvertRegionTyped<EIrisLuminanceModel::Relative, EInputFormat::RGBA16F>
+};
+
+const FrameTileGrid::ConvertRegionFunction FrameTileGrid::CdConversions[] =
+{
+	&FrameTileGrid::ConvertRegionTyped<EIrisLuminanceModel::CD, EInputFormat::BGR8>,
+	&FrameTileGrid::ConvertRegionTyped<EIrisLuminanceModel::CD, EInputFormat::BGRA8>,
+	&FrameTileGrid::ConvertRegionTyped<EIrisLuminanceModel::CD, EInputFormat::RGBA16F>
+};
+
+FrameTileGrid::EInputFormat FrameTileGrid::GetInputFormat(const cv::Mat& frame)
+{
+	if (frame.depth() == CV_16F)
+	{
+		return EInputFormat::RGBA16F;
+	}
+	return frame.channels() == 4 ? EInputFormat::BGRA8 : EInputFormat::BGR8;
+}
+
+void FrameTileGrid::ComputeTileSignatures(const cv::Mat& frame, TArray<uint64>& outSignatures)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisTileSignatures);
+
+	outSignatures.SetNumUninitialized(TileCount);
+	for (int32 tile = 0; tile < TileCount; tile++)
+	{
+		const cv::Rect rect = GetTileRect(frame.size(), tile);
+		const size_t rowSize = rect.width * frame.elemSize();
+
+		FXxHash64Builder builder;
+		for (int32 row = rect.y; row < rect.y + rect.height; row++)
+		{
+			builder.Update(frame.ptr(row) + rect.x * frame.elemSize(), rowSize);
+		}
+		outSignatures[tile] = builder.Finalize().Hash;
+	}
+}
+
+cv::Rect FrameTileGrid::GetTileRect(const cv::Size& frameSize, int32 tile)
+{
+	const int32 tileX = tile % TilesX;
+	const int32 tileY = tile / TilesX;
+	const int32 x0 = frameSize.width * tileX / TilesX;
+	const int32 x1 = frameSize.width * (tileX + 1) / TilesX;
+	const int32 y0 = frameSize.height * tileY / TilesY;
+	const int32 y1 = frameSize.height * (tileY + 1) / TilesY;
+	return cv::Rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+void FrameTileGrid::Initialize(const FIrisConfigurationSnapshot& settings)
+{
+	FMemory::Memcpy(sRgbTable, settings.sRgbValues, sizeof(sRgbTable));
+	FMemory::Memcpy(cdLuminanceTable, settings.cdLuminanceValues, sizeof(cdLuminanceTable));
+	luminanceModel = settings.luminanceType == static_cast<uint8>(iris::Configuration::LuminanceType::LT_CD) ? EIrisLuminanceModel::CD : EIrisLuminanceModel::Relative;
+	conversions = luminanceModel == EIrisLuminanceModel::CD ? CdConversions : RelativeConversions;
+	luminanceThreshold = settings.luminanceFlashThreshold;
+	redThreshold = settings.redFlashThreshold;
+	Reset();
+}
+
+void FrameTileGrid::Update(const cv::Mat& bgrFrame, const TArray<uint64>& tileSignatures, const FConvertedTiles* convertedTiles)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisTileGridUpdate);
+	const double startTime = FPlatformTime::Seconds();
+
+	const bool bFirstFrame = !bHasFrame || luminancePlane.size() != bgrFrame.size();
+	if (bFirstFrame)
+	{
+		//First frame has 0 variation, every tile is converted. The planes of the last session are reused at the same size
+		luminancePlane.create(bgrFrame.size(), PlaneType);
+		redPlane.create(bgrFrame.size(), PlaneType);
+		luminancePlane.setTo(0);
+		redPlane.setTo(0);
+		bHasFrame = true;
+		tileStats.SetNum(TileCount);
+		lastSignatures = tileSignatures;
+	}
+
+	frameStats.dirtyTiles = 0;
+	for (int32 tile = 0; tile < TileCount; tile++)
+	{
+		FTileStats& stats = tileStats[tile];
+		stats.bDirty = bFirstFrame || tileSignatures[tile] != lastSignatures[tile];
+		if (!stats.bDirty)
+		{
+			//Unchanged content, cached sums are still valid and there is no variation
+			stats.luminanceDiffSum = 0.0;
+			stats.redDiffSum = 0.0;
+			stats.luminanceOverThreshold = 0;
+			stats.redOverThreshold = 0;
+			continue;
+		}
+
+		UpdateTile(bgrFrame, tile, convertedTiles);
+		if (bFirstFrame)
+		{
+			stats.luminanceDiffSum = 0.0;
+			stats.redDiffSum = 0.0;
+			stats.luminanceOverThreshold = 0;
+			stats.redOverThreshold = 0;
+		}
+		frameStats.dirtyTiles++;
+	}
+	lastSignatures = tileSignatures;
+	AssembleFrameStats();
+
+	incrementalSeconds += FPlatformTime::Seconds() - startTime;
+	dirtyTilesTotal += frameStats.dirtyTiles;
+	updates++;
+
+#if !UE_BUILD_SHIPPING
+	if (updates % validationInterval == 0)
+	{
+		ValidateAgainstFullFrame(bgrFrame);
+	}
+#endif
+}
+
+void FrameTileGrid::UpdateTile(const cv::Mat& bgrFrame, int32 tile, const FConvertedTiles* convertedTiles)
+{
+	const cv::Rect rect = GetTileRect(bgrFrame.size(), tile);
+	FTileStats& stats = tileStats[tile];
+
+	cv::Mat luminance, red;
+	if (convertedTiles != nullptr && convertedTiles->tiles.IsValidIndex(tile) && convertedTiles->tiles[tile])
+	{
+		luminance = convertedTiles->luminance(rect);
+		red = convertedTiles->red(rect);
+	}
+	else
+	{
+		ConvertRegion(bgrFrame(rect), tileLuminance, tileRed);
+		luminance = tileLuminance;
+		red = tileRed;
+	}
+	cv::Mat lastLuminance = luminancePlane(rect);
+	cv::Mat lastRed = redPlane(rect);
+
+	//Sum of the variation is the difference of the tile sums
+	const double luminanceSum = cv::sum(luminance)[0] / GetLuminanceScale();
+	const double redSum = cv::sum(red)[0] / RedScale;
+	stats.luminanceDiffSum = luminanceSum - stats.luminanceSum;
+	stats.redDiffSum = redSum - stats.redSum;
+
+	//Vectorized |frame(n) - frame(n-1)| >= threshold counts
+	cv::absdiff(luminance, lastLuminance, tileDiff);
+	cv::compare(tileDiff, luminanceThreshold * GetLuminanceScale(), tileMask, cv::CMP_GE);
+	stats.luminanceOverThreshold = cv::countNonZero(tileMask);
+	cv::absdiff(red, lastRed, tileDiff);
+	cv::compare(tileDiff, redThreshold * RedScale, tileMask, cv::CMP_GE);
+	stats.redOverThreshold = cv::countNonZero(tileMask);
+
+	luminance.copyTo(lastLuminance);
+	red.copyTo(lastRed);
+	stats.luminanceSum = luminanceSum;
+	stats.redSum = redSum;
+	stats.pixels = rect.area();
+}
+
+void FrameTileGrid::ConvertTiles(const cv::Mat& frame, const TArray<uint64>& tileSignatures, const TArray<uint64>* referenceSignatures, FConvertedTiles& outTiles) const
+{
+	outTiles.luminance.create(frame.size(), PlaneType);
+	outTiles.red.create(frame.size(), PlaneType);
+	outTiles.tiles.Init(false, TileCount);
+
+	const bool bReference = referenceSignatures != nullptr && referenceSignatures->Num() == TileCount && tileSignatures.Num() == TileCount;
+	for (int32 tile = 0; tile < TileCount; tile++)
+	{
+		if (bReference && tileSignatures[tile] == (*referenceSignatures)[tile])
+		{
+			continue;
+		}
+		const cv::Rect rect = GetTileRect(frame.size(), tile);
+		cv::Mat luminance = outTiles.luminance(rect);
+		cv::Mat red = outTiles.red(rect);
+		conversions[static_cast<int32>(GetInputFormat(frame))](*this, frame(rect), luminance, red);
+		outTiles.tiles[tile] = true;
+	}
+}
+
+void FrameTileGrid::ConvertRegion(const cv::Mat& bgrRegion, cv::Mat& luminance, cv::Mat& red) const
+{
+	luminance.create(bgrRegion.size(), PlaneType);
+	red.create(bgrRegion.size(), PlaneType);
+
+	conversions[static_cast<int32>(GetInputFormat(bgrRegion))](*this, bgrRegion, luminance, red);
+}
+
+void FrameTileGrid::ConvertRelativeLuminance(const cv::Mat& frame, cv::Mat& outLuminance)
+{
+	outLuminance.create(frame.size(), PlaneType);
+	relativeRedScratch.create(frame.size(), PlaneType);
+	RelativeConversions[static_cast<int32>(GetInputFormat(frame))](*this, frame, outLuminance, relativeRedScratch);
+}
+
+void FrameTileGrid::AssembleFrameStats()
+{
+	double luminanceSum = 0.0, redSum = 0.0, luminanceDiffSum = 0.0, redDiffSum = 0.0;
+	int64 luminanceOver = 0, redOver = 0, pixels = 0;
+
+	for (const FTileStats& stats : tileStats)
+	{
+		luminanceSum += stats.luminanceSum;
+		redSum += stats.redSum;
+		luminanceDiffSum += stats.luminanceDiffSum;
+		redDiffSum += stats.redDiffSum;
+		luminanceOver += stats.luminanceOverThreshold;
+		redOver += stats.redOverThreshold;
+		pixels += stats.pixels;
+	}
+
+	if (pixels == 0)
+	{
+		return;
+	}
+	frameStats.luminanceAverage = luminanceSum / pixels;
+	frameStats.redAverage = redSum / pixels;
+	frameStats.averageLuminanceDiff = luminanceDiffSum / pixels;
+	frameStats.averageRedDiff = redDiffSum / pixels;
+	frameStats.luminanceFlashArea = static_cast<double>(luminanceOver) / pixels;
+	frameStats.redFlashArea = static_cast<double>(redOver) / pixels;
+}
+
+void FrameTileGrid::ValidateAgainstFullFrame(const cv::Mat& bgrFrame)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisTileGridValidation);
+	const double startTime = FPlatformTime::Seconds();
+
+	cv::Mat fullLuminance, fullRed;
+	ConvertRegion(bgrFrame, fullLuminance, fullRed);
+	const double luminanceAverage = cv::sum(fullLuminance)[0] / GetLuminanceScale() / bgrFrame.total();
+
+	fullFrameSeconds += FPlatformTime::Seconds() - startTime;
+	fullFrameRuns++;
+
+	ensureMsgf(cv::norm(fullLuminance, luminancePlane, cv::NORM_INF) == 0.0 && cv::norm(fullRed, redPlane, cv::NORM_INF) == 0.0,
+		TEXT("Iris tile grid planes differ from the whole frame conversion"));
+	ensureMsgf(FMath::IsNearlyEqual(luminanceAverage, static_cast<double>(frameStats.luminanceAverage), 1e-5),
+		TEXT("Iris tile grid luminance average differs from the whole frame conversion"));
+}
+
+void FrameTileGrid::Reset()
+{
+	if (updates > 0 && fullFrameRuns > 0)
+	{
+		const double incrementalMs = incrementalSeconds * 1000.0 / updates;
+		const double fullFrameMs = fullFrameSeconds * 1000.0 / fullFrameRuns;
+		UE_LOG(LogTemp, Log, TEXT("Iris tile grid: %.1f%% dirty tiles, %.3f ms per frame (whole frame conversion %.3f ms, x%.1f)"),
+			100.0 * dirtyTilesTotal / (static_cast<double>(updates) * TileCount), incrementalMs, fullFrameMs, incrementalMs > 0.0 ? fullFrameMs / incrementalMs : 0.0);
+	}
+
+	//The planes and scratch buffers are kept for the next session
+	bHasFrame = false;
+	lastSignatures.Reset();
+	tileStats.Reset();
+	frameStats = FFrameTileStats();
+	updates = 0;
+	dirtyTilesTotal = 0;
+	incrementalSeconds = 0.0;
+	fullFrameSeconds = 0.0;
+	fullFrameRuns = 0;
+}
+
+void FrameTileGrid::BenchmarkConversion(const FIrisConfigurationSnapshot& settings, const FIrisDisplayTransform& transform, const cv::Size& frameSize, int32 iterations, double baselineFrameMs)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisBenchmarkConversion);
+
+	//Synthetic content with every channel value, the half float frame goes a bit over 1 to exercise the display transform
+	cv::Mat bgrFrame(frameSize, CV_8UC3);
+	cv::randu(bgrFrame, cv::Scalar::all(0), cv::Scalar::all(256));
+	cv::Mat bgraFrame;
+	cv::cvtColor(bgrFrame, bgraFrame, cv::COLOR_BGR2BGRA);
+	cv::Mat halfFrame;
+	bgraFrame.convertTo(halfFrame, CV_32FC4, 1.5 / 255.0);
+	halfFrame.convertTo(halfFrame, CV_16FC4);
+
+	struct FBenchmarkInput
+	{
+		const TCHAR* name;
+		const cv::Mat* frame;
+	};
+	const FBenchmarkInput inputs[] = { { TEXT("BGR8"), &bgrFrame }, { TEXT("BGRA8"), &bgraFrame }, { TEXT("RGBA16F"), &halfFrame } };
+
+	FrameTileGrid grid;
+	grid.Initialize(settings);
+	grid.SetDisplayTransform(transform);
+	cv::Mat luminance(frameSize, PlaneType), red(frameSize, PlaneType);
+	iterations = FMath::Max(iterations, 1);
+
+	for (const EIrisLuminanceModel model : { EIrisLuminanceModel::Relative, EIrisLuminanceModel::CD })
+	{
+		grid.luminanceModel = model;
+		grid.conversions = model == EIrisLuminanceModel::CD ? CdConversions : RelativeConversions;
+
+		for (const FBenchmarkInput& input : inputs)
+		{
+			double startTime = FPlatformTime::Seconds();
+			for (int32 i = 0; i < iterations; i++)
+			{
+				grid.ConvertRegion(*input.frame, luminance, red);
+			}
+			const double specialisedMs = (FPlatformTime::Seconds() - startTime) * 1000.0 / iterations;
+
+			startTime = FPlatformTime::Seconds();
+			for (int32 i = 0; i < iterations; i++)
+			{
+				ConvertRegionPrevious(*input.frame, grid.sRgbTable, transform, luminance, red);
+			}
+			const double previousMs = (FPlatformTime::Seconds() - startTime) * 1000.0 / iterations;
+
+			UE_LOG(LogTemp, Log, TEXT("Iris conversion benchmark %dx%d %s %s: %.3f ms specialised, %.3f ms previous ConvertRows%s (x%.2f)"),
+				frameSize.width, frameSize.height, model == EIrisLuminanceModel::CD ? TEXT("CD") : TEXT("Relative"), input.name,
+				specialisedMs, previousMs, model == EIrisLuminanceModel::CD ? TEXT(" with relative luminance") : TEXT(""),
+				specialisedMs > 0.0 ? previousMs / specialisedMs : 0.0);
+		}
+	}
+
+	if (baselineFrameMs <= 0.0)
+	{
+		return;
+	}
+
+	//Cost the grid adds to a frame on top of the IRIS analysis, whole frame (every tile changed) and a quarter of the tiles changed
+	//The tiles are marked changed through their signatures, the conversion cost does not depend on the content
+	grid.Initialize(settings);
+	TArray<uint64> signatures, changedSignatures, partialSignatures;
+	ComputeTileSignatures(bgraFrame, signatures);
+	changedSignatures = signatures;
+	partialSignatures = signatures;
+	for (int32 tile = 0; tile < TileCount; tile++)
+	{
+		changedSignatures[tile] = signatures[tile] + 1;
+		if (tile % 4 == 0)
+		{
+			partialSignatures[tile] = signatures[tile] + 1;
+		}
+	}
+
+	double wholeFrameMs = 0.0, partialFrameMs = 0.0;
+	for (int32 i = 0; i < iterations; i++)
+	{
+		grid.Update(bgraFrame, signatures);
+		double startTime = FPlatformTime::Seconds();
+		grid.Update(bgraFrame, changedSignatures);
+		wholeFrameMs += (FPlatformTime::Seconds() - startTime) * 1000.0;
+		startTime = FPlatformTime::Seconds();
+		grid.Update(bgraFrame, partialSignatures);
+		partialFrameMs += (FPlatformTime::Seconds() - startTime) * 1000.0;
+	}
+	wholeFrameMs /= iterations;
+	partialFrameMs /= iterations;
+	UE_LOG(LogTemp, Log, TEXT("Iris tile grid update %dx%d BGRA8: %.3f ms every tile changed (%.1f%% of the %.3f ms IRIS frame analysis), %.3f ms a quarter changed (%.1f%%)"),
+		frameSize.width, frameSize.height, wholeFrameMs, 100.0 * wholeFrameMs / baselineFrameMs, baselineFrameMs, partialFrameMs, 100.0 * partialFrameMs / baselineFrameMs);
+}
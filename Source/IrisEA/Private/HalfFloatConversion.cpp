@@ -0,0 +1,306 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "HalfFloatConversion.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+#if PLATFORM_WINDOWS && PLATFORM_CPU_X86_FAMILY
+#define IRIS_HALF_FLOAT_SIMD 1
+#include <immintrin.h>
+#if defined(__clang__)
+#define IRIS_SIMD_TARGET __attribute__((target("avx2,f16c")))
+#else
+#define IRIS_SIMD_TARGET
+#endif
+#else
+#define IRIS_HALF_FLOAT_SIMD 0
+#endif
+
+namespace
+{
+	//Keeps the tone mapping finite for infinite inputs
+	constexpr float MaxLinearValue = 1e6f;
+
+	//Linear [0, 1] to 8 bit sRGB, fine enough for the dark values where the sRGB curve is steep
+	constexpr int32 EncodeTableSize = 16384;
+
+	const uint8* GetSrgbEncodeTable()
+	{
+		//Padded so the SIMD kernel can gather 4 bytes from the last entry
+		static const TArray<uint8> table = []()
+			{
+				TArray<uint8> values;
+				values.SetNumZeroed(EncodeTableSize + 3);
+				for (int32 i = 0; i < EncodeTableSize; i++)
+				{
+					const float linear = static_cast<float>(i) / (EncodeTableSize - 1);
+					const float encoded = linear <= 0.0031308f ? 12.92f * linear : 1.055f * FMath::Pow(linear, 1.f / 2.4f) - 0.055f;
+					values[i] = static_cast<uint8>(FMath::Clamp(FMath::RoundToInt(encoded * 255.f), 0, 255));
+				}
+				return values;
+			}();
+		return table.GetData();
+	}
+
+	float GetInverseWhitePoint2(const FIrisDisplayTransform& transform)
+	{
+		const float whitePoint = FMath::Max(transform.whitePoint, 1e-3f);
+		return 1.f / (whitePoint * whitePoint);
+	}
+
+	FORCEINLINE float TransformValue(float value, float exposure, bool bReinhard, float inverseWhitePoint2)
+	{
+		//Same operations as the SIMD kernel: NaN and negative values become 0
+		float v = FMath::Max(value * exposure, 0.f);
+		v = FMath::Min(v, MaxLinearValue);
+		if (bReinhard)
+		{
+			v = v * (1.f + v * inverseWhitePoint2) / (1.f + v);
+		}
+		return FMath::Min(v, 1.f);
+	}
+
+	//Same conversion as the IRIS RelativeLuminance and RedSaturation flash values, on linear values
+	FORCEINLINE void ConvertLinearPixel(float r, float g, float b, float& luminance, float& red)
+	{
+		luminance = 0.0722f * b + 0.7152f * g + 0.2126f * r;
+
+		const float sum = r + g + b;
+		const float redValue = (r - g - b) * 320.f;
+		red = (sum > 0.f && r >= 0.8f * sum && redValue > 0.f) ? redValue : 0.f;
+	}
+
+#if IRIS_HALF_FLOAT_SIMD
+	IRIS_SIMD_TARGET FORCEINLINE __m256 TransformValues(__m256 v, __m256 exposure, bool bReinhard, __m256 inverseWhitePoint2)
+	{
+		const __m256 one = _mm256_set1_ps(1.f);
+		//max returns its second operand when the first one is NaN
+		v = _mm256_max_ps(_mm256_mul_ps(v, exposure), _mm256_setzero_ps());
+		v = _mm256_min_ps(v, _mm256_set1_ps(MaxLinearValue));
+		if (bReinhard)
+		{
+			v = _mm256_div_ps(_mm256_mul_ps(v, _mm256_add_ps(one, _mm256_mul_ps(v, inverseWhitePoint2))), _mm256_add_ps(one, v));
+		}
+		return _mm256_min_ps(v, one);
+	}
+
+	IRIS_SIMD_TARGET FORCEINLINE void StorePlaneValues(__m256 values, float scale, FrameTileGrid::PlaneValue* plane)
+	{
+#if IRIS_FIXED_POINT_PLANES
+		values = _mm256_add_ps(_mm256_min_ps(_mm256_mul_ps(values, _mm256_set1_ps(scale)), _mm256_set1_ps(65535.f)), _mm256_set1_ps(0.5f));
+		const __m256i integers = _mm256_cvttps_epi32(values);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(plane), _mm_packus_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1)));
+#else
+		_mm256_storeu_ps(plane, values);
+#endif
+	}
+
+	IRIS_SIMD_TARGET void ConvertRowAVX2(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform,
+		FrameTileGrid::PlaneValue* luminance, FrameTileGrid::PlaneValue* red)
+	{
+		const bool bReinhard = transform.toneMapping == EIrisToneMapping::Reinhard;
+		const __m256 exposure = _mm256_set1_ps(transform.exposure);
+		const __m256 inverseWhitePoint2 = _mm256_set1_ps(GetInverseWhitePoint2(transform));
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256i pixelOrder = _mm256_setr_epi32(0, 4, 2, 6, 1, 5, 3, 7);
+
+		int32 x = 0;
+		for (; x + 8 <= pixels; x += 8)
+		{
+			//2 pixels per register: r0 g0 b0 a0 | r1 g1 b1 a1
+			const __m128i* src = reinterpret_cast<const __m128i*>(rgba + x * 4);
+			const __m256 p01 = _mm256_cvtph_ps(_mm_loadu_si128(src));
+			const __m256 p23 = _mm256_cvtph_ps(_mm_loadu_si128(src + 1));
+			const __m256 p45 = _mm256_cvtph_ps(_mm_loadu_si128(src + 2));
+			const __m256 p67 = _mm256_cvtph_ps(_mm_loadu_si128(src + 3));
+
+			//Transposed to a register per channel, the pixels in the 0 4 2 6 | 1 5 3 7 order
+			const __m256 rg0 = _mm256_unpacklo_ps(p01, p23);
+			const __m256 ba0 = _mm256_unpackhi_ps(p01, p23);
+			const __m256 rg1 = _mm256_unpacklo_ps(p45, p67);
+			const __m256 ba1 = _mm256_unpackhi_ps(p45, p67);
+			const __m256 r = TransformValues(_mm256_unpacklo_ps(rg0, rg1), exposure, bReinhard, inverseWhitePoint2);
+			const __m256 g = TransformValues(_mm256_unpackhi_ps(rg0, rg1), exposure, bReinhard, inverseWhitePoint2);
+			const __m256 b = TransformValues(_mm256_unpacklo_ps(ba0, ba1), exposure, bReinhard, inverseWhitePoint2);
+
+			__m256 luminanceValues = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(0.0722f), b), _mm256_mul_ps(_mm256_set1_ps(0.7152f), g)),
+				_mm256_mul_ps(_mm256_set1_ps(0.2126f), r));
+
+			const __m256 sum = _mm256_add_ps(_mm256_add_ps(r, g), b);
+			const __m256 redValue = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(r, g), b), _mm256_set1_ps(320.f));
+			const __m256 redMask = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(sum, zero, _CMP_GT_OQ), _mm256_cmp_ps(r, _mm256_mul_ps(_mm256_set1_ps(0.8f), sum), _CMP_GE_OQ)),
+				_mm256_cmp_ps(redValue, zero, _CMP_GT_OQ));
+			__m256 redValues = _mm256_and_ps(redMask, redValue);
+
+			//Back to the pixel order (the permutation is its own inverse)
+			luminanceValues = _mm256_permutevar8x32_ps(luminanceValues, pixelOrder);
+			redValues = _mm256_permutevar8x32_ps(redValues, pixelOrder);
+			StorePlaneValues(luminanceValues, FrameTileGrid::LuminanceScale, luminance + x);
+			StorePlaneValues(redValues, FrameTileGrid::RedScale, red + x);
+		}
+		if (x < pixels)
+		{
+			HalfFloatConversion::ConvertRowScalar(rgba + x * 4, pixels - x, transform, luminance + x, red + x);
+		}
+	}
+
+	IRIS_SIMD_TARGET void EncodeRowBGRAVX2(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform, uint8* bgr)
+	{
+		const uint8* encodeTable = GetSrgbEncodeTable();
+		const bool bReinhard = transform.toneMapping == EIrisToneMapping::Reinhard;
+		const __m256 exposure = _mm256_set1_ps(transform.exposure);
+		const __m256 inverseWhitePoint2 = _mm256_set1_ps(GetInverseWhitePoint2(transform));
+		const __m256 tableScale = _mm256_set1_ps(EncodeTableSize - 1);
+		const __m256 half = _mm256_set1_ps(0.5f);
+		const __m256i byteMask = _mm256_set1_epi32(0xFF);
+		const __m256i pixelOrder = _mm256_setr_epi32(0, 4, 2, 6, 1, 5, 3, 7);
+		//B, G, R bytes of the 4 pixels of each lane packed in its first 12 bytes
+		const __m256i packOrder = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+			0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+		int32 x = 0;
+		for (; x + 8 <= pixels; x += 8)
+		{
+			//Same transposition as ConvertRowAVX2
+			const __m128i* src = reinterpret_cast<const __m128i*>(rgba + x * 4);
+			const __m256 p01 = _mm256_cvtph_ps(_mm_loadu_si128(src));
+			const __m256 p23 = _mm256_cvtph_ps(_mm_loadu_si128(src + 1));
+			const __m256 p45 = _mm256_cvtph_ps(_mm_loadu_si128(src + 2));
+			const __m256 p67 = _mm256_cvtph_ps(_mm_loadu_si128(src + 3));
+			const __m256 rg0 = _mm256_unpacklo_ps(p01, p23);
+			const __m256 ba0 = _mm256_unpackhi_ps(p01, p23);
+			const __m256 rg1 = _mm256_unpacklo_ps(p45, p67);
+			const __m256 ba1 = _mm256_unpackhi_ps(p45, p67);
+			const __m256 r = TransformValues(_mm256_unpacklo_ps(rg0, rg1), exposure, bReinhard, inverseWhitePoint2);
+			const __m256 g = TransformValues(_mm256_unpackhi_ps(rg0, rg1), exposure, bReinhard, inverseWhitePoint2);
+			const __m256 b = TransformValues(_mm256_unpacklo_ps(ba0, ba1), exposure, bReinhard, inverseWhitePoint2);
+
+			//Table lookups, the same index as the scalar kernel
+			const __m256i rEncoded = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(encodeTable), _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(r, tableScale), half)), 1), byteMask);
+			const __m256i gEncoded = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(encodeTable), _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(g, tableScale), half)), 1), byteMask);
+			const __m256i bEncoded = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(encodeTable), _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(b, tableScale), half)), 1), byteMask);
+			__m256i pixels32 = _mm256_or_si256(_mm256_or_si256(bEncoded, _mm256_slli_epi32(gEncoded, 8)), _mm256_slli_epi32(rEncoded, 16));
+			pixels32 = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(pixels32, pixelOrder), packOrder);
+
+			//12 bytes per lane, no write past the 8 pixels
+			uint8* dst = bgr + x * 3;
+			for (const __m128i lane : { _mm256_castsi256_si128(pixels32), _mm256_extracti128_si256(pixels32, 1) })
+			{
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(dst), lane);
+				const int32 tail = _mm_extract_epi32(lane, 2);
+				FMemory::Memcpy(dst + 8, &tail, sizeof(tail));
+				dst += 12;
+			}
+		}
+		if (x < pixels)
+		{
+			HalfFloatConversion::EncodeRowBGRScalar(rgba + x * 4, pixels - x, transform, bgr + x * 3);
+		}
+	}
+#endif
+}
+
+void HalfFloatConversion::ConvertRow(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform,
+	FrameTileGrid::PlaneValue* luminance, FrameTileGrid::PlaneValue* red)
+{
+	static const bool bSimd = HasSimdSupport();
+	if (bSimd)
+	{
+		ConvertRowSimd(rgba, pixels, transform, luminance, red);
+	}
+	else
+	{
+		ConvertRowScalar(rgba, pixels, transform, luminance, red);
+	}
+}
+
+void HalfFloatConversion::ConvertRowScalar(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform,
+	FrameTileGrid::PlaneValue* luminance, FrameTileGrid::PlaneValue* red)
+{
+	const bool bReinhard = transform.toneMapping == EIrisToneMapping::Reinhard;
+	const float inverseWhitePoint2 = GetInverseWhitePoint2(transform);
+
+	for (int32 x = 0; x < pixels; x++, rgba += 4)
+	{
+		float luminanceValue, redValue;
+		ConvertLinearPixel(TransformValue(rgba[0].GetFloat(), transform.exposure, bReinhard, inverseWhitePoint2),
+			TransformValue(rgba[1].GetFloat(), transform.exposure, bReinhard, inverseWhitePoint2),
+			TransformValue(rgba[2].GetFloat(), transform.exposure, bReinhard, inverseWhitePoint2), luminanceValue, redValue);
+		luminance[x] = FrameTileGrid::EncodePlaneValue(luminanceValue, FrameTileGrid::LuminanceScale);
+		red[x] = FrameTileGrid::EncodePlaneValue(redValue, FrameTileGrid::RedScale);
+	}
+}
+
+void HalfFloatConversion::ConvertRowSimd(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform,
+	FrameTileGrid::PlaneValue* luminance, FrameTileGrid::PlaneValue* red)
+{
+#if IRIS_HALF_FLOAT_SIMD
+	ConvertRowAVX2(rgba, pixels, transform, luminance, red);
+#else
+	ConvertRowScalar(rgba, pixels, transform, luminance, red);
+#endif
+}
+
+bool HalfFloatConversion::HasSimdSupport()
+{
+#if IRIS_HALF_FLOAT_SIMD
+	//Every AVX2 CPU also has F16C
+	return FPlatformMisc::HasAVX2InstructionsSupport();
+#else
+	return false;
+#endif
+}
+
+float HalfFloatConversion::ApplyDisplayTransform(float value, const FIrisDisplayTransform& transform)
+{
+	return TransformValue(value, transform.exposure, transform.toneMapping == EIrisToneMapping::Reinhard, GetInverseWhitePoint2(transform));
+}
+
+void HalfFloatConversion::EncodeRowBGR(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform, uint8* bgr)
+{
+	static const bool bSimd = HasSimdSupport();
+	if (bSimd)
+	{
+		EncodeRowBGRSimd(rgba, pixels, transform, bgr);
+	}
+	else
+	{
+		EncodeRowBGRScalar(rgba, pixels, transform, bgr);
+	}
+}
+
+void HalfFloatConversion::EncodeRowBGRSimd(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform, uint8* bgr)
+{
+#if IRIS_HALF_FLOAT_SIMD
+	EncodeRowBGRAVX2(rgba, pixels, transform, bgr);
+#else
+	EncodeRowBGRScalar(rgba, pixels, transform, bgr);
+#endif
+}
+
+void HalfFloatConversion::EncodeRowBGRScalar(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform, uint8* bgr)
+{
+	const uint8* encodeTable = GetSrgbEncodeTable();
+	const bool bReinhard = transform.toneMapping == EIrisToneMapping::Reinhard;
+	const float inverseWhitePoint2 = GetInverseWhitePoint2(transform);
+	const float tableScale = EncodeTableSize - 1;
+
+	for (int32 x = 0; x < pixels; x++, rgba += 4, bgr += 3)
+	{
+		for (int32 channel = 0; channel < 3; channel++)
+		{
+			const float value = TransformValue(rgba[channel].GetFloat(), transform.exposure, bReinhard, inverseWhitePoint2);
+			bgr[2 - channel] = encodeTable[static_cast<int32>(value * tableScale + 0.5f)];
+		}
+	}
+}
+
+void HalfFloatConversion::EncodeFrameBGR(const cv::Mat& rgbaHalf, const FIrisDisplayTransform& transform, cv::Mat& outBgr)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisEncodeHalfFloatFrame);
+
+	outBgr.create(rgbaHalf.rows, rgbaHalf.cols, CV_8UC3);
+	for (int32 row = 0; row < rgbaHalf.rows; row++)
+	{
+		EncodeRowBGR(rgbaHalf.ptr<FFloat16>(row), rgbaHalf.cols, transform, outBgr.ptr<uint8>(row));
+	}
+}
@@ -0,0 +1,261 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "IncidentIndex.h"
+#include "RegionTransitionTracker.h"
+#include "Algo/BinarySearch.h"
+#include "Misc/FileHelper.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "utils/JsonWrapper.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+	FString FormatTimeStamp(uint32 timeStampMs)
+	{
+		return FString::Printf(TEXT("%02u:%02u:%02u.%03u"), timeStampMs / 3600000, timeStampMs / 60000 % 60, timeStampMs / 1000 % 60, timeStampMs % 1000);
+	}
+}
+
+void IncidentIndex::Update(const iris::FrameData& frameData, const RegionTransitionTracker* regionTracker)
+{
+	const bool bFailing[CategoryCount] = {
+		frameData.luminanceFrameResult == iris::FlashResult::FlashFail,
+		frameData.luminanceFrameResult == iris::FlashResult::ExtendedFail,
+		frameData.redFrameResult == iris::FlashResult::FlashFail,
+		frameData.redFrameResult == iris::FlashResult::ExtendedFail,
+		frameData.patternFrameResult == iris::PatternResult::Fail
+	};
+
+	bool bChanges = false;
+	for (int32 category = 0; category < CategoryCount; category++)
+	{
+		bChanges |= bFailing[category] || openIncidents[category] != INDEX_NONE;
+	}
+	if (!bChanges)
+	{
+		return;
+	}
+
+	const uint32 transitions[CategoryCount] = {
+		frameData.LuminanceTransitions,
+		frameData.LuminanceTransitions,
+		frameData.RedTransitions,
+		frameData.RedTransitions,
+		static_cast<uint32>(FMath::Max(frameData.patternDetectedLines, 0))
+	};
+
+	FScopeLock lock(&incidentsSection);
+	for (int32 category = 0; category < CategoryCount; category++)
+	{
+		if (!bFailing[category])
+		{
+			if (openIncidents[category] != INDEX_NONE)
+			{
+				CloseIncident(category);
+			}
+			continue;
+		}
+
+		const bool bNewIncident = openIncidents[category] == INDEX_NONE;
+		if (bNewIncident)
+		{
+			openIncidents[category] = incidents.Num();
+			categoryIncidents[category].Add(incidents.Num());
+			FIrisIncident& incident = incidents.AddDefaulted_GetRef();
+			incident.category = static_cast<EIncidentCategory>(category);
+			incident.startFrame = frameData.Frame;
+			incident.startTimeStampMs = frameData.TimeStampVal;
+		}
+
+		FIrisIncident& incident = incidents[openIncidents[category]];
+		incident.endFrame = frameData.Frame;
+		incident.endTimeStampMs = frameData.TimeStampVal;
+		incident.peakTransitions = FMath::Max(incident.peakTransitions, transitions[category]);
+		if (regionTracker != nullptr && incident.category != EIncidentCategory::PatternFail)
+		{
+			const bool bRed = incident.category == EIncidentCategory::RedFlashFail || incident.category == EIncidentCategory::RedExtendedFail;
+			regionTracker->GetFailingRegions(bRed, failingRegions);
+			for (int32 region : failingRegions)
+			{
+				incident.regions.AddUnique(region);
+			}
+		}
+
+		if (bNewIncident)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Iris %s%s trigger at %s (frame %u)%s%s"), *label, GetCategoryName(incident.category), *FormatTimeStamp(incident.startTimeStampMs),
+				incident.startFrame, incident.regions.IsEmpty() ? TEXT("") : TEXT(", regions "), *RegionTransitionTracker::DescribeRegions(incident.regions));
+		}
+	}
+}
+
+void IncidentIndex::CloseIncident(int32 category)
+{
+	const FIrisIncident& incident = incidents[openIncidents[category]];
+	openIncidents[category] = INDEX_NONE;
+	UE_LOG(LogTemp, Warning, TEXT("Iris %s%s ended at %s (frame %u), lasted %.2fs, peak %u %s%s%s"), *label, GetCategoryName(incident.category), *FormatTimeStamp(incident.endTimeStampMs),
+		incident.endFrame, (incident.endTimeStampMs - incident.startTimeStampMs) / 1000.f, incident.peakTransitions,
+		incident.category == EIncidentCategory::PatternFail ? TEXT("lines") : TEXT("transitions"),
+		incident.regions.IsEmpty() ? TEXT("") : TEXT(", regions "), *RegionTransitionTracker::DescribeRegions(incident.regions));
+}
+
+void IncidentIndex::GetIncidents(uint32 fromMs, uint32 toMs, TArray<FIrisIncident>& outIncidents, EIncidentCategory category) const
+{
+	outIncidents.Reset();
+	FScopeLock lock(&incidentsSection);
+
+	const int32 firstCategory = category == EIncidentCategory::Count ? 0 : static_cast<int32>(category);
+	const int32 lastCategory = category == EIncidentCategory::Count ? CategoryCount - 1 : firstCategory;
+	for (int32 c = firstCategory; c <= lastCategory; c++)
+	{
+		//First incident ending at or after fromMs, first one starting after toMs
+		const TArray<int32>& ordered = categoryIncidents[c];
+		const int32 first = Algo::LowerBoundBy(ordered, fromMs, [this](int32 incident) { return incidents[incident].endTimeStampMs; });
+		const int32 last = Algo::UpperBoundBy(ordered, toMs, [this](int32 incident) { return incidents[incident].startTimeStampMs; });
+		for (int32 i = first; i < last; i++)
+		{
+			outIncidents.Add(incidents[ordered[i]]);
+		}
+	}
+	if (firstCategory != lastCategory)
+	{
+		outIncidents.StableSort([](const FIrisIncident& a, const FIrisIncident& b) { return a.startTimeStampMs < b.startTimeStampMs; });
+	}
+}
+
+void IncidentIndex::EndSession(const FString& reportPath)
+{
+	FScopeLock lock(&incidentsSection);
+	for (int32 category = 0; category < CategoryCount; category++)
+	{
+		if (openIncidents[category] != INDEX_NONE)
+		{
+			CloseIncident(category);
+		}
+	}
+
+	FString summary;
+	for (int32 category = 0; category < CategoryCount; category++)
+	{
+		if (categoryIncidents[category].IsEmpty())
+		{
+			continue;
+		}
+		uint32 durationMs = 0;
+		for (int32 incident : categoryIncidents[category])
+		{
+			durationMs += incidents[incident].endTimeStampMs - incidents[incident].startTimeStampMs;
+		}
+		summary += FString::Printf(TEXT(" %s: %d (%.2fs)"), GetCategoryName(static_cast<EIncidentCategory>(category)), categoryIncidents[category].Num(), durationMs / 1000.f);
+	}
+	UE_LOG(LogTemp, Log, TEXT("Iris %ssession incidents: %d%s"), *label, incidents.Num(), *summary);
+
+	if (reportPath.IsEmpty())
+	{
+		return;
+	}
+	json report = json::array();
+	for (const FIrisIncident& incident : incidents)
+	{
+		report.push_back({
+			{ "Category", TCHAR_TO_UTF8(GetCategoryName(incident.category)) },
+			{ "StartFrame", incident.startFrame },
+			{ "EndFrame", incident.endFrame },
+			{ "StartTimeStampMs", incident.startTimeStampMs },
+			{ "EndTimeStampMs", incident.endTimeStampMs },
+			{ "PeakTransitions", incident.peakTransitions },
+			{ "Regions", TCHAR_TO_UTF8(*RegionTransitionTracker::DescribeRegions(incident.regions)) }
+		});
+	}
+	FFileHelper::SaveStringToFile(UTF8_TO_TCHAR(report.dump(1, '\t').c_str()), *reportPath);
+}
+
+void IncidentIndex::AppendIncident(const FIrisIncident& incident)
+{
+	FScopeLock lock(&incidentsSection);
+	const int32 category = static_cast<int32>(incident.category);
+	TArray<int32>& ordered = categoryIncidents[category];
+	if (!ordered.IsEmpty() && incidents[ordered.Last()].endFrame + 1 == incident.startFrame)
+	{
+		FIrisIncident& previous = incidents[ordered.Last()];
+		previous.endFrame = incident.endFrame;
+		previous.endTimeStampMs = incident.endTimeStampMs;
+		previous.peakTransitions = FMath::Max(previous.peakTransitions, incident.peakTransitions);
+		for (int32 region : incident.regions)
+		{
+			previous.regions.AddUnique(region);
+		}
+		return;
+	}
+	ordered.Add(incidents.Num());
+	incidents.Add(incident);
+}
+
+void IncidentIndex::Reset()
+{
+	FScopeLock lock(&incidentsSection);
+	incidents.Reset();
+	for (int32 category = 0; category < CategoryCount; category++)
+	{
+		categoryIncidents[category].Reset();
+		openIncidents[category] = INDEX_NONE;
+	}
+}
+
+void IncidentIndex::Serialize(FArchive& ar)
+{
+	FScopeLock lock(&incidentsSection);
+	int32 incidentCount = incidents.Num();
+	ar << incidentCount;
+	if (ar.IsLoading())
+	{
+		incidents.SetNum(FMath::Max(incidentCount, 0));
+	}
+	for (FIrisIncident& incident : incidents)
+	{
+		uint8 category = static_cast<uint8>(incident.category);
+		ar << category << incident.startFrame << incident.endFrame << incident.startTimeStampMs << incident.endTimeStampMs << incident.peakTransitions << incident.regions;
+		incident.category = static_cast<EIncidentCategory>(FMath::Min<uint8>(category, CategoryCount - 1));
+	}
+	for (int32 category = 0; category < CategoryCount; category++)
+	{
+		ar << categoryIncidents[category] << openIncidents[category];
+	}
+
+	if (ar.IsLoading())
+	{
+		bool bValid = !ar.IsError();
+		for (int32 category = 0; category < CategoryCount && bValid; category++)
+		{
+			bValid = openIncidents[category] == INDEX_NONE || incidents.IsValidIndex(openIncidents[category]);
+			for (int32 incident : categoryIncidents[category])
+			{
+				bValid &= incidents.IsValidIndex(incident);
+			}
+		}
+		if (!bValid)
+		{
+			incidents.Reset();
+			for (int32 category = 0; category < CategoryCount; category++)
+			{
+				categoryIncidents[category].Reset();
+				openIncidents[category] = INDEX_NONE;
+			}
+			ar.SetError();
+		}
+	}
+}
+
+const TCHAR* IncidentIndex::GetCategoryName(EIncidentCategory category)
+{
+	switch (category)
+	{
+	case EIncidentCategory::LuminanceFlashFail: return TEXT("LuminanceFlashFail");
+	case EIncidentCategory::LuminanceExtendedFail: return TEXT("LuminanceExtendedFail");
+	case EIncidentCategory::RedFlashFail: return TEXT("RedFlashFail");
+	case EIncidentCategory::RedExtendedFail: return TEXT("RedExtendedFail");
+	case EIncidentCategory::PatternFail: return TEXT("PatternFail");
+	default: return TEXT("Unknown");
+	}
+}
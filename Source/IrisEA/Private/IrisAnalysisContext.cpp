@@ -0,0 +1,192 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "IrisAnalysisContext.h"
+#include "ConfigurationSnapshot.h"
+#include "TieredAnalysis.h"
+#include "DataChart.h"
+#include "SessionResultsWriter.h"
+#include "VideoRecorder.h"
+#include "HAL/Event.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/Paths.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "iris/Configuration.h"
+#include "iris/VideoAnalyser.h"
+#include "src/ConfigurationParams.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+	//Context holding the IRIS library statics, the event is triggered when it releases them
+	FCriticalSection libraryLock;
+	const FIrisAnalysisContext* libraryOwner = nullptr;
+	FEvent* libraryReleasedEvent = nullptr;
+
+	//Longest wait on the event before the owner is checked again
+	constexpr uint32 LibraryWaitSliceMs = 100;
+}
+
+FIrisAnalysisContext::~FIrisAnalysisContext()
+{
+	Release();
+}
+
+void FIrisAnalysisContext::Initialize(iris::Configuration* analyserConfiguration, const ConfigurationSnapshot* settings)
+{
+	if (IsInitialized())
+	{
+		return;
+	}
+	configuration = analyserConfiguration;
+	configurationSnapshot = settings;
+	videoAnalyser = new iris::VideoAnalyser(configuration);
+	tieredAnalysis = new TieredAnalysis(videoAnalyser);
+}
+
+bool FIrisAnalysisContext::BeginSession(const cv::Size& frameSize, const cv::Size& lowTierFrameSize, const char* configurationPath, float libraryWaitSeconds)
+{
+	if (!AcquireLibrary(libraryWaitSeconds))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris analysis could not begin, another analyser of the process is analysing"));
+		return false;
+	}
+	const FIrisConfigurationSnapshot& settings = configurationSnapshot->GetSnapshot();
+
+	//The pattern detection stage replaces the VideoAnalyser pattern detection
+	configuration->SetPatternDetectionStatus(settings.bPatternDetectionEnabled && !bPatternDetection);
+	//The tiered analysis starts on its low resolution tier
+	cv::Size analysisSize = bTieredAnalysis ? lowTierFrameSize : frameSize;
+	if (IsVideoSession())
+	{
+		//Same initialization as VideoAnalyser::AnalyseVideo, the video information sets the frame rate of the windows
+		cv::VideoCapture video;
+		const FString videoName = FPaths::GetBaseFilename(videoPath);
+		if (!videoAnalyser->VideoIsOpen(TCHAR_TO_UTF8(*videoPath), video, TCHAR_TO_UTF8(*videoName)))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Iris analysis could not begin, the IRIS library could not open %s"), *videoPath);
+			ReleaseLibrary();
+			return false;
+		}
+		videoAnalyser->Init(TCHAR_TO_UTF8(*videoName), false);
+	}
+	else
+	{
+		videoAnalyser->RealTimeInit(analysisSize);
+	}
+	analysisFrameSize = frameSize;
+
+	if (bPatternDetection)
+	{
+		patternDetection.Initialize(configurationPath);
+	}
+	if (bTieredAnalysis)
+	{
+		//Confirm the window well before it can reach the warning transitions, the replayed window covers the extended fail window
+		tieredAnalysis->Initialize(lowTierFrameSize, frameSize, settings.warningTransitions / 2, settings.extendedFailWindow + 1.f);
+	}
+	regionTracker.Initialize(configurationSnapshot->GetLuminanceFlashParams(), configurationSnapshot->GetRedSaturationFlashParams(), configurationSnapshot->GetTransitionTrackerParams());
+	incidentIndex.Reset();
+	splitScreen.Initialize(*configurationSnapshot, displayTransform);
+	if (VideoRecorder* recorder = videoRecorder)
+	{
+		recorder->SetDisplayTransform(displayTransform);
+	}
+	bActive = true;
+	return true;
+}
+
+void FIrisAnalysisContext::EndSession()
+{
+	//Frames left in the queue hold readback buffers, they are not analysed on the next session
+	framesToAnalyse.Empty();
+	tieredAnalysis->Reset();
+	videoAnalyser->DeInit();
+	ReleaseLibrary();
+	regionTracker.Reset();
+	patternDetection.Reset();
+	const FString resultsFolder = resultsWriter != nullptr && resultsWriter->IsOpen() ? resultsWriter->GetFolderPath() : FString();
+	incidentIndex.EndSession(resultsFolder.IsEmpty() ? FString() : resultsFolder / TEXT("Incidents.json"));
+	splitScreen.EndSession(resultsFolder);
+	if (resultsWriter != nullptr)
+	{
+		resultsWriter->Close();
+	}
+	if (chart != nullptr)
+	{
+		chart->Reset();
+	}
+	if (VideoRecorder* recorder = videoRecorder)
+	{
+		recorder->Reset();
+	}
+}
+
+void FIrisAnalysisContext::Release()
+{
+	if (videoAnalyser != nullptr)
+	{
+		//The statics belong to the context holding the library
+		if (HoldsLibrary())
+		{
+			videoAnalyser->DeInit();
+			ReleaseLibrary();
+		}
+		delete videoAnalyser;
+		videoAnalyser = nullptr;
+	}
+	delete tieredAnalysis;
+	tieredAnalysis = nullptr;
+}
+
+bool FIrisAnalysisContext::AcquireLibrary(float waitSeconds)
+{
+	const double endTime = FPlatformTime::Seconds() + waitSeconds;
+	while (true)
+	{
+		FEvent* releasedEvent = nullptr;
+		{
+			FScopeLock lock(&libraryLock);
+			if (libraryOwner == nullptr || libraryOwner == this)
+			{
+				libraryOwner = this;
+				return true;
+			}
+			if (libraryReleasedEvent == nullptr)
+			{
+				libraryReleasedEvent = FPlatformProcess::GetSynchEventFromPool(false);
+			}
+			releasedEvent = libraryReleasedEvent;
+		}
+		uint32 waitMs = LibraryWaitSliceMs;
+		if (waitSeconds >= 0.f)
+		{
+			const double remainingMs = (endTime - FPlatformTime::Seconds()) * 1000.0;
+			if (remainingMs <= 0.0)
+			{
+				return false;
+			}
+			waitMs = FMath::Min(LibraryWaitSliceMs, static_cast<uint32>(FMath::CeilToDouble(remainingMs)));
+		}
+		releasedEvent->Wait(waitMs);
+	}
+}
+
+void FIrisAnalysisContext::ReleaseLibrary()
+{
+	FScopeLock lock(&libraryLock);
+	if (libraryOwner == this)
+	{
+		libraryOwner = nullptr;
+		if (libraryReleasedEvent != nullptr)
+		{
+			libraryReleasedEvent->Trigger();
+		}
+	}
+}
+
+bool FIrisAnalysisContext::HoldsLibrary() const
+{
+	FScopeLock lock(&libraryLock);
+	return libraryOwner == this;
+}
@@ -1,6 +1,7 @@
 //Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
 
 #include "IrisEA.h"
+#include "ShardedVideoAnalysis.h"
 #include "HAL/Platform.h"
 #include "Misc/MessageDialog.h"
 #include "Modules/ModuleManager.h"
@@ -10,7 +11,14 @@
 #include "Debug/DebugDrawService.h"
 #include "Engine/Canvas.h"
 #include "Engine/Engine.h"
+#include "HAL/FileManager.h"
 #include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Engine/LocalPlayer.h"
+#include "GameFramework/PlayerController.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "src/ConfigurationParams.h"
+THIRD_PARTY_INCLUDES_END
 
 
 #if PLATFORM_WINDOWS
@@ -31,54 +39,62 @@ THIRD_PARTY_INCLUDES_END
 void FIrisEAModule::StartupModule()
 {
 	instance = this;
-	IrisInit();
+	//The IRIS setup (appsettings parsing, VideoAnalyser) is deferred to the first session
 	//Unreal Engine console commands
 	RegisterCommands();
 }
 
 void FIrisEAModule::ShutdownModule()
 {
-	IrisDeInit();
+	if (bIrisInitialized)
+	{
+		IrisDeInit();
+	}
 	UnregisterCommands();
 }
 
 void FIrisEAModule::IrisInit()
 {
+	if (bIrisInitialized)
+	{
+		return;
+	}
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisInit);
+	const double startTime = FPlatformTime::Seconds();
+
 	log.Init(false, false);
 
 	//Get appsettings.json path
 	FString PluginBaseDir = IPluginManager::Get().FindPlugin("IrisEA")->GetBaseDir();
-	FString CurrentDir = FPaths::Combine(*PluginBaseDir, TEXT("Source/ThirdParty/IrisLibrary/Win64/"));
+	configurationDir = FPaths::Combine(*PluginBaseDir, TEXT("Source/ThirdParty/IrisLibrary/Win64/"));
 
-	//Load configuration  
-	configuration.Init(TCHAR_TO_UTF8(*CurrentDir));
+	//Load configuration, the plugin stages read a snapshot of it
+	if (!configurationSnapshot.Load(configuration, configurationDir))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris could not read %sappsettings.json"), *configurationDir);
+	}
 
 	//VideoAnalyser
-	vA = new iris::VideoAnalyser(&instance->configuration);
+	analysisContext.Initialize(&configuration, &configurationSnapshot);
 
 	frameCapturer = new FrameCapturerManager();
-	videoRecorder = new VideoRecorder(configuration);
-	irisAnalysis = new AsyncAnalysis();
+	videoRecorder = new VideoRecorder();
+	irisAnalysis = new AsyncAnalysis(analysisContext);
+
+	bIrisInitialized = true;
+	UE_LOG(LogTemp, Log, TEXT("Iris initialized in %.1f ms"), (FPlatformTime::Seconds() - startTime) * 1000.0);
 }
 
 void FIrisEAModule::IrisDeInit()
 {
 	//VideoAnalyser clean up
-	vA->DeInit();
-	delete vA;
+	analysisContext.Release();
 	delete frameCapturer;
 	delete videoRecorder;
 	irisAnalysis->Stop();
 	delete irisAnalysis;
 }
 
-void FIrisEAModule::IrisReset() 
-{
-	vA->DeInit();
-	chartManager.Reset();
-	videoRecorder->Reset();
-}
-
 DECLSPEC_NOINLINE bool FIrisEAModule::VideoAnalyserSetUp()
 {
 	if (!GEngine->GameViewport)
@@ -100,8 +116,29 @@ DECLSPEC_NOINLINE bool FIrisEAModule::VideoAnalyserSetUp()
 
 	//VideoAnalyser Init
 	frameSize = { Height , Width };
-	vA->RealTimeInit(frameSize);
-	return true;
+	lowTierFrameSize = { FMath::Max(1, static_cast<int32>(Viewport->GetSizeXY().Y * lowTierResizeProportion)), FMath::Max(1, static_cast<int32>(Viewport->GetSizeXY().X * lowTierResizeProportion)) };
+	analysisContext.bTieredAnalysis = bTieredAnalysis;
+	analysisContext.bPatternDetection = bPatternDetection;
+	analysisContext.displayTransform = displayTransform;
+	analysisContext.chart = &chartManager;
+	analysisContext.resultsWriter = &resultsWriter;
+	videoRecorder->SetWarningSaving(bWarningRecording);
+	analysisContext.videoRecorder = bVideoRecording ? videoRecorder : nullptr;
+
+	//A resumed session keeps writing to the checkpoint it was loaded from
+	const FIrisConfigurationSnapshot& settings = configurationSnapshot.GetSnapshot();
+	if (checkpointSeconds > 0.f || sessionCheckpoint.IsResuming())
+	{
+		sessionCheckpoint.Begin(sessionCheckpoint.IsResuming() ? sessionCheckpoint.GetPath() : FPaths::ProjectSavedDir() / TEXT("Iris") / TEXT("Session.irisckpt"),
+			checkpointSeconds, settings.contentHash, settings.extendedFailWindow);
+		analysisContext.checkpoint = &sessionCheckpoint;
+	}
+	else
+	{
+		analysisContext.checkpoint = nullptr;
+	}
+	//Fails while a raw analyser of the process holds the IRIS library
+	return analysisContext.BeginSession(frameSize, lowTierFrameSize, TCHAR_TO_UTF8(*configurationDir));
 }
 
 void FIrisEAModule::ExecuteAllCommands()
@@ -118,16 +155,31 @@ void FIrisEAModule::StartIrisSession()
 		UE_LOG(LogTemp, Warning, TEXT("A session of Iris is currently running, use the 'Iris.EndSession' to end the current session."));
 		return;
 	}
+	const double startTime = FPlatformTime::Seconds();
+	const bool bWarmStart = bIrisInitialized;
+	IrisInit();
 	if (VideoAnalyserSetUp())
 	{
 		UE_LOG(LogTemp, Log, TEXT("Frame capture and Iris analysis activated"));
 		bIrisActive = true;
-		frameCapturer->Initialize();
+		//The capture continues the numbering and time stamps of a resumed session
+		if (sessionCheckpoint.IsResuming())
+		{
+			frameCapturer->Initialize(sessionCheckpoint.GetNextFrame(), sessionCheckpoint.GetLastTimeStampMs());
+		}
+		else
+		{
+			frameCapturer->Initialize();
+		}
 		AsyncIrisGameThread();
 		if (bVideoRecording)
 		{
 			videoRecorder->CreateDirectory();
 		}
+		if (bSaveResults || bSaveBinaryLog)
+		{
+			resultsWriter.Open(bSaveResults, bSaveBinaryLog);
+		}
 		preExitDelegateHandle = FCoreDelegates::OnPreExit.AddRaw(this, &FIrisEAModule::EndIrisSession);
 		chartManager.SetChartValues(configuration.GetTransitionTrackerParams()->maxTransitions, configuration.GetTransitionTrackerParams()->warningTransitions);
 		drawDelegateHandle = UDebugDrawService::Register(TEXT("Game"), FDebugDrawDelegate::CreateRaw(this, &FIrisEAModule::DrawGraph));
@@ -135,6 +187,27 @@ void FIrisEAModule::StartIrisSession()
 #if !WITH_EDITOR
 		bufferReadyDelegateHandle = FSlateApplication::Get().GetRenderer()->OnBackBufferReadyToPresent().AddRaw(this, &FIrisEAModule::OnBackBufferReady_RenderThread);
 #endif
+		UE_LOG(LogTemp, Log, TEXT("Iris session started in %.1f ms (%s start)"), (FPlatformTime::Seconds() - startTime) * 1000.0, bWarmStart ? TEXT("warm") : TEXT("cold"));
+	}
+}
+
+void FIrisEAModule::ResumeIrisSession(const TArray<FString, FDefaultAllocator>& Args)
+{
+	if (bIrisActive)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("A session of Iris is currently running, use the 'Iris.EndSession' to end the current session."));
+		return;
+	}
+	IrisInit();
+	const FString checkpointPath = Args.Num() > 0 ? Args[0] : FPaths::ProjectSavedDir() / TEXT("Iris") / TEXT("Session.irisckpt");
+	if (!sessionCheckpoint.Load(checkpointPath, configurationSnapshot.GetSnapshot().contentHash))
+	{
+		return;
+	}
+	StartIrisSession();
+	if (!bIrisActive)
+	{
+		sessionCheckpoint.Reset();
 	}
 }
 
@@ -147,6 +220,7 @@ void FIrisEAModule::EndIrisSession()
 	}
 	UE_LOG(LogTemp, Log, TEXT("Frame capture and Iris analysis deactivated"));
 	bIrisActive = false;
+	analysisContext.bActive = false;
 	frameCapturer->EndSession();
 	FString FilePath = FPaths::ProjectDir() / TEXT("IrisSessionMetrics.json");
 	UDebugDrawService::Unregister(drawDelegateHandle);
@@ -169,17 +243,291 @@ void FIrisEAModule::AsyncIrisGameThread()
 
 void FIrisEAModule::ToggleRecordEvents()
 {
-	if (bVideoRecording)
+	if (bVideoRecording && bIrisInitialized)
 	{
+		analysisContext.videoRecorder = nullptr;
 		videoRecorder->Reset();
 	}
 	else if (bIrisActive)
 	{
 		videoRecorder->CreateDirectory();
+		analysisContext.videoRecorder = videoRecorder;
 	}
 	bVideoRecording = !bVideoRecording;
 }
 
+void FIrisEAModule::ToggleTieredAnalysis()
+{
+	if (bIrisActive)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("The tiered analysis can not be toggled while a session is running, use the 'Iris.EndSession' command first."));
+		return;
+	}
+	bTieredAnalysis = !bTieredAnalysis;
+	UE_LOG(LogTemp, Log, TEXT("Iris tiered analysis %s"), bTieredAnalysis ? TEXT("enabled") : TEXT("disabled"));
+}
+
+void FIrisEAModule::ToggleSplitScreen()
+{
+	bSplitScreen = !bSplitScreen;
+	UE_LOG(LogTemp, Log, TEXT("Iris split screen analysis %s"), bSplitScreen ? TEXT("enabled") : TEXT("disabled"));
+}
+
+void FIrisEAModule::ToggleHdrCapture()
+{
+	if (bIrisActive)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("The HDR capture can not be toggled while a session is running, use the 'Iris.EndSession' command first."));
+		return;
+	}
+	bHdrCapture = !bHdrCapture;
+	UE_LOG(LogTemp, Log, TEXT("Iris HDR capture %s"), bHdrCapture ? TEXT("enabled") : TEXT("disabled"));
+}
+
+void FIrisEAModule::SetDisplayTransform(const TArray<FString, FDefaultAllocator>& Args)
+{
+	if (Args.Num() <= 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Usage: Iris.DisplayTransform <exposure> [Reinhard white point]"));
+		return;
+	}
+	const float exposure = FCString::Atof(*Args[0]);
+	const float whitePoint = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 0.f;
+	if (exposure <= 0.f || (Args.Num() > 1 && whitePoint <= 0.f))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Iris display transform exposure and white point must be positive"));
+		return;
+	}
+	displayTransform.exposure = exposure;
+	displayTransform.toneMapping = Args.Num() > 1 ? EIrisToneMapping::Reinhard : EIrisToneMapping::Clamp;
+	displayTransform.whitePoint = Args.Num() > 1 ? whitePoint : displayTransform.whitePoint;
+	if (displayTransform.toneMapping == EIrisToneMapping::Reinhard)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Iris display transform: exposure %.3f, Reinhard white point %.3f (next session)"), exposure, whitePoint);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Log, TEXT("Iris display transform: exposure %.3f, clamp (next session)"), exposure);
+	}
+}
+
+void FIrisEAModule::SetCheckpointInterval(const TArray<FString, FDefaultAllocator>& Args)
+{
+	if (bIrisActive)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("The checkpoint interval can not be changed while a session is running, use the 'Iris.EndSession' command first."));
+		return;
+	}
+	const float seconds = Args.Num() > 0 ? FCString::Atof(*Args[0]) : 0.f;
+	checkpointSeconds = FMath::Max(seconds, 0.f);
+	if (checkpointSeconds > 0.f)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Iris session checkpoint every %.1f s (next session)"), checkpointSeconds);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Log, TEXT("Iris session checkpoints disabled"));
+	}
+}
+
+void FIrisEAModule::BenchmarkConversion(const TArray<FString, FDefaultAllocator>& Args)
+{
+	IrisInit();
+	const int32 iterations = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 100;
+	if (iterations <= 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Usage: Iris.BenchmarkConversion [iterations]"));
+		return;
+	}
+	//Analysis size of a 1080p viewport
+	const cv::Size benchmarkSize(FMath::RoundToInt(1920 * frameResizeProportion), FMath::RoundToInt(1080 * frameResizeProportion));
+
+	//Baseline: the IRIS analysis of a frame, which converts it on its own. The IRIS time windows are shared, so it is
+	//only measured when no session or raw analyser holds the library
+	double baselineFrameMs = 0.0;
+	if (bIrisActive || !analysisContext.AcquireLibrary(0.f))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Iris conversion benchmark: the IRIS frame analysis is not measured while an analysis is running"));
+	}
+	else
+	{
+		cv::Mat frames[2] = { cv::Mat(benchmarkSize, CV_8UC3), cv::Mat(benchmarkSize, CV_8UC3) };
+		cv::randu(frames[0], cv::Scalar::all(0), cv::Scalar::all(256));
+		cv::randu(frames[1], cv::Scalar::all(0), cv::Scalar::all(256));
+		cv::Size analysisSize(benchmarkSize.height, benchmarkSize.width);
+		analysisContext.videoAnalyser->RealTimeInit(analysisSize);
+		const double startTime = FPlatformTime::Seconds();
+		for (unsigned int i = 0; i < static_cast<unsigned int>(iterations); i++)
+		{
+			iris::FrameData frameData(i, i * 16);
+			analysisContext.videoAnalyser->AnalyseFrame(frames[i % 2], i, frameData);
+		}
+		baselineFrameMs = (FPlatformTime::Seconds() - startTime) * 1000.0 / iterations;
+		analysisContext.videoAnalyser->DeInit();
+		analysisContext.ReleaseLibrary();
+	}
+	FrameTileGrid::BenchmarkConversion(configurationSnapshot.GetSnapshot(), displayTransform, benchmarkSize, iterations, baselineFrameMs);
+}
+
+void FIrisEAModule::AnalyseVideoShard(const TArray<FString, FDefaultAllocator>& Args)
+{
+	if (Args.Num() < 5)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Usage: Iris.AnalyseVideoShard <video path> <shard> <shard count> <shared directory> <session>"));
+		return;
+	}
+	if (bIrisActive)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("A session of Iris is currently running, use the 'Iris.EndSession' command before analysing a video shard."));
+		return;
+	}
+	IrisInit();
+	//The flash windows of the first frame of the shard are filled by the frames before it
+	const float warmUpSeconds = configurationSnapshot.GetSnapshot().extendedFailWindow + 1.f;
+	ShardedVideoAnalysis::AnalyseShard(configurationDir, Args[0], FCString::Atoi(*Args[1]), FCString::Atoi(*Args[2]), Args[4], warmUpSeconds, Args[3]);
+}
+
+void FIrisEAModule::MergeVideoShards(const TArray<FString, FDefaultAllocator>& Args)
+{
+	if (Args.Num() < 4)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Usage: Iris.MergeVideoShards <shared directory> <video name> <shard count> <session> [output directory]"));
+		return;
+	}
+	ShardedVideoAnalysis::MergeShards(Args[0], Args[1], FCString::Atoi(*Args[2]), Args[3], Args.Num() > 4 ? Args[4] : FString());
+}
+
+void FIrisEAModule::TogglePatternDetection()
+{
+	if (bIrisActive)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("The pattern detection can not be toggled while a session is running, use the 'Iris.EndSession' command first."));
+		return;
+	}
+	bPatternDetection = !bPatternDetection;
+	UE_LOG(LogTemp, Log, TEXT("Iris pattern detection %s"), bPatternDetection ? TEXT("enabled") : TEXT("disabled"));
+}
+
+void FIrisEAModule::ValidatePatternCascade(const TArray<FString, FDefaultAllocator>& Args)
+{
+	if (Args.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Usage: Iris.ValidatePatternCascade <video path> [video path...]"));
+		return;
+	}
+	IrisInit();
+	int32 equivalentClips = 0;
+	for (const FString& videoPath : Args)
+	{
+		equivalentClips += PatternDetectionStage::ValidateOnVideo(TCHAR_TO_UTF8(*configurationDir), configurationSnapshot.GetSnapshot(), videoPath);
+	}
+	UE_LOG(LogTemp, Log, TEXT("Iris pattern cascade validation: %d of %d clips with the same PatternFail verdicts as IRIS on every frame"), equivalentClips, Args.Num());
+}
+
+void FIrisEAModule::ValidateSplitScreen(const TArray<FString, FDefaultAllocator>& Args)
+{
+	TArray<FBox2f> layoutViews;
+	if (Args.Num() < 2 || !SplitScreenAnalysis::GetLayoutViews(Args[0], layoutViews))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Usage: Iris.ValidateSplitScreen <1|2h|2v|4> <video path> [video path...]"));
+		return;
+	}
+	IrisInit();
+	//The views are analysed with the session VideoAnalyser
+	if (bIrisActive || !analysisContext.AcquireLibrary(0.f))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Iris split screen validation can not run while an analysis is running"));
+		return;
+	}
+	int32 equivalentClips = 0;
+	for (int32 i = 1; i < Args.Num(); i++)
+	{
+		equivalentClips += SplitScreenAnalysis::ValidateOnVideo(*analysisContext.videoAnalyser, configurationSnapshot, Args[i], layoutViews);
+	}
+	analysisContext.ReleaseLibrary();
+	UE_LOG(LogTemp, Log, TEXT("Iris split screen validation: %d of %d clips with the same view flash results as IRIS"), equivalentClips, Args.Num() - 1);
+}
+
+void FIrisEAModule::ToggleResultsSaving()
+{
+	if (bIrisActive)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("The results saving can not be toggled while a session is running, use the 'Iris.EndSession' command first."));
+		return;
+	}
+	bSaveResults = !bSaveResults;
+	UE_LOG(LogTemp, Log, TEXT("Iris results saving %s"), bSaveResults ? TEXT("enabled") : TEXT("disabled"));
+}
+
+void FIrisEAModule::ToggleBinaryLogSaving()
+{
+	if (bIrisActive)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("The binary log saving can not be toggled while a session is running, use the 'Iris.EndSession' command first."));
+		return;
+	}
+	bSaveBinaryLog = !bSaveBinaryLog;
+	UE_LOG(LogTemp, Log, TEXT("Iris binary log saving %s"), bSaveBinaryLog ? TEXT("enabled") : TEXT("disabled"));
+}
+
+void FIrisEAModule::ConvertBinaryLog(const TArray<FString, FDefaultAllocator>& Args)
+{
+	if (Args.Num() <= 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Usage: Iris.ConvertBinaryLog <path to FrameData.irislog>"));
+		return;
+	}
+
+	FrameDataLogReader reader;
+	if (!reader.Open(Args[0]))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris binary log: %s could not be opened"), *Args[0]);
+		return;
+	}
+
+	const double startTime = FPlatformTime::Seconds();
+	SessionResultsWriter converter;
+	converter.Open(true, false, FPaths::GetPath(Args[0]));
+	TArray<iris::FrameData> blockFrames;
+	int64 frames = 0;
+	for (int32 block = 0; block < reader.GetBlockCount(); block++)
+	{
+		blockFrames.Reset();
+		if (!reader.ReadBlock(block, blockFrames))
+		{
+			break;
+		}
+		for (const iris::FrameData& frameData : blockFrames)
+		{
+			converter.PushFrameData(frameData);
+		}
+		frames += blockFrames.Num();
+	}
+	converter.Close();
+	const double seconds = FPlatformTime::Seconds() - startTime;
+
+	const int64 csvSize = IFileManager::Get().FileSize(*(converter.GetFolderPath() / TEXT("FrameData.csv")));
+	UE_LOG(LogTemp, Log, TEXT("Iris binary log: %lld frames converted in %.2fs (%.0f frames/s), binary %.1f KB, CSV %.1f KB (%.1fx)"),
+		frames, seconds, seconds > 0.0 ? frames / seconds : 0.0, reader.GetFileSize() / 1024.0, csvSize / 1024.0,
+		reader.GetFileSize() > 0 ? static_cast<double>(csvSize) / reader.GetFileSize() : 0.0);
+}
+
+void FIrisEAModule::ListIncidents(const TArray<FString, FDefaultAllocator>& Args)
+{
+	const uint32 fromMs = Args.Num() > 0 ? static_cast<uint32>(FCString::Atof(*Args[0]) * 1000.f) : 0;
+	const uint32 toMs = Args.Num() > 1 ? static_cast<uint32>(FCString::Atof(*Args[1]) * 1000.f) : MAX_uint32;
+
+	TArray<FIrisIncident> incidents;
+	analysisContext.incidentIndex.GetIncidents(fromMs, toMs, incidents);
+	UE_LOG(LogTemp, Log, TEXT("Iris incidents: %d"), incidents.Num());
+	for (const FIrisIncident& incident : incidents)
+	{
+		UE_LOG(LogTemp, Log, TEXT("  %s: frames %u-%u, %.3fs-%.3fs, peak %u%s%s"), IncidentIndex::GetCategoryName(incident.category), incident.startFrame, incident.endFrame,
+			incident.startTimeStampMs / 1000.f, incident.endTimeStampMs / 1000.f, incident.peakTransitions,
+			incident.regions.IsEmpty() ? TEXT("") : TEXT(", regions "), *RegionTransitionTracker::DescribeRegions(incident.regions));
+	}
+}
+
 void FIrisEAModule::DrawGraph(UCanvas* Canvas, APlayerController* PlayerController)
 {
 	if (!Canvas)
@@ -187,6 +535,14 @@ void FIrisEAModule::DrawGraph(UCanvas* Canvas, APlayerController* PlayerControll
 		return;
 	}
 
+	//The debug draw runs once per player view, a split screen view shows the charts of its own analysis
+	const ULocalPlayer* localPlayer = PlayerController ? PlayerController->GetLocalPlayer() : nullptr;
+	const int32 view = localPlayer && GEngine->GameViewport ? GEngine->GetGamePlayers(GEngine->GameViewport).IndexOfByKey(localPlayer) : INDEX_NONE;
+	if (analysisContext.splitScreen.DrawCharts(Canvas, view))
+	{
+		return;
+	}
+
 	chartManager.DrawResultsGraph(Canvas);
 	chartManager.DrawTransitionsGraph(Canvas);
 }
@@ -224,6 +580,91 @@ void FIrisEAModule::RegisterCommands()
 		TEXT("Move debug charts to given direction ( UP = 0, DOWN = 1, LEFT = 2, RIGHT = 3, RESET = 4)"),
 		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FIrisEAModule::MoveChart)
 	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.RegionTracking"),
+		TEXT("Toggles the per-region flash transition tracking, failing regions are logged with each trigger and shown as a heatmap in the debug frame."),
+		FConsoleCommandDelegate::CreateRaw(this, &FIrisEAModule::ToggleRegionTracking)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.TieredAnalysis"),
+		TEXT("Toggles the tiered analysis: analysis below the session resolution with session resolution confirmation of suspicious windows (applied on the next session)."),
+		FConsoleCommandDelegate::CreateRaw(this, &FIrisEAModule::ToggleTieredAnalysis)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.SplitScreen"),
+		TEXT("Toggles the analysis of each local player view of a split screen, with per player incidents and charts."),
+		FConsoleCommandDelegate::CreateRaw(this, &FIrisEAModule::ToggleSplitScreen)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.HDRCapture"),
+		TEXT("Toggles capturing the frames as linear half floats (PF_FloatRGBA), analysed through the display transform (applied on the next session)."),
+		FConsoleCommandDelegate::CreateRaw(this, &FIrisEAModule::ToggleHdrCapture)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.DisplayTransform"),
+		TEXT("Sets the display transform of the HDR frames: exposure and optional Reinhard white point, values over 1 are clipped without it (applied on the next session)."),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FIrisEAModule::SetDisplayTransform)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.Checkpoint"),
+		TEXT("Writes a checkpoint of the analysis every given number of seconds to Saved/Iris/Session.irisckpt, 0 disables it (applied on the next session)."),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FIrisEAModule::SetCheckpointInterval)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.ResumeSession"),
+		TEXT("Starts a session resuming the analysis of a checkpoint. Optional argument: checkpoint path, Saved/Iris/Session.irisckpt by default."),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FIrisEAModule::ResumeIrisSession)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.BenchmarkConversion"),
+		TEXT("Logs the luminance conversion time of each luminance model and capture format, specialised and with a per-pixel dispatch. Optional argument: iterations."),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FIrisEAModule::BenchmarkConversion)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.AnalyseVideoShard"),
+		TEXT("Analyses a shard of a video file into a shared directory, to be merged with Iris.MergeVideoShards. Arguments: video path, shard, shard count, shared directory, session name shared by the shards of the run."),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FIrisEAModule::AnalyseVideoShard)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.MergeVideoShards"),
+		TEXT("Merges the shards of a video into FrameData, Incidents.json and Result.json. Arguments: shared directory, video name, shard count, session name, optional output directory."),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FIrisEAModule::MergeVideoShards)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.PatternDetection"),
+		TEXT("Toggles the real-time pattern detection (applied on the next session)."),
+		FConsoleCommandDelegate::CreateRaw(this, &FIrisEAModule::TogglePatternDetection)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.ValidatePatternCascade"),
+		TEXT("Compares the pattern detection stage with the IRIS pattern detection of every frame on recorded clips. Arguments: video paths."),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FIrisEAModule::ValidatePatternCascade)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.ValidateSplitScreen"),
+		TEXT("Compares the split screen view results with the IRIS analysis of each view on recorded clips. Arguments: layout (1, 2h, 2v or 4), video paths."),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FIrisEAModule::ValidateSplitScreen)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.SaveResults"),
+		TEXT("Toggles saving the session frame data as FrameData.csv and FrameData.json (root/Saved/IrisSessions/Results/), applied on the next session."),
+		FConsoleCommandDelegate::CreateRaw(this, &FIrisEAModule::ToggleResultsSaving)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.SaveBinaryLog"),
+		TEXT("Toggles saving the session frame data as a compressed binary log FrameData.irislog (root/Saved/IrisSessions/Results/), applied on the next session."),
+		FConsoleCommandDelegate::CreateRaw(this, &FIrisEAModule::ToggleBinaryLogSaving)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.ConvertBinaryLog"),
+		TEXT("Converts a FrameData.irislog binary log to FrameData.csv and FrameData.json in the same directory (path of the log)."),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FIrisEAModule::ConvertBinaryLog)
+	);
+	IConsoleManager::Get().RegisterConsoleCommand(
+		TEXT("Iris.Incidents"),
+		TEXT("Logs the incidents (consecutive failing frames) of the current or last session, optionally between two times in seconds."),
+		FConsoleCommandWithArgsDelegate::CreateRaw(this, &FIrisEAModule::ListIncidents)
+	);
 
 #if DEBUG_FRAME_OPENCV 
 	IConsoleManager::Get().RegisterConsoleCommand(
@@ -260,6 +701,7 @@ void FIrisEAModule::MoveChart(const TArray<FString, FDefaultAllocator>& Args)
 
 	int32 Direction = FCString::Atoi(*Args[0]);
 	chartManager.MoveChart(static_cast<DataChart::EDirections>(Direction));
+	analysisContext.splitScreen.MoveCharts(static_cast<DataChart::EDirections>(Direction));
 }
 
 void FIrisEAModule::UnregisterCommands()
@@ -271,6 +713,23 @@ void FIrisEAModule::UnregisterCommands()
 	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.DebugFrame"), false);
 	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.StartAll"), false);
 	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.MoveChart"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.TieredAnalysis"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.RegionTracking"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.SplitScreen"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.HDRCapture"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.DisplayTransform"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.Checkpoint"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.ResumeSession"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.BenchmarkConversion"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.AnalyseVideoShard"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.MergeVideoShards"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.PatternDetection"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.ValidatePatternCascade"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.ValidateSplitScreen"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.SaveResults"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.SaveBinaryLog"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.ConvertBinaryLog"), false);
+	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.Incidents"), false);
 #if DEBUG_FRAME_OPENCV
 	IConsoleManager::Get().UnregisterConsoleObject(TEXT("Iris.DebugFrame"), false);
 #endif
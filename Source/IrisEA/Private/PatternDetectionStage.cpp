@@ -0,0 +1,399 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "PatternDetectionStage.h"
+#include "ConfigurationSnapshot.h"
+#include "HAL/PlatformTime.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "iris/Configuration.h"
+#include "src/ConfigurationParams.h"
+#include "src/IrisFrame.h"
+#include "src/PatternDetection.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+	//Pixels under the threshold on every other row and column of the luminance plane
+	template<typename PlaneValue>
+	int64 CountDarkPixels(const cv::Mat& luminance, double threshold)
+	{
+		int64 darkPixels = 0;
+		for (int32 y = 0; y < luminance.rows; y += 2)
+		{
+			const PlaneValue* row = luminance.ptr<PlaneValue>(y);
+			for (int32 x = 0; x < luminance.cols; x += 2)
+			{
+				darkPixels += row[x] < threshold;
+			}
+		}
+		return darkPixels;
+	}
+}
+
+PatternDetectionStage::~PatternDetectionStage()
+{
+	delete patternDetection;
+	delete validationDetection;
+	delete configuration;
+}
+
+void PatternDetectionStage::Initialize(const char* configurationPath)
+{
+	Reset();
+
+	if (configuration == nullptr)
+	{
+		//Own configuration, the pattern stage counts frames instead of using the FrameManager time windows
+		configuration = new iris::Configuration();
+		configuration->Init(configurationPath);
+		configuration->SetAnalyseByTimeStatus(false);
+		configuration->SetLuminanceType(iris::Configuration::LuminanceType::LT_RELATIVE);
+		configuration->SetPatternDetectionStatus(true);
+	}
+	timeThreshold = configuration->GetPatternDetectionParams()->timeThreshold;
+	darkLuminanceThreshold = configuration->GetPatternDetectionParams()->darkLuminanceThreshold;
+	minDarkProportion = configuration->GetPatternDetectionParams()->areaProportion / 4;
+	sampleIntervalMs = static_cast<unsigned long>(timeThreshold * 1000 / sampleDivisor);
+	patternFrames.Initialize(timeThreshold);
+}
+
+void PatternDetectionStage::SetFrameSize(const cv::Size& frameSize)
+{
+	delete patternDetection;
+
+	//The frame rate only drives the IRIS frame counter, whose verdict is replaced by the PatternFrameCounter one
+	constexpr short nominalFps = 60;
+	//IRIS sizes are {rows, cols}
+	patternDetection = new iris::PatternDetection(configuration, nominalFps, cv::Size(frameSize.height, frameSize.width));
+#if !UE_BUILD_SHIPPING
+	delete validationDetection;
+	validationDetection = new iris::PatternDetection(configuration, nominalFps, cv::Size(frameSize.height, frameSize.width));
+#endif
+	if (fourierWorkspace.IsInitialized() && fourierWorkspace.GetFrameSize() == frameSize)
+	{
+		//Warm restart, the workspaces of the last session are reused
+		return;
+	}
+
+	//A harmful pattern has at least minStripes stripes, half as many cycles, over a region of the frame
+	const int32 minFrequency = FMath::Max(1, configuration->GetPatternDetectionParams()->minStripes / 2 - 1);
+	fourierWorkspace.Initialize(frameSize, minFrequency);
+	coarseWorkspace.Initialize(cv::Size(FMath::Max(1, frameSize.width / 2), FMath::Max(1, frameSize.height / 2)), minFrequency);
+	luminanceFrame.create(frameSize, CV_32F);
+}
+
+void PatternDetectionStage::AnalyseFrame(const cv::Mat& luminance, double luminanceScale, const cv::Mat& bgrFrame, FPatternFrameResult& result)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisPatternDetection);
+
+	if (!bLastFramePattern && bHasSample && result.timeStampMs - lastSampleMs < sampleIntervalMs)
+	{
+		//Not sampled, counted at the next sample. The window holds the last sample, which had no pattern, so the frame passes
+		unsampledFrames++;
+		KeepFrame(luminance, luminanceScale, bgrFrame, result);
+		result.patternFrameResult = iris::PatternResult::Pass;
+		return;
+	}
+	const bool bPattern = SampleFrame(luminance, luminanceScale, bgrFrame, result);
+	CountKeptFrames(bPattern);
+	CountFrame(bPattern, result);
+}
+
+bool PatternDetectionStage::SampleFrame(const cv::Mat& luminance, double luminanceScale, const cv::Mat& bgrFrame, FPatternFrameResult& result)
+{
+	frames++;
+
+	if (patternDetection == nullptr || fourierWorkspace.GetFrameSize() != luminance.size() || !fourierWorkspace.IsInitialized())
+	{
+		SetFrameSize(luminance.size());
+	}
+
+	//A pattern in the last frame is followed without the cascade so its persistence is not broken
+	const double startTime = FPlatformTime::Seconds();
+	const EPatternCascadeStage stage = bLastFramePattern ? EPatternCascadeStage::Contours : RunCascade(luminance, luminanceScale);
+	cascadeSeconds += FPlatformTime::Seconds() - startTime;
+	stageFrames[static_cast<int32>(stage)]++;
+
+	bool bPattern = false;
+	if (stage == EPatternCascadeStage::Contours)
+	{
+		const double contoursStartTime = FPlatformTime::Seconds();
+		iris::FrameData patternData(result.frame, result.timeStampMs);
+		bPattern = CheckContours(luminance, luminanceScale, bgrFrame, patternData);
+		contoursSeconds += FPlatformTime::Seconds() - contoursStartTime;
+		result.patternArea = patternData.patternArea;
+		result.patternDetectedLines = patternData.patternDetectedLines;
+	}
+#if !UE_BUILD_SHIPPING
+	else if (++rejectedSinceValidation >= validationInterval)
+	{
+		rejectedSinceValidation = 0;
+		validatedFrames++;
+		iris::FrameData patternData(result.frame, result.timeStampMs);
+		if (CheckValidationContours(luminance, luminanceScale, bgrFrame, patternData))
+		{
+			validationMisses++;
+			UE_LOG(LogTemp, Warning, TEXT("Iris pattern cascade rejected frame %u at stage %d but IRIS detected a pattern"), result.frame, static_cast<int32>(stage));
+		}
+	}
+#endif
+	lastSampleMs = result.timeStampMs;
+	bHasSample = true;
+	bLastFramePattern = bPattern;
+	return bPattern;
+}
+
+void PatternDetectionStage::KeepFrame(const cv::Mat& luminance, double luminanceScale, const cv::Mat& bgrFrame, const FPatternFrameResult& result)
+{
+	if (keptPlanes == keptLuminance.Num())
+	{
+		keptLuminance.AddDefaulted();
+		keptBgr.AddDefaulted();
+	}
+	luminance.copyTo(keptLuminance[keptPlanes]);
+	bgrFrame.copyTo(keptBgr[keptPlanes]);
+	keptLuminanceScale = luminanceScale;
+	keptFrames.Add({ result.frame, result.timeStampMs, keptPlanes++ });
+}
+
+void PatternDetectionStage::CountKeptFrames(bool bSamplePattern)
+{
+	//The pattern found by the sample may have started on the kept frames, they are checked from the newest until one
+	//has no pattern. The static frames of a plane have its verdict
+	int32 onset = keptFrames.Num();
+	int32 checkedPlane = INDEX_NONE;
+	while (bSamplePattern && onset > 0)
+	{
+		const FKeptFrame& kept = keptFrames[onset - 1];
+		if (kept.plane != checkedPlane)
+		{
+			iris::FrameData patternData(kept.frame, kept.timeStampMs);
+			if (!CheckContours(keptLuminance[kept.plane], keptLuminanceScale, keptBgr[kept.plane], patternData))
+			{
+				break;
+			}
+			checkedPlane = kept.plane;
+		}
+		onset--;
+	}
+	backfilledFrames += keptFrames.Num() - onset;
+
+	//Their verdicts were given, the window of each one holds the sample before it
+	for (int32 i = 0; i < keptFrames.Num(); i++)
+	{
+		patternFrames.AddFrame(keptFrames[i].timeStampMs, i >= onset);
+	}
+	keptFrames.Reset();
+	keptPlanes = 0;
+}
+
+EPatternCascadeStage PatternDetectionStage::RunCascade(const cv::Mat& luminance, double luminanceScale)
+{
+	//The dark components of a harmful pattern are under the dark luminance threshold and cover about half of its region,
+	//which is at least AreaProportion of the frame
+	const double darkThreshold = darkLuminanceThreshold * luminanceScale;
+	const int64 darkPixels = luminance.depth() == CV_16U ? CountDarkPixels<uint16>(luminance, darkThreshold) : CountDarkPixels<float>(luminance, darkThreshold);
+	const int64 sampledPixels = static_cast<int64>((luminance.rows + 1) / 2) * ((luminance.cols + 1) / 2);
+	if (darkPixels < minDarkProportion * sampledPixels)
+	{
+		return EPatternCascadeStage::Contrast;
+	}
+
+	cv::resize(luminance, coarseLuminance, coarseWorkspace.GetFrameSize(), 0, 0, cv::INTER_AREA);
+	coarseWorkspace.ComputePowerSpectrum(coarseLuminance, luminanceScale);
+	if (coarseWorkspace.GetPeakRatio() < coarsePeakRatioThreshold)
+	{
+		return EPatternCascadeStage::CoarseSpectrum;
+	}
+
+	fourierWorkspace.ComputePowerSpectrum(luminance, luminanceScale);
+	if (fourierWorkspace.GetPeakRatio() < peakRatioThreshold)
+	{
+		return EPatternCascadeStage::Spectrum;
+	}
+	return EPatternCascadeStage::Contours;
+}
+
+bool PatternDetectionStage::CheckContours(const cv::Mat& luminance, double luminanceScale, const cv::Mat& bgrFrame, iris::FrameData& patternData)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisPatternContours);
+
+	luminance.convertTo(luminanceFrame, CV_32F, 1.0 / luminanceScale);
+
+	originalFrame = bgrFrame;
+	iris::IrisFrame irisFrame(&originalFrame, patternData);
+	irisFrame.luminanceFrame = &luminanceFrame;
+	patternDetection->checkFrame(irisFrame, static_cast<int>(patternData.Frame), patternData);
+	return patternData.patternDetectedLines > 0;
+}
+
+bool PatternDetectionStage::CheckValidationContours(const cv::Mat& luminance, double luminanceScale, const cv::Mat& bgrFrame, iris::FrameData& patternData)
+{
+	luminance.convertTo(validationLuminance, CV_32F, 1.0 / luminanceScale);
+	cv::Mat validationFrame = bgrFrame;
+	iris::IrisFrame irisFrame(&validationFrame, patternData);
+	irisFrame.luminanceFrame = &validationLuminance;
+	validationDetection->checkFrame(irisFrame, static_cast<int>(patternData.Frame), patternData);
+	return patternData.patternDetectedLines > 0;
+}
+
+bool PatternDetectionStage::AdvanceStatic(unsigned long timeStampMs)
+{
+	//The frame repeats a sampled frame, or a static frame found with a pattern once it was sampled
+	if (keptFrames.IsEmpty())
+	{
+		return patternFrames.AddFrame(timeStampMs, bLastFramePattern);
+	}
+
+	//The frame repeats a kept frame, it is kept as well until the sample interval has passed
+	const FKeptFrame repeated = keptFrames.Last();
+	if (timeStampMs - lastSampleMs < sampleIntervalMs)
+	{
+		unsampledFrames++;
+		keptFrames.Add({ repeated.frame, timeStampMs, repeated.plane });
+		return false;
+	}
+	FPatternFrameResult result;
+	result.frame = repeated.frame;
+	result.timeStampMs = timeStampMs;
+	const bool bPattern = SampleFrame(keptLuminance[repeated.plane], keptLuminanceScale, keptBgr[repeated.plane], result);
+	CountKeptFrames(bPattern);
+	return patternFrames.AddFrame(timeStampMs, bPattern);
+}
+
+void PatternDetectionStage::CountFrame(bool bPattern, FPatternFrameResult& result)
+{
+	result.patternFrameResult = patternFrames.AddFrame(result.timeStampMs, bPattern) ? iris::PatternResult::Fail : iris::PatternResult::Pass;
+}
+
+bool PatternDetectionStage::ValidateOnVideo(const char* configurationPath, const FIrisConfigurationSnapshot& settings, const FString& videoPath)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisPatternCascadeValidation);
+
+	cv::VideoCapture video(TCHAR_TO_UTF8(*videoPath));
+	if (!video.isOpened())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Iris pattern cascade validation: could not open %s"), *videoPath);
+		return false;
+	}
+	const double fps = video.get(cv::CAP_PROP_FPS) > 0.0 ? video.get(cv::CAP_PROP_FPS) : 60.0;
+
+	//Own stages and IRIS pattern detections, the session ones are not used. The reference checks every frame with IRIS,
+	//the pipeline is the stage as it runs in a session
+	PatternDetectionStage reference;
+	reference.Initialize(configurationPath);
+	PatternDetectionStage pipeline;
+	pipeline.Initialize(configurationPath);
+	FrameTileGrid grid;
+	grid.Initialize(settings);
+
+	cv::Mat frame, luminance;
+	int32 frameCount = 0, irisPatternFrames = 0, referenceFails = 0, pipelineFails = 0, verdictDifferences = 0;
+	int32 stageMisses[static_cast<int32>(EPatternCascadeStage::Count)] = {}; //pattern frames rejected by each test
+	int32 stageRejects[static_cast<int32>(EPatternCascadeStage::Count)] = {}; //frames without pattern rejected by each test
+	float minCoarseRatio = TNumericLimits<float>::Max(), minRatio = TNumericLimits<float>::Max();
+	while (video.read(frame))
+	{
+		const unsigned long timeStampMs = static_cast<unsigned long>(frameCount * 1000.0 / fps);
+		grid.ConvertRelativeLuminance(frame, luminance);
+		if (reference.patternDetection == nullptr || reference.fourierWorkspace.GetFrameSize() != luminance.size())
+		{
+			reference.SetFrameSize(luminance.size());
+		}
+
+		//Both spectra of every frame, the cascade stops at the first one under its threshold
+		const EPatternCascadeStage stage = reference.RunCascade(luminance, FrameTileGrid::LuminanceScale);
+		cv::resize(luminance, reference.coarseLuminance, reference.coarseWorkspace.GetFrameSize(), 0, 0, cv::INTER_AREA);
+		reference.coarseWorkspace.ComputePowerSpectrum(reference.coarseLuminance, FrameTileGrid::LuminanceScale);
+		reference.fourierWorkspace.ComputePowerSpectrum(luminance, FrameTileGrid::LuminanceScale);
+
+		iris::FrameData patternData(frameCount, timeStampMs);
+		const bool bIrisPattern = reference.CheckContours(luminance, FrameTileGrid::LuminanceScale, frame, patternData);
+		if (bIrisPattern)
+		{
+			irisPatternFrames++;
+			stageMisses[static_cast<int32>(stage)]++;
+			minCoarseRatio = FMath::Min(minCoarseRatio, reference.coarseWorkspace.GetPeakRatio());
+			minRatio = FMath::Min(minRatio, reference.fourierWorkspace.GetPeakRatio());
+		}
+		else
+		{
+			stageRejects[static_cast<int32>(stage)]++;
+		}
+		const bool bReferenceFail = reference.patternFrames.AddFrame(timeStampMs, bIrisPattern);
+
+		FPatternFrameResult result(patternData);
+		pipeline.AnalyseFrame(luminance, FrameTileGrid::LuminanceScale, frame, result);
+		const bool bPipelineFail = result.patternFrameResult == iris::PatternResult::Fail;
+
+		referenceFails += bReferenceFail;
+		pipelineFails += bPipelineFail;
+		verdictDifferences += bReferenceFail != bPipelineFail;
+		frameCount++;
+	}
+
+	const int32 otherFrames = frameCount - irisPatternFrames;
+	UE_LOG(LogTemp, Log, TEXT("Iris pattern cascade validation of %s: %d frames, %d with an IRIS pattern, frames without pattern rejected by contrast %.1f%%, coarse spectrum %.1f%%, spectrum %.1f%%"),
+		*videoPath, frameCount, irisPatternFrames,
+		otherFrames > 0 ? 100.0 * stageRejects[static_cast<int32>(EPatternCascadeStage::Contrast)] / otherFrames : 0.0,
+		otherFrames > 0 ? 100.0 * stageRejects[static_cast<int32>(EPatternCascadeStage::CoarseSpectrum)] / otherFrames : 0.0,
+		otherFrames > 0 ? 100.0 * stageRejects[static_cast<int32>(EPatternCascadeStage::Spectrum)] / otherFrames : 0.0);
+	if (irisPatternFrames > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Iris pattern cascade validation of %s: pattern frames rejected by contrast %d, coarse spectrum %d, spectrum %d, lowest peak ratios %.1f (coarse spectrum, threshold %.1f) and %.1f (spectrum, threshold %.1f)"),
+			*videoPath, stageMisses[static_cast<int32>(EPatternCascadeStage::Contrast)], stageMisses[static_cast<int32>(EPatternCascadeStage::CoarseSpectrum)],
+			stageMisses[static_cast<int32>(EPatternCascadeStage::Spectrum)], minCoarseRatio, reference.coarsePeakRatioThreshold, minRatio, reference.peakRatioThreshold);
+	}
+	UE_LOG(LogTemp, Log, TEXT("Iris pattern cascade validation of %s: %d PatternFail frames with IRIS on every frame, %d with the stage, %d frames with a different verdict"),
+		*videoPath, referenceFails, pipelineFails, verdictDifferences);
+	return verdictDifferences == 0;
+}
+
+void PatternDetectionStage::Reset()
+{
+	if (frames > 0)
+	{
+		//Reject rate of each stage over the frames that reached it
+		FString rejectRates;
+		int32 reachedFrames = frames;
+		const TCHAR* stageNames[] = { TEXT("contrast"), TEXT("coarse spectrum"), TEXT("spectrum") };
+		for (int32 stage = 0; stage < static_cast<int32>(EPatternCascadeStage::Contours); stage++)
+		{
+			rejectRates += FString::Printf(TEXT(" %s %.1f%%,"), stageNames[stage], reachedFrames > 0 ? 100.0 * stageFrames[stage] / reachedFrames : 0.0);
+			reachedFrames -= stageFrames[stage];
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("Iris pattern detection: %d frames sampled of %d, rejected by%s %d checked by IRIS, %.3f ms per sampled frame"),
+			frames, frames + unsampledFrames, *rejectRates, stageFrames[static_cast<int32>(EPatternCascadeStage::Contours)], (cascadeSeconds + contoursSeconds) * 1000.0 / frames);
+		if (backfilledFrames > 0)
+		{
+			UE_LOG(LogTemp, Log, TEXT("Iris pattern detection: %d frames between samples counted with the pattern found by the next sample"), backfilledFrames);
+		}
+		if (validatedFrames > 0)
+		{
+			UE_LOG(LogTemp, Log, TEXT("Iris pattern cascade validation: %d of %d rejected frames had a pattern"), validationMisses, validatedFrames);
+		}
+	}
+
+	delete patternDetection;
+	patternDetection = nullptr;
+	delete validationDetection;
+	validationDetection = nullptr;
+	originalFrame.release();
+	patternFrames.Reset();
+	bLastFramePattern = false;
+	lastSampleMs = 0;
+	bHasSample = false;
+	keptFrames.Reset();
+	keptPlanes = 0;
+	frames = 0;
+	unsampledFrames = 0;
+	backfilledFrames = 0;
+	FMemory::Memzero(stageFrames);
+	cascadeSeconds = 0.0;
+	contoursSeconds = 0.0;
+	rejectedSinceValidation = 0;
+	validatedFrames = 0;
+	validationMisses = 0;
+}
@@ -0,0 +1,61 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "PatternFrameCounter.h"
+
+void PatternFrameCounter::Initialize(float timeThresholdSeconds)
+{
+	Reset();
+	timeBarrierMs = timeThresholdSeconds * 1000.f;
+}
+
+bool PatternFrameCounter::AddFrame(unsigned long timeStampMs, bool bPattern)
+{
+	//FrameManager window, the sum of the times between the frames in the window plus the new one is the time since the first
+	bool bFull = false;
+	while (!frameTimeStamps.IsEmpty() && timeStampMs >= frameTimeStamps[0] && timeStampMs - frameTimeStamps[0] >= timeBarrierMs)
+	{
+		frameTimeStamps.RemoveAt(0, 1, EAllowShrinking::No);
+		UpdatePassed();
+		bFull = true;
+	}
+
+	//Counter::updateCurrent
+	frameTimeStamps.Add(timeStampMs);
+	if (count.IsEmpty())
+	{
+		count.Add(bPattern ? 1 : 0);
+		current = count.Last();
+	}
+	else
+	{
+		count.Add(count.Last() + (bPattern ? 1 : 0));
+		current = count.Last() - passed;
+	}
+
+	//A gap longer than the window empties it, the frame count of the last full window is kept
+	if (bFull && frameTimeStamps.Num() > 1)
+	{
+		frameTimeThresh = frameTimeStamps.Num();
+	}
+	return frameTimeThresh > 0 && current >= frameTimeThresh;
+}
+
+void PatternFrameCounter::UpdatePassed()
+{
+	passed = count[0];
+	count.RemoveAt(0, 1, EAllowShrinking::No);
+	if (count.IsEmpty())
+	{
+		passed = 0;
+		current = 0;
+	}
+}
+
+void PatternFrameCounter::Reset()
+{
+	frameTimeStamps.Reset();
+	count.Reset();
+	passed = 0;
+	current = 0;
+	frameTimeThresh = 0;
+}
@@ -5,14 +5,72 @@
 #include "PixelCaptureUtils.h"
 #include "PixelCaptureOutputFrameBGR.h"
 #include "PixelCaptureBufferFormat.h"
+#include "Misc/ScopeLock.h"
 
-TSharedPtr<PixelCaptureCapturerRHIToBGRMat> PixelCaptureCapturerRHIToBGRMat::Create(float InScale)
+void ReadbackSlotPool::Initialize(const FRHITextureCreateDesc& readbackDesc, int32 slotCount)
 {
-	return TSharedPtr<PixelCaptureCapturerRHIToBGRMat>(new PixelCaptureCapturerRHIToBGRMat(InScale));
+	for (int32 i = 0; i < slotCount; i++)
+	{
+		FIrisReadbackSlot* slot = new FIrisReadbackSlot();
+		slot->texture = RHICreateTexture(readbackDesc);
+
+		int32 bufferWidth = 0, bufferHeight = 0;
+		GDynamicRHI->RHIMapStagingSurface(slot->texture, nullptr, slot->data, bufferWidth, bufferHeight);
+		slot->stride = bufferWidth;
+		freeSlots.Add(slot);
+	}
+}
+
+TSharedPtr<FIrisReadbackSlot, ESPMode::ThreadSafe> ReadbackSlotPool::Acquire()
+{
+	FScopeLock scopeLock(&lock);
+	if (bClosed || freeSlots.IsEmpty())
+	{
+		return nullptr;
+	}
+	//The deleter keeps the pool alive until the slot is back
+	TSharedRef<ReadbackSlotPool, ESPMode::ThreadSafe> pool = AsShared();
+	return TSharedPtr<FIrisReadbackSlot, ESPMode::ThreadSafe>(freeSlots.Pop(EAllowShrinking::No), [pool](FIrisReadbackSlot* slot) { pool->Release(slot); });
+}
+
+void ReadbackSlotPool::Release(FIrisReadbackSlot* slot)
+{
+	FScopeLock scopeLock(&lock);
+	if (bClosed)
+	{
+		Unmap(slot);
+	}
+	else
+	{
+		freeSlots.Add(slot);
+	}
 }
 
-PixelCaptureCapturerRHIToBGRMat::PixelCaptureCapturerRHIToBGRMat(float InScale)
+void ReadbackSlotPool::Close()
+{
+	FScopeLock scopeLock(&lock);
+	bClosed = true;
+	for (FIrisReadbackSlot* slot : freeSlots)
+	{
+		Unmap(slot);
+	}
+	freeSlots.Reset();
+}
+
+void ReadbackSlotPool::Unmap(FIrisReadbackSlot* slot)
+{
+	GDynamicRHI->RHIUnmapStagingSurface(slot->texture);
+	delete slot;
+}
+
+TSharedPtr<PixelCaptureCapturerRHIToBGRMat> PixelCaptureCapturerRHIToBGRMat::Create(float InScale, EPixelFormat InFormat)
+{
+	return TSharedPtr<PixelCaptureCapturerRHIToBGRMat>(new PixelCaptureCapturerRHIToBGRMat(InScale, InFormat));
+}
+
+PixelCaptureCapturerRHIToBGRMat::PixelCaptureCapturerRHIToBGRMat(float InScale, EPixelFormat InFormat)
 	: Scale(InScale)
+	, Format(InFormat)
 {
 }
 
@@ -27,7 +85,7 @@ void PixelCaptureCapturerRHIToBGRMat::Initialize(int32 InputWidth, int32 InputHe
 	const int32 Height = InputHeight * Scale;
 
 	FRHITextureCreateDesc TextureDesc =
-		FRHITextureCreateDesc::Create2D(TEXT("FPixelCaptureCapturerRHIToBGRMat StagingTexture"), Width, Height, EPixelFormat::PF_B8G8R8A8)
+		FRHITextureCreateDesc::Create2D(TEXT("FPixelCaptureCapturerRHIToBGRMat StagingTexture"), Width, Height, Format)
 		.SetClearValue(FClearValueBinding::None)
 		.SetFlags(ETextureCreateFlags::RenderTargetable)
 		.SetInitialState(ERHIAccess::CopySrc)
@@ -45,17 +103,21 @@ void PixelCaptureCapturerRHIToBGRMat::Initialize(int32 InputWidth, int32 InputHe
 	StagingTexture = RHICreateTexture(TextureDesc);
 
 	FRHITextureCreateDesc ReadbackDesc =
-		FRHITextureCreateDesc::Create2D(TEXT("FPixelCaptureCapturerRHIToBGRMat ReadbackTexture"), Width, Height, EPixelFormat::PF_B8G8R8A8)
+		FRHITextureCreateDesc::Create2D(TEXT("FPixelCaptureCapturerRHIToBGRMat ReadbackTexture"), Width, Height, Format)
 		.SetClearValue(FClearValueBinding::None)
 		.SetFlags(ETextureCreateFlags::CPUReadback)
 		.SetInitialState(ERHIAccess::CPURead)
 		.DetermineInititialState();
 
-	ReadbackTexture = RHICreateTexture(ReadbackDesc);
-
+	//The readback textures stay mapped, the analysis reads the frames in place
+	CleanUp();
+	ReadbackSlots = MakeShared<ReadbackSlotPool, ESPMode::ThreadSafe>();
+	ReadbackSlots->Initialize(ReadbackDesc, ReadbackSlotCount);
+	SpareSlot = MakeShared<FIrisReadbackSlot, ESPMode::ThreadSafe>();
+	SpareSlot->texture = RHICreateTexture(ReadbackDesc);
 	int32 BufferWidth = 0, BufferHeight = 0;
-	GDynamicRHI->RHIMapStagingSurface(ReadbackTexture, nullptr, ResultsBuffer, BufferWidth, BufferHeight);
-	MappedStride = BufferWidth;
+	GDynamicRHI->RHIMapStagingSurface(SpareSlot->texture, nullptr, SpareSlot->data, BufferWidth, BufferHeight);
+	SpareSlot->stride = BufferWidth;
 
 	FPixelCaptureCapturer::Initialize(InputWidth, InputHeight);
 }
@@ -84,23 +146,31 @@ void PixelCaptureCapturerRHIToBGRMat::BeginProcess(const IPixelCaptureInputFrame
 	RHICmdList.Transition(FRHITransitionInfo(StagingTexture, ERHIAccess::CopySrc, ERHIAccess::CopyDest));
 	CopyTexture(RHICmdList, SourceTexture, StagingTexture, nullptr);
 
+	//A slot given back by the frames, the spare one when the analysis holds all of them
+	TSharedPtr<FIrisReadbackSlot, ESPMode::ThreadSafe> Slot = ReadbackSlots->Acquire();
+	const bool bCopy = !Slot.IsValid();
+	if (bCopy)
+	{
+		Slot = SpareSlot;
+	}
+
 	RHICmdList.Transition(FRHITransitionInfo(StagingTexture, ERHIAccess::CopyDest, ERHIAccess::CopySrc));
-	RHICmdList.Transition(FRHITransitionInfo(ReadbackTexture, ERHIAccess::CPURead, ERHIAccess::CopyDest));
-	RHICmdList.CopyTexture(StagingTexture, ReadbackTexture, {});
+	RHICmdList.Transition(FRHITransitionInfo(Slot->texture, ERHIAccess::CPURead, ERHIAccess::CopyDest));
+	RHICmdList.CopyTexture(StagingTexture, Slot->texture, {});
 
-	RHICmdList.Transition(FRHITransitionInfo(ReadbackTexture, ERHIAccess::CopyDest, ERHIAccess::CPURead));
+	RHICmdList.Transition(FRHITransitionInfo(Slot->texture, ERHIAccess::CopyDest, ERHIAccess::CPURead));
 
 	MarkCPUWorkEnd();
 
 	// by adding this shared ref to the rhi lambda we can ensure that 'this' will not be destroyed
 	// until after the rhi thread is done with it, so all the commands will still have valid references.
 	TSharedRef<PixelCaptureCapturerRHIToBGRMat> ThisRHIRef = StaticCastSharedRef<PixelCaptureCapturerRHIToBGRMat>(AsShared());
-	RHICmdList.EnqueueLambda([ThisRHIRef, OutputBuffer](FRHICommandListImmediate&) {
-		ThisRHIRef->OnRHIStageComplete(OutputBuffer);
+	RHICmdList.EnqueueLambda([ThisRHIRef, OutputBuffer, Slot, bCopy](FRHICommandListImmediate&) {
+		ThisRHIRef->OnRHIStageComplete(OutputBuffer, Slot, bCopy);
 		});
 }
 
-void PixelCaptureCapturerRHIToBGRMat::OnRHIStageComplete(IPixelCaptureOutputFrame* OutputBuffer)
+void PixelCaptureCapturerRHIToBGRMat::OnRHIStageComplete(IPixelCaptureOutputFrame* OutputBuffer, TSharedPtr<FIrisReadbackSlot, ESPMode::ThreadSafe> Slot, bool bCopy)
 {
 	MarkGPUWorkEnd();
 	MarkCPUWorkStart();
@@ -108,9 +178,17 @@ void PixelCaptureCapturerRHIToBGRMat::OnRHIStageComplete(IPixelCaptureOutputFram
 	int32 Height = OutputBuffer->GetHeight();
 	int32 Width = OutputBuffer->GetWidth();
 	
-	cv::Mat OutpuMat(Height, Width, CV_8UC4, ResultsBuffer, MappedStride*4);
-	cv::cvtColor(OutpuMat, OutpuMat, cv::ColorConversionCodes::COLOR_BGRA2BGR);
-	static_cast<PixelCaptureOutputFrameBGR*>(OutputBuffer)->SetMat(OutpuMat);
+	//Strided view of the mapped slot, no conversion: the analysis converts the pixels it needs straight from it
+	const int32 MatType = Format == PF_FloatRGBA ? CV_16FC4 : CV_8UC4;
+	cv::Mat OutpuMat(Height, Width, MatType, Slot->data, Slot->stride * GPixelFormats[Format].BlockBytes);
+	if (bCopy)
+	{
+		static_cast<PixelCaptureOutputFrameBGR*>(OutputBuffer)->SetMat(OutpuMat.clone(), nullptr);
+	}
+	else
+	{
+		static_cast<PixelCaptureOutputFrameBGR*>(OutputBuffer)->SetMat(OutpuMat, Slot);
+	}
 
 	MarkCPUWorkEnd();
 	EndProcess();
@@ -118,9 +196,16 @@ void PixelCaptureCapturerRHIToBGRMat::OnRHIStageComplete(IPixelCaptureOutputFram
 
 void PixelCaptureCapturerRHIToBGRMat::CleanUp()
 {
-	if (ReadbackTexture)
+	//The slots held by frames stay mapped until the frames release them
+	if (ReadbackSlots.IsValid())
+	{
+		ReadbackSlots->Close();
+		ReadbackSlots.Reset();
+	}
+	//Only referenced while its frame is copied, which keeps the capturer alive
+	if (SpareSlot.IsValid())
 	{
-		GDynamicRHI->RHIUnmapStagingSurface(ReadbackTexture);
+		GDynamicRHI->RHIUnmapStagingSurface(SpareSlot->texture);
+		SpareSlot.Reset();
 	}
-	ResultsBuffer = nullptr;
 }
@@ -0,0 +1,423 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "RawFrameIngest.h"
+#include "AsyncAnalysis.h"
+#include "ConfigurationSnapshot.h"
+#include "FrameDataBinaryLog.h"
+#include "IrisAnalysisContext.h"
+#include "StaticFrameFilter.h"
+#include "AnalysisCheckpoint.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Async/ParallelFor.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "iris/Configuration.h"
+THIRD_PARTY_INCLUDES_END
+
+/**
+ * Headless analyser behind the raw buffer API: its own configuration and analysis context, without session outputs,
+ * analysed synchronously on the caller thread
+ */
+class RawFrameAnalyser
+{
+public:
+	~RawFrameAnalyser();
+
+	/// <summary>
+	//Loads the configuration and begins the analysis, a video session when videoPath is set
+	/// </summary>
+	bool Initialize(const FString& configurationDir, const FString& videoPath, int32 width, int32 height, float waitSeconds);
+
+	/// <summary>
+	//Initializes the analyser from a checkpoint: the warm-up tail is replayed and the frames continue its numbering
+	/// </summary>
+	bool Resume(const FString& configurationDir, const FString& checkpointPath, float intervalSeconds, float waitSeconds);
+
+	void EnableCheckpoints(const FString& checkpointPath, float intervalSeconds);
+
+	bool SetFrameOrigin(uint32 firstFrame, uint64 timeOriginUs);
+
+	EIrisIngestStatus AnalyseFrame(const FIrisRawFrame& rawFrame, FIrisFrameRecord& outResult);
+
+	EIrisIngestStatus AnalyseFrames(TArrayView<const FIrisRawFrame> rawFrames, TArrayView<FIrisFrameRecord> outResults);
+
+private:
+
+	bool LoadConfiguration(const FString& configurationDir);
+
+	/// <summary>
+	//Begins the session once the IRIS library is free, false if it is still held after waitSeconds
+	/// </summary>
+	bool BeginAnalysis(const FString& configurationDir, int32 width, int32 height, float waitSeconds);
+
+	/// <summary>
+	//Wraps the buffer of a checked frame in outFrame, converted to BGR in convertedBuffer when the format can not be analysed in place
+	/// </summary>
+	static EIrisIngestStatus ConvertFrame(const FIrisRawFrame& rawFrame, cv::Mat& convertedBuffer, cv::Mat& outFrame);
+
+	EIrisIngestStatus CheckFrame(const FIrisRawFrame& rawFrame) const;
+
+	iris::FrameData MakeFrameData(uint64 timeStampUs);
+
+	//Shared with the analysers of the process loading the same configuration, it outlives the context
+	TSharedPtr<FIrisSharedConfiguration, ESPMode::ThreadSafe> sharedConfiguration;
+	FIrisAnalysisContext context;
+	AsyncAnalysis analysis{ context };
+
+	FIrisFrame frame;
+	cv::Mat convertedFrame; //BGR conversion of the formats not analysed in place, reused between frames
+
+	//Frames of the last batch chunk and their BGR conversions, reused by the next one
+	TArray<FIrisFrame> batchFrames;
+	TArray<cv::Mat> batchConvertedFrames;
+	int32 frameWidth = 0;
+	int32 frameHeight = 0;
+	unsigned int frameIndex = 0;
+	uint64 firstTimeStampUs = 0;
+	bool bHasTimeOrigin = false;
+
+	AnalysisCheckpoint checkpoint;
+};
+
+namespace
+{
+	int32 GetBytesPerPixel(EIrisPixelFormat format)
+	{
+		switch (format)
+		{
+		case EIrisPixelFormat::BGRA8:
+		case EIrisPixelFormat::RGBA8:
+			return 4;
+		case EIrisPixelFormat::BGR8:
+			return 3;
+		case EIrisPixelFormat::NV12:
+			return 1; //Y plane
+		case EIrisPixelFormat::RGBA16F:
+			return 8;
+		default:
+			return 0;
+		}
+	}
+}
+
+RawFrameAnalyser::~RawFrameAnalyser()
+{
+	if (context.bActive)
+	{
+		context.bActive = false;
+		analysis.EndAnalysis();
+	}
+	context.Release();
+}
+
+bool RawFrameAnalyser::Initialize(const FString& configurationDir, const FString& videoPath, int32 width, int32 height, float waitSeconds)
+{
+	if (!LoadConfiguration(configurationDir))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris raw analyser could not load the configuration of %s"), *configurationDir);
+		return false;
+	}
+	context.videoPath = videoPath;
+	return BeginAnalysis(configurationDir, width, height, waitSeconds);
+}
+
+bool RawFrameAnalyser::Resume(const FString& configurationDir, const FString& checkpointPath, float intervalSeconds, float waitSeconds)
+{
+	if (!LoadConfiguration(configurationDir))
+	{
+		return false;
+	}
+	const FIrisConfigurationSnapshot& settings = sharedConfiguration->snapshot.GetSnapshot();
+	if (!checkpoint.Load(checkpointPath, settings.contentHash))
+	{
+		return false;
+	}
+	const cv::Size size = checkpoint.GetFrameSize();
+	if (size.width < FrameTileGrid::TilesX || size.height < FrameTileGrid::TilesY)
+	{
+		return false;
+	}
+	checkpoint.Begin(checkpointPath, intervalSeconds, settings.contentHash, settings.extendedFailWindow);
+	context.checkpoint = &checkpoint;
+	frameIndex = checkpoint.GetNextFrame();
+	firstTimeStampUs = checkpoint.GetTimeOrigin();
+	bHasTimeOrigin = true;
+	return BeginAnalysis(configurationDir, size.width, size.height, waitSeconds);
+}
+
+void RawFrameAnalyser::EnableCheckpoints(const FString& checkpointPath, float intervalSeconds)
+{
+	const FIrisConfigurationSnapshot& settings = sharedConfiguration->snapshot.GetSnapshot();
+	checkpoint.Begin(checkpointPath, intervalSeconds, settings.contentHash, settings.extendedFailWindow);
+	checkpoint.SetTimeOrigin(firstTimeStampUs);
+	context.checkpoint = &checkpoint;
+}
+
+bool RawFrameAnalyser::SetFrameOrigin(uint32 firstFrame, uint64 timeOriginUs)
+{
+	if (bHasTimeOrigin)
+	{
+		return false;
+	}
+	frameIndex = firstFrame;
+	firstTimeStampUs = timeOriginUs;
+	bHasTimeOrigin = true;
+	checkpoint.SetTimeOrigin(timeOriginUs);
+	return true;
+}
+
+bool RawFrameAnalyser::LoadConfiguration(const FString& configurationDir)
+{
+	//Analysers created for the same configuration skip the JSON parse
+	sharedConfiguration = ConfigurationSnapshot::LoadShared(configurationDir);
+	return sharedConfiguration.IsValid();
+}
+
+bool RawFrameAnalyser::BeginAnalysis(const FString& configurationDir, int32 width, int32 height, float waitSeconds)
+{
+	frameWidth = width;
+	frameHeight = height;
+	context.Initialize(sharedConfiguration->configuration.Get(), &sharedConfiguration->snapshot);
+	if (!context.BeginSession({ height, width }, { height, width }, TCHAR_TO_UTF8(*configurationDir), waitSeconds))
+	{
+		return false;
+	}
+	analysis.BeginAnalysis();
+	return true;
+}
+
+EIrisIngestStatus RawFrameAnalyser::ConvertFrame(const FIrisRawFrame& rawFrame, cv::Mat& convertedBuffer, cv::Mat& outFrame)
+{
+	//The frame was checked by CheckFrame
+	const int32 stride = rawFrame.stride > 0 ? rawFrame.stride : rawFrame.width * GetBytesPerPixel(rawFrame.format);
+	//The analysis only reads the buffer
+	uint8* data = const_cast<uint8*>(rawFrame.data);
+
+	switch (rawFrame.format)
+	{
+	case EIrisPixelFormat::BGRA8:
+		outFrame = cv::Mat(rawFrame.height, rawFrame.width, CV_8UC4, data, stride);
+		return EIrisIngestStatus::Ok;
+	case EIrisPixelFormat::BGR8:
+		outFrame = cv::Mat(rawFrame.height, rawFrame.width, CV_8UC3, data, stride);
+		return EIrisIngestStatus::Ok;
+	case EIrisPixelFormat::RGBA8:
+		cv::cvtColor(cv::Mat(rawFrame.height, rawFrame.width, CV_8UC4, data, stride), convertedBuffer, cv::COLOR_RGBA2BGR);
+		break;
+	case EIrisPixelFormat::NV12:
+	{
+		uint8* uvData = const_cast<uint8*>(rawFrame.uvData);
+		const int32 uvStride = rawFrame.uvStride > 0 ? rawFrame.uvStride : stride;
+		cv::cvtColorTwoPlane(cv::Mat(rawFrame.height, rawFrame.width, CV_8UC1, data, stride),
+			cv::Mat(rawFrame.height / 2, rawFrame.width / 2, CV_8UC2, uvData, uvStride), convertedBuffer, cv::COLOR_YUV2BGR_NV12);
+		break;
+	}
+	case EIrisPixelFormat::RGBA16F:
+		outFrame = cv::Mat(rawFrame.height, rawFrame.width, CV_16FC4, data, stride);
+		return EIrisIngestStatus::Ok;
+	default:
+		return EIrisIngestStatus::UnsupportedFormat;
+	}
+	outFrame = convertedBuffer;
+	return EIrisIngestStatus::Ok;
+}
+
+EIrisIngestStatus RawFrameAnalyser::AnalyseFrame(const FIrisRawFrame& rawFrame, FIrisFrameRecord& outResult)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisAnalyseRawFrame);
+
+	EIrisIngestStatus status = CheckFrame(rawFrame);
+	if (status == EIrisIngestStatus::Ok)
+	{
+		status = ConvertFrame(rawFrame, convertedFrame, frame.frameMatrix);
+	}
+	if (status != EIrisIngestStatus::Ok)
+	{
+		return status;
+	}
+
+	frame.frameData = MakeFrameData(rawFrame.timeStampUs);
+
+	analysis.AnalyseFrame(frame);
+	FrameDataBinaryLog::ToRecord(frame.frameData, outResult);
+
+	//The buffer belongs to the caller, it is not referenced after the call
+	frame.frameMatrix.release();
+	return EIrisIngestStatus::Ok;
+}
+
+EIrisIngestStatus RawFrameAnalyser::AnalyseFrames(TArrayView<const FIrisRawFrame> rawFrames, TArrayView<FIrisFrameRecord> outResults)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisAnalyseRawFrames);
+
+	if (outResults.Num() < rawFrames.Num())
+	{
+		return EIrisIngestStatus::InvalidArguments;
+	}
+	for (const FIrisRawFrame& rawFrame : rawFrames)
+	{
+		const EIrisIngestStatus status = CheckFrame(rawFrame);
+		if (status != EIrisIngestStatus::Ok)
+		{
+			return status;
+		}
+	}
+
+	//The frames are wrapped and converted a chunk at a time, the batch buffers hold one chunk whatever the batch size.
+	//Checked frames always convert
+	for (int32 first = 0; first < rawFrames.Num(); first += AsyncAnalysis::BatchChunkFrames)
+	{
+		const int32 count = FMath::Min(AsyncAnalysis::BatchChunkFrames, rawFrames.Num() - first);
+		batchFrames.SetNum(FMath::Max(batchFrames.Num(), count));
+		batchConvertedFrames.SetNum(FMath::Max(batchConvertedFrames.Num(), count));
+		ParallelFor(count, [this, &rawFrames, first](int32 i)
+			{
+				ConvertFrame(rawFrames[first + i], batchConvertedFrames[i], batchFrames[i].frameMatrix);
+			});
+
+		for (int32 i = 0; i < count; i++)
+		{
+			batchFrames[i].frameData = MakeFrameData(rawFrames[first + i].timeStampUs);
+			//Computed by the batch analysis
+			batchFrames[i].tileSignatures.Reset();
+		}
+		analysis.AnalyseFrames(TArrayView<FIrisFrame>(batchFrames.GetData(), count));
+		for (int32 i = 0; i < count; i++)
+		{
+			FrameDataBinaryLog::ToRecord(batchFrames[i].frameData, outResults[first + i]);
+			batchFrames[i].frameMatrix.release();
+		}
+	}
+	return EIrisIngestStatus::Ok;
+}
+
+EIrisIngestStatus RawFrameAnalyser::CheckFrame(const FIrisRawFrame& rawFrame) const
+{
+	if (rawFrame.data == nullptr)
+	{
+		return EIrisIngestStatus::InvalidArguments;
+	}
+	if (rawFrame.width != frameWidth || rawFrame.height != frameHeight)
+	{
+		return EIrisIngestStatus::SizeMismatch;
+	}
+	switch (rawFrame.format)
+	{
+	case EIrisPixelFormat::BGRA8:
+	case EIrisPixelFormat::BGR8:
+	case EIrisPixelFormat::RGBA8:
+	case EIrisPixelFormat::RGBA16F:
+		break;
+	case EIrisPixelFormat::NV12:
+		//A UV plane row holds width / 2 interleaved UV pairs, as many bytes as a Y row
+		if (rawFrame.width % 2 != 0 || rawFrame.height % 2 != 0 || rawFrame.uvData == nullptr
+			|| rawFrame.uvStride < 0 || (rawFrame.uvStride > 0 && rawFrame.uvStride < rawFrame.width))
+		{
+			return EIrisIngestStatus::InvalidArguments;
+		}
+		break;
+	default:
+		return EIrisIngestStatus::UnsupportedFormat;
+	}
+	if (rawFrame.stride < 0 || (rawFrame.stride > 0 && rawFrame.stride < rawFrame.width * GetBytesPerPixel(rawFrame.format)))
+	{
+		return EIrisIngestStatus::InvalidArguments;
+	}
+	return EIrisIngestStatus::Ok;
+}
+
+iris::FrameData RawFrameAnalyser::MakeFrameData(uint64 timeStampUs)
+{
+	if (!bHasTimeOrigin)
+	{
+		firstTimeStampUs = timeStampUs;
+		bHasTimeOrigin = true;
+		checkpoint.SetTimeOrigin(firstTimeStampUs);
+	}
+	const uint64 timeStampMs = (FMath::Max(timeStampUs, firstTimeStampUs) - firstTimeStampUs) / 1000;
+	return iris::FrameData(frameIndex++, static_cast<unsigned long>(timeStampMs));
+}
+
+RawFrameAnalyser* IrisCreateRawAnalyser(const TCHAR* configurationDir, int32 width, int32 height, float waitSeconds)
+{
+	if (configurationDir == nullptr || width < FrameTileGrid::TilesX || height < FrameTileGrid::TilesY)
+	{
+		return nullptr;
+	}
+	RawFrameAnalyser* analyser = new RawFrameAnalyser();
+	if (!analyser->Initialize(configurationDir, FString(), width, height, waitSeconds))
+	{
+		delete analyser;
+		return nullptr;
+	}
+	return analyser;
+}
+
+RawFrameAnalyser* IrisCreateRawVideoAnalyser(const TCHAR* configurationDir, const TCHAR* videoPath, int32 width, int32 height, float waitSeconds)
+{
+	if (configurationDir == nullptr || videoPath == nullptr || width < FrameTileGrid::TilesX || height < FrameTileGrid::TilesY)
+	{
+		return nullptr;
+	}
+	RawFrameAnalyser* analyser = new RawFrameAnalyser();
+	if (!analyser->Initialize(configurationDir, videoPath, width, height, waitSeconds))
+	{
+		delete analyser;
+		return nullptr;
+	}
+	return analyser;
+}
+
+EIrisIngestStatus IrisAnalyseRawFrame(RawFrameAnalyser* analyser, const FIrisRawFrame& frame, FIrisFrameRecord& outResult)
+{
+	if (analyser == nullptr)
+	{
+		return EIrisIngestStatus::InvalidArguments;
+	}
+	return analyser->AnalyseFrame(frame, outResult);
+}
+
+EIrisIngestStatus IrisAnalyseRawFrames(RawFrameAnalyser* analyser, TArrayView<const FIrisRawFrame> frames, TArrayView<FIrisFrameRecord> outResults)
+{
+	if (analyser == nullptr)
+	{
+		return EIrisIngestStatus::InvalidArguments;
+	}
+	return analyser->AnalyseFrames(frames, outResults);
+}
+
+RawFrameAnalyser* IrisResumeRawAnalyser(const TCHAR* configurationDir, const TCHAR* checkpointPath, float intervalSeconds, float waitSeconds)
+{
+	if (configurationDir == nullptr || checkpointPath == nullptr)
+	{
+		return nullptr;
+	}
+	RawFrameAnalyser* analyser = new RawFrameAnalyser();
+	if (!analyser->Resume(configurationDir, checkpointPath, intervalSeconds, waitSeconds))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris raw analyser could not resume from %s"), checkpointPath);
+		delete analyser;
+		return nullptr;
+	}
+	return analyser;
+}
+
+bool IrisSetRawFrameOrigin(RawFrameAnalyser* analyser, uint32 firstFrame, uint64 timeOriginUs)
+{
+	return analyser != nullptr && analyser->SetFrameOrigin(firstFrame, timeOriginUs);
+}
+
+bool IrisEnableRawCheckpoints(RawFrameAnalyser* analyser, const TCHAR* checkpointPath, float intervalSeconds)
+{
+	if (analyser == nullptr || checkpointPath == nullptr || intervalSeconds <= 0.f)
+	{
+		return false;
+	}
+	analyser->EnableCheckpoints(checkpointPath, intervalSeconds);
+	return true;
+}
+
+void IrisDestroyRawAnalyser(RawFrameAnalyser* analyser)
+{
+	delete analyser;
+}
@@ -0,0 +1,143 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "RegionTransitionTracker.h"
+#include "Misc/ScopeLock.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "src/ConfigurationParams.h"
+THIRD_PARTY_INCLUDES_END
+
+void RegionTransitionTracker::Initialize(const iris::FlashParams& luminanceParams, const iris::FlashParams& redParams, const iris::TransitionTrackerParams& transitionParams)
+{
+	luminanceThreshold = luminanceParams.flashThreshold;
+	luminanceDarkThreshold = luminanceParams.darkThreshold;
+	luminanceArea = luminanceParams.areaProportion;
+	redThreshold = redParams.flashThreshold;
+	redDarkThreshold = redParams.darkThreshold;
+	redArea = redParams.areaProportion;
+	maxTransitions = transitionParams.maxTransitions;
+	Reset();
+}
+
+void RegionTransitionTracker::Update(const TArray<FTileStats>& tileStats, unsigned long timeStampMs)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisRegionTransitions);
+
+	for (int32 region = 0; region < RegionCount; region++)
+	{
+		const FTileStats& stats = tileStats[region];
+		const float pixels = FMath::Max(stats.pixels, 1);
+
+		//Same as the frame level check, the variation only counts if enough of the region area changed
+		luminanceDiff[region] = stats.luminanceOverThreshold >= luminanceArea * pixels ? stats.luminanceDiffSum / pixels : 0.f;
+		redDiff[region] = stats.redOverThreshold >= redArea * pixels ? stats.redDiffSum / pixels : 0.f;
+		luminanceMean[region] = stats.luminanceSum / pixels;
+		redMean[region] = stats.redSum / pixels;
+	}
+
+	if (!bHasLastFrame)
+	{
+		//First frame has 0 variation
+		FMemory::Memcpy(lastLuminanceMean, luminanceMean, sizeof(luminanceMean));
+		FMemory::Memcpy(lastRedMean, redMean, sizeof(redMean));
+		bHasLastFrame = true;
+	}
+
+	CheckTransitions(luminanceDiff, luminanceMean, lastLuminanceMean, luminanceDiffAcc, luminanceThreshold, luminanceDarkThreshold, newLuminanceTransitions);
+	CheckTransitions(redDiff, redMean, lastRedMean, redDiffAcc, redThreshold, redDarkThreshold, newRedTransitions);
+	PushTransitions(timeStampMs);
+}
+
+void RegionTransitionTracker::AdvanceStatic(unsigned long timeStampMs)
+{
+	FMemory::Memzero(newLuminanceTransitions);
+	FMemory::Memzero(newRedTransitions);
+	PushTransitions(timeStampMs);
+}
+
+void RegionTransitionTracker::CheckTransitions(const float* avgDiff, const float* mean, float* lastMean, float* avgDiffAcc, float threshold, float darkThreshold, uint8* newTransitions)
+{
+	for (int32 region = 0; region < RegionCount; region++)
+	{
+		newTransitions[region] = FlashTransitionRules::CheckTransition(avgDiff[region], mean[region], lastMean[region], avgDiffAcc[region], threshold, darkThreshold);
+	}
+}
+
+void RegionTransitionTracker::PushTransitions(unsigned long timeStampMs)
+{
+	luminanceWindow.Push(timeStampMs, newLuminanceTransitions);
+	redWindow.Push(timeStampMs, newRedTransitions);
+	const uint8* luminanceTransitions = luminanceWindow.GetTransitions();
+	const uint8* redTransitions = redWindow.GetTransitions();
+
+	FScopeLock lock(&heatmapSection);
+	heatmap.SetNumUninitialized(RegionCount);
+	for (int32 region = 0; region < RegionCount; region++)
+	{
+		heatmap[region] = FMath::Max(luminanceTransitions[region], redTransitions[region]);
+	}
+}
+
+void RegionTransitionTracker::GetFailingRegions(bool bRed, TArray<int32>& outRegions) const
+{
+	outRegions.Reset();
+	const uint8* transitions = bRed ? redWindow.GetTransitions() : luminanceWindow.GetTransitions();
+	for (int32 region = 0; region < RegionCount; region++)
+	{
+		if (transitions[region] > maxTransitions)
+		{
+			outRegions.Add(region);
+		}
+	}
+}
+
+void RegionTransitionTracker::GetHeatmap(TArray<uint8>& outTransitions) const
+{
+	FScopeLock lock(&heatmapSection);
+	outTransitions = heatmap;
+}
+
+void RegionTransitionTracker::DrawHeatmap(cv::Mat& frame) const
+{
+	TArray<uint8> transitions;
+	GetHeatmap(transitions);
+
+	for (int32 region = 0; region < transitions.Num(); region++)
+	{
+		if (transitions[region] == 0)
+		{
+			continue;
+		}
+		//Green to yellow to red as the transitions get closer to the max transitions
+		const float proportion = FMath::Min(1.f, transitions[region] / static_cast<float>(maxTransitions + 1));
+		const cv::Scalar color(0, 255 * FMath::Min(1.f, 2.f * (1.f - proportion)), 255 * FMath::Min(1.f, 2.f * proportion));
+
+		cv::Mat tile = frame(FrameTileGrid::GetTileRect(frame.size(), region));
+		cv::Mat overlay(tile.size(), tile.type(), color);
+		cv::addWeighted(overlay, 0.4, tile, 0.6, 0.0, tile);
+		cv::putText(tile, std::to_string(transitions[region]), cv::Point(4, 14), cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 255, 255));
+	}
+}
+
+FString RegionTransitionTracker::DescribeRegions(const TArray<int32>& regions)
+{
+	FString description;
+	for (int32 region : regions)
+	{
+		description += FString::Printf(TEXT("(%d,%d)"), region % FrameTileGrid::TilesX, region / FrameTileGrid::TilesX);
+	}
+	return description;
+}
+
+void RegionTransitionTracker::Reset()
+{
+	FMemory::Memzero(luminanceDiffAcc);
+	FMemory::Memzero(redDiffAcc);
+	luminanceWindow.Reset();
+	redWindow.Reset();
+	bHasLastFrame = false;
+
+	FScopeLock lock(&heatmapSection);
+	heatmap.Reset();
+}
@@ -0,0 +1,297 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "SessionResultsWriter.h"
+#include "HAL/PlatformFileManager.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/Event.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "utils/JsonWrapper.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+	//iris::FrameDataJson columns, in to_json order
+	const char* FrameDataColumnNames[] = {
+		"Frame",
+		"TimeStampString",
+		"AverageLuminance",
+		"FlashAreaLuminance",
+		"AverageLuminanceDiff",
+		"AverageLuminanceDiffAcc",
+		"AverageRed",
+		"FlashAreaRed",
+		"AverageRedDiff",
+		"AverageRedDiffAcc",
+		"LuminanceTransitions",
+		"RedTransitions",
+		"LuminanceExtendedFailCount",
+		"RedExtendedFailCount",
+		"LuminanceFrameResult",
+		"RedFrameResult",
+		"PatternArea",
+		"PatternDetectedLines",
+		"PatternFrameResult"
+	};
+}
+
+SessionResultsWriter::SessionResultsWriter()
+{
+	for (int32 i = 0; i < UE_ARRAY_COUNT(FrameDataColumnNames); i++)
+	{
+		FColumn& column = columns.AddDefaulted_GetRef();
+		column.name = FrameDataColumnNames[i];
+		column.valueIndex = i;
+	}
+	columns.Sort([](const FColumn& a, const FColumn& b) { return a.name < b.name; });
+}
+
+SessionResultsWriter::~SessionResultsWriter()
+{
+	Close();
+}
+
+void SessionResultsWriter::Open(bool bText, bool bBinary, const FString& folder)
+{
+	if (IsOpen())
+	{
+		return;
+	}
+
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	folderPath = folder.IsEmpty() ? FPaths::ProjectSavedDir() / TEXT("IrisSessions/Results") / FDateTime::Now().ToString() : folder;
+	platformFile.CreateDirectoryTree(*folderPath);
+
+	bWriteText = bText;
+	if (bWriteText)
+	{
+		iris::FrameData header;
+		csvFile.Reset(platformFile.OpenWrite(*(folderPath / TEXT("FrameData.csv"))));
+		csvBuffer = header.CsvColumns() + '\n';
+		csvBuffer.reserve(chunkSize + 1024);
+		for (FColumn& column : columns)
+		{
+			column.spillPath = folderPath / FString::Printf(TEXT("%hs.tmp"), column.name.c_str());
+			column.spillFile.Reset(platformFile.OpenWrite(*column.spillPath));
+			column.buffer.clear();
+		}
+	}
+	if (bBinary)
+	{
+		binaryLog.Open(folderPath / TEXT("FrameData.irislog"));
+	}
+	writtenFrames = 0;
+	fullQueueWaits = 0;
+
+	bStopping = false;
+	framesEvent = FPlatformProcess::GetSynchEventFromPool();
+	spaceEvent = FPlatformProcess::GetSynchEventFromPool();
+	bWaitingForSpace = false;
+	thread = FRunnableThread::Create(this, TEXT("IrisResultsWriterThread"));
+}
+
+void SessionResultsWriter::PushFrameData(const iris::FrameData& data)
+{
+	FIrisFrameRecord record;
+	FrameDataBinaryLog::ToRecord(data, record);
+	if (!pendingFrames.Enqueue(record))
+	{
+		//Blocks until the writer dequeues a frame, the flag is set before retrying so a dequeue between the retry and
+		//the wait still triggers the event
+		fullQueueWaits++;
+		do
+		{
+			bWaitingForSpace = true;
+			framesEvent->Trigger();
+			if (pendingFrames.Enqueue(record))
+			{
+				break;
+			}
+			spaceEvent->Wait(100);
+		} while (!pendingFrames.Enqueue(record));
+		bWaitingForSpace = false;
+	}
+	framesEvent->Trigger();
+}
+
+uint32 SessionResultsWriter::Run()
+{
+	FIrisFrameRecord record;
+	while (!bStopping)
+	{
+		framesEvent->Wait(100);
+		while (pendingFrames.Dequeue(record))
+		{
+			if (bWaitingForSpace.Exchange(false))
+			{
+				spaceEvent->Trigger();
+			}
+			WriteFrame(record);
+		}
+	}
+	//Frames enqueued before Close
+	while (pendingFrames.Dequeue(record))
+	{
+		WriteFrame(record);
+	}
+	return 0;
+}
+
+void SessionResultsWriter::WriteFrame(const FIrisFrameRecord& record)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisResultsWriter);
+
+	if (binaryLog.IsOpen())
+	{
+		binaryLog.Append(record);
+	}
+	if (!bWriteText)
+	{
+		writtenFrames++;
+		return;
+	}
+	FrameDataBinaryLog::FromRecord(record, frameData);
+
+	//CSV line without the ToCSV null terminator
+	std::string line = frameData.ToCSV();
+	if (!line.empty() && line.back() == '\0')
+	{
+		line.pop_back();
+	}
+	csvBuffer += line;
+	csvBuffer += '\n';
+	if (static_cast<int32>(csvBuffer.size()) >= chunkSize)
+	{
+		WriteString(csvFile.Get(), csvBuffer);
+		csvBuffer.clear();
+	}
+
+	for (FColumn& column : columns)
+	{
+		if (writtenFrames > 0)
+		{
+			column.buffer += ',';
+		}
+		column.buffer += FormatColumnValue(column.valueIndex, frameData);
+		if (static_cast<int32>(column.buffer.size()) >= columnChunkSize)
+		{
+			WriteString(column.spillFile.Get(), column.buffer);
+			column.buffer.clear();
+		}
+	}
+	writtenFrames++;
+}
+
+void SessionResultsWriter::Close()
+{
+	if (!IsOpen())
+	{
+		return;
+	}
+
+	Stop();
+	framesEvent->Trigger();
+	thread->WaitForCompletion();
+	delete thread;
+	thread = nullptr;
+	FPlatformProcess::ReturnSynchEventToPool(framesEvent);
+	framesEvent = nullptr;
+	FPlatformProcess::ReturnSynchEventToPool(spaceEvent);
+	spaceEvent = nullptr;
+
+	binaryLog.Close();
+	if (bWriteText)
+	{
+		WriteString(csvFile.Get(), csvBuffer);
+		csvBuffer.clear();
+		csvFile.Reset();
+
+		for (FColumn& column : columns)
+		{
+			WriteString(column.spillFile.Get(), column.buffer);
+			column.buffer.clear();
+			column.spillFile.Reset();
+		}
+		if (writtenFrames > 0)
+		{
+			WriteJson();
+		}
+
+		IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+		for (FColumn& column : columns)
+		{
+			platformFile.DeleteFile(*column.spillPath);
+		}
+	}
+	UE_LOG(LogTemp, Log, TEXT("Iris session results: %lld frames written to %s (analysis waited for the writer on %lld frames)"), writtenFrames, *folderPath, fullQueueWaits);
+}
+
+void SessionResultsWriter::WriteJson()
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisResultsWriterJson);
+
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IFileHandle> jsonFile(platformFile.OpenWrite(*(folderPath / TEXT("FrameData.json"))));
+	if (!jsonFile)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris session results: FrameData.json could not be created in %s"), *folderPath);
+		return;
+	}
+
+	TArray<uint8> chunk;
+	chunk.SetNumUninitialized(chunkSize);
+	for (int32 i = 0; i < columns.Num(); i++)
+	{
+		WriteString(jsonFile.Get(), (i == 0 ? "{\"" : ",\"") + columns[i].name + "\":[");
+
+		TUniquePtr<IFileHandle> spillFile(platformFile.OpenRead(*columns[i].spillPath));
+		int64 remaining = spillFile ? spillFile->Size() : 0;
+		while (remaining > 0)
+		{
+			const int64 bytes = FMath::Min<int64>(remaining, chunkSize);
+			spillFile->Read(chunk.GetData(), bytes);
+			jsonFile->Write(chunk.GetData(), bytes);
+			remaining -= bytes;
+		}
+		WriteString(jsonFile.Get(), "]");
+	}
+	WriteString(jsonFile.Get(), "}");
+}
+
+std::string SessionResultsWriter::FormatColumnValue(int32 column, const iris::FrameData& data)
+{
+	switch (column)
+	{
+	case 0: return json(data.Frame).dump();
+	case 1: return json(data.TimeStampMs).dump();
+	case 2: return json(data.LuminanceAverage).dump();
+	case 3: return json(data.LuminanceFlashArea).dump();
+	case 4: return json(data.AverageLuminanceDiff).dump();
+	case 5: return json(data.AverageLuminanceDiffAcc).dump();
+	case 6: return json(data.RedAverage).dump();
+	case 7: return json(data.RedFlashArea).dump();
+	case 8: return json(data.AverageRedDiff).dump();
+	case 9: return json(data.AverageRedDiffAcc).dump();
+	case 10: return json(data.LuminanceTransitions).dump();
+	case 11: return json(data.RedTransitions).dump();
+	case 12: return json(data.LuminanceExtendedFailCount).dump();
+	case 13: return json(data.RedExtendedFailCount).dump();
+	//FrameDataJson stores the results as unsigned short
+	case 14: return json(static_cast<unsigned short>(data.luminanceFrameResult)).dump();
+	case 15: return json(static_cast<unsigned short>(data.redFrameResult)).dump();
+	case 16: return json(data.patternArea).dump();
+	case 17: return json(data.patternDetectedLines).dump();
+	case 18: return json(static_cast<unsigned short>(data.patternFrameResult)).dump();
+	default: return std::string();
+	}
+}
+
+void SessionResultsWriter::WriteString(IFileHandle* file, const std::string& value)
+{
+	if (file != nullptr && !value.empty())
+	{
+		file->Write(reinterpret_cast<const uint8*>(value.data()), value.size());
+	}
+}
@@ -0,0 +1,442 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "ShardedVideoAnalysis.h"
+#include "RawFrameIngest.h"
+#include "FrameDataBinaryLog.h"
+#include "IncidentIndex.h"
+#include "SessionResultsWriter.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "iris/Result.h"
+#include "utils/JsonWrapper.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+	bool SaveManifest(const json& manifest, const FString& path)
+	{
+		const FString tempPath = path + TEXT(".tmp");
+		return FFileHelper::SaveStringToFile(UTF8_TO_TCHAR(manifest.dump(1, '\t').c_str()), *tempPath) && IFileManager::Get().Move(*path, *tempPath);
+	}
+
+	bool LoadManifest(const FString& path, json& outManifest)
+	{
+		FString text;
+		if (!FFileHelper::LoadFileToString(text, *path))
+		{
+			return false;
+		}
+		outManifest = json::parse(TCHAR_TO_UTF8(*text), nullptr, false);
+		return !outManifest.is_discarded() && outManifest.is_object();
+	}
+
+	bool ParseCategory(const std::string& name, EIncidentCategory& outCategory)
+	{
+		for (int32 category = 0; category < static_cast<int32>(EIncidentCategory::Count); category++)
+		{
+			if (name == TCHAR_TO_UTF8(IncidentIndex::GetCategoryName(static_cast<EIncidentCategory>(category))))
+			{
+				outCategory = static_cast<EIncidentCategory>(category);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void CountResult(iris::FlashResult result, iris::TotalFlashIncidents& totals)
+	{
+		switch (result)
+		{
+		case iris::FlashResult::PassWithWarning: totals.passWithWarningFrames++; break;
+		case iris::FlashResult::ExtendedFail: totals.extendedFailFrames++; break;
+		case iris::FlashResult::FlashFail: totals.flashFailFrames++; break;
+		default: break;
+		}
+	}
+}
+
+FString ShardedVideoAnalysis::GetShardPath(const FString& sharedDir, const FString& videoName, const FString& session, int32 shard, int32 shardCount)
+{
+	return sharedDir / FString::Printf(TEXT("%s.%s.shard%dof%d"), *videoName, *session, shard, shardCount);
+}
+
+bool ShardedVideoAnalysis::IsEndOfVideo(cv::VideoCapture& video)
+{
+	for (int32 i = 0; i < EndOfVideoProbeFrames; i++)
+	{
+		if (video.grab())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ShardedVideoAnalysis::AnalyseShard(const FString& configurationDir, const FString& videoPath, int32 shard, int32 shardCount, const FString& session, float warmUpSeconds, const FString& sharedDir)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisAnalyseShard);
+
+	if (shardCount <= 0 || shard < 0 || shard >= shardCount)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris shard %d of %d is not a valid shard"), shard, shardCount);
+		return false;
+	}
+	if (session.IsEmpty() || FPaths::MakeValidFileName(session) != session)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris shard: session '%s' is not a valid file name"), *session);
+		return false;
+	}
+	cv::VideoCapture video(TCHAR_TO_UTF8(*videoPath));
+	if (!video.isOpened())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris shard: video %s could not be opened"), *videoPath);
+		return false;
+	}
+
+	const double fps = video.get(cv::CAP_PROP_FPS);
+	const int64 frameCount = static_cast<int64>(video.get(cv::CAP_PROP_FRAME_COUNT));
+	const int32 width = static_cast<int32>(video.get(cv::CAP_PROP_FRAME_WIDTH));
+	const int32 height = static_cast<int32>(video.get(cv::CAP_PROP_FRAME_HEIGHT));
+	if (fps <= 0.0 || frameCount <= 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris shard: video %s has no frame rate or frame count"), *videoPath);
+		return false;
+	}
+
+	//The frame count of the container can be an estimate, the last shard reads until the end of the video
+	const int64 firstFrame = frameCount * shard / shardCount;
+	const int64 endFrame = shard == shardCount - 1 ? MAX_int64 : frameCount * (shard + 1) / shardCount;
+	const int64 warmUpFrame = FMath::Max<int64>(firstFrame - static_cast<int64>(FMath::CeilToDouble(warmUpSeconds * fps)), 0);
+
+	//Seeking is not frame accurate with every codec, the frames are skipped from the start when it misses
+	int64 nextFrame = warmUpFrame;
+	bool bVideoEnded = false;
+	video.set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(warmUpFrame));
+	if (static_cast<int64>(video.get(cv::CAP_PROP_POS_FRAMES)) != warmUpFrame)
+	{
+		video.release();
+		video.open(TCHAR_TO_UTF8(*videoPath));
+		for (nextFrame = 0; nextFrame < warmUpFrame && video.grab(); nextFrame++)
+		{
+		}
+		if (nextFrame < warmUpFrame)
+		{
+			if (!IsEndOfVideo(video))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Iris shard %d of %d: frame %lld of %s could not be read"), shard, shardCount, nextFrame, *videoPath);
+				return false;
+			}
+			//The video ends before the shard, it has no frames
+			bVideoEnded = true;
+		}
+	}
+
+	const FString videoName = FPaths::GetBaseFilename(videoPath);
+	const FString shardPath = GetShardPath(sharedDir, videoName, session, shard, shardCount);
+	IFileManager::Get().Delete(*(shardPath + TEXT(".json")));
+	FrameDataLogWriter log;
+	if (!log.Open(shardPath + TEXT(".irislog")))
+	{
+		return false;
+	}
+
+	//A shard owns its process, it does not wait for another analyser
+	RawFrameAnalyser* analyser = bVideoEnded ? nullptr : IrisCreateRawVideoAnalyser(*configurationDir, *videoPath, width, height, 0.f);
+	if (!bVideoEnded && analyser == nullptr)
+	{
+		log.Close();
+		return false;
+	}
+	if (analyser != nullptr)
+	{
+		IrisSetRawFrameOrigin(analyser, static_cast<uint32>(warmUpFrame), 0);
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Iris shard %d of %d (%s): frames %lld to %lld of %s, warm-up from frame %lld"), shard, shardCount, *session, firstFrame,
+		endFrame == MAX_int64 ? frameCount - 1 : endFrame - 1, *videoName, warmUpFrame);
+	const double startTime = FPlatformTime::Seconds();
+
+	IncidentIndex incidents;
+	incidents.SetLabel(FString::Printf(TEXT("shard %d"), shard));
+	TArray<cv::Mat> frames;
+	frames.SetNum(BatchFrames);
+	TArray<FIrisRawFrame> rawFrames;
+	TArray<FIrisFrameRecord> records;
+	iris::FrameData frameData;
+	bool bSucceeded = true;
+	bool bReadFailed = false;
+	while (nextFrame < endFrame && !bVideoEnded && bSucceeded)
+	{
+		rawFrames.Reset();
+		const int32 batch = static_cast<int32>(FMath::Min<int64>(BatchFrames, endFrame - nextFrame));
+		for (int32 i = 0; i < batch; i++)
+		{
+			if (!video.read(frames[i]))
+			{
+				//The end of the video ends the shard, a frame that can not be read fails it
+				bVideoEnded = IsEndOfVideo(video);
+				bReadFailed = !bVideoEnded;
+				break;
+			}
+			FIrisRawFrame& rawFrame = rawFrames.AddDefaulted_GetRef();
+			rawFrame.format = EIrisPixelFormat::BGR8;
+			rawFrame.data = frames[i].data;
+			rawFrame.width = frames[i].cols;
+			rawFrame.height = frames[i].rows;
+			rawFrame.stride = static_cast<int32>(frames[i].step);
+			rawFrame.timeStampUs = static_cast<uint64>((nextFrame + i) * 1000000.0 / fps);
+		}
+		if (bReadFailed)
+		{
+			break;
+		}
+		if (rawFrames.IsEmpty())
+		{
+			continue;
+		}
+
+		records.SetNum(rawFrames.Num());
+		bSucceeded = IrisAnalyseRawFrames(analyser, rawFrames, records) == EIrisIngestStatus::Ok;
+		for (int32 i = 0; i < rawFrames.Num() && bSucceeded; i++)
+		{
+			if (nextFrame + i < firstFrame)
+			{
+				continue; //warm-up frame
+			}
+			log.Append(records[i]);
+			FrameDataBinaryLog::FromRecord(records[i], frameData);
+			incidents.Update(frameData, nullptr);
+		}
+		nextFrame += rawFrames.Num();
+	}
+	if (analyser != nullptr)
+	{
+		IrisDestroyRawAnalyser(analyser);
+	}
+	log.Close();
+	incidents.EndSession(FString());
+	const double analysisSeconds = FPlatformTime::Seconds() - startTime;
+
+	if (bReadFailed)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris shard %d of %d: frame %lld of %s could not be read before the end of the video"), shard, shardCount, nextFrame + rawFrames.Num(), *videoPath);
+		return false;
+	}
+	if (!bSucceeded)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris shard %d of %d: frame %lld could not be analysed"), shard, shardCount, nextFrame);
+		return false;
+	}
+
+	TArray<FIrisIncident> shardIncidents;
+	incidents.GetIncidents(0, MAX_uint32, shardIncidents);
+	json incidentsJson = json::array();
+	for (const FIrisIncident& incident : shardIncidents)
+	{
+		incidentsJson.push_back({
+			{ "Category", TCHAR_TO_UTF8(IncidentIndex::GetCategoryName(incident.category)) },
+			{ "StartFrame", incident.startFrame },
+			{ "EndFrame", incident.endFrame },
+			{ "StartTimeStampMs", incident.startTimeStampMs },
+			{ "EndTimeStampMs", incident.endTimeStampMs },
+			{ "PeakTransitions", incident.peakTransitions }
+		});
+	}
+	const json manifest = {
+		{ "Video", TCHAR_TO_UTF8(*videoName) },
+		{ "Session", TCHAR_TO_UTF8(*session) },
+		{ "Shard", shard },
+		{ "ShardCount", shardCount },
+		{ "VideoFrameCount", frameCount },
+		{ "FirstFrame", firstFrame },
+		{ "EndFrame", FMath::Max(nextFrame, firstFrame) },
+		{ "VideoEnded", bVideoEnded },
+		{ "Fps", fps },
+		{ "AnalysisTimeMs", static_cast<uint32>(analysisSeconds * 1000.0) },
+		{ "Incidents", incidentsJson }
+	};
+	if (!SaveManifest(manifest, shardPath + TEXT(".json")))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris shard %d of %d: manifest could not be written to %s"), shard, shardCount, *sharedDir);
+		return false;
+	}
+
+	const int64 analysedFrames = FMath::Max<int64>(nextFrame - warmUpFrame, 0);
+	UE_LOG(LogTemp, Log, TEXT("Iris shard %d of %d analysed in %.2fs (%lld frames, %lld warm-up, %.0f frames/s), %d incidents"), shard, shardCount,
+		analysisSeconds, analysedFrames, FMath::Min(firstFrame, nextFrame) - warmUpFrame, analysisSeconds > 0.0 ? analysedFrames / analysisSeconds : 0.0, shardIncidents.Num());
+	return true;
+}
+
+bool ShardedVideoAnalysis::MergeShards(const FString& sharedDir, const FString& videoName, int32 shardCount, const FString& session, const FString& outputDir)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisMergeShards);
+
+	if (shardCount <= 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Iris merge: %d is not a valid shard count"), shardCount);
+		return false;
+	}
+
+	//Every shard of the session must be complete, from the same video, and start where the previous one ended. The
+	//shards after the end of the video have no frames
+	TArray<json> manifests;
+	int64 expectedFrame = 0;
+	int64 videoFrameCount = 0;
+	bool bVideoEnded = false;
+	for (int32 shard = 0; shard < shardCount; shard++)
+	{
+		const FString manifestPath = GetShardPath(sharedDir, videoName, session, shard, shardCount) + TEXT(".json");
+		json shardManifest;
+		if (!LoadManifest(manifestPath, shardManifest))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Iris merge: shard %d of %d of %s (%s) is missing or not finished"), shard, shardCount, *videoName, *session);
+			return false;
+		}
+		if (shardManifest.value("Session", std::string()) != TCHAR_TO_UTF8(*session) || shardManifest.value("Shard", -1) != shard
+			|| shardManifest.value("ShardCount", 0) != shardCount || !shardManifest.contains("FirstFrame") || !shardManifest.contains("EndFrame"))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Iris merge: %s is not the manifest of shard %d of %d of session %s"), *manifestPath, shard, shardCount, *session);
+			return false;
+		}
+		const int64 shardFrameCount = shardManifest.value("VideoFrameCount", static_cast<int64>(0));
+		if (shard > 0 && shardFrameCount != videoFrameCount)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Iris merge: shard %d of %s (%s) was analysed from a video of %lld frames, shard 0 from %lld frames"), shard, *videoName,
+				*session, shardFrameCount, videoFrameCount);
+			return false;
+		}
+		videoFrameCount = shardFrameCount;
+
+		const int64 shardFirstFrame = shardManifest["FirstFrame"].get<int64>();
+		const int64 shardEndFrame = shardManifest["EndFrame"].get<int64>();
+		if (bVideoEnded)
+		{
+			if (shardEndFrame != shardFirstFrame || !shardManifest.value("VideoEnded", false))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Iris merge: shard %d of %d of %s (%s) has frames after the end of the video"), shard, shardCount, *videoName, *session);
+				return false;
+			}
+			continue;
+		}
+		if (shardFirstFrame != expectedFrame)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Iris merge: shard %d of %d of %s (%s) does not start at frame %lld"), shard, shardCount, *videoName, *session, expectedFrame);
+			return false;
+		}
+		expectedFrame = shardEndFrame;
+		bVideoEnded = shardManifest.value("VideoEnded", false);
+		manifests.Add(MoveTemp(shardManifest));
+	}
+
+	const double startTime = FPlatformTime::Seconds();
+	SessionResultsWriter writer;
+	writer.Open(true, true, outputDir);
+
+	iris::Result result;
+	IncidentIndex incidents;
+	FrameDataLogReader reader;
+	TArray<iris::FrameData> blockFrames;
+	double fps = 0.0;
+	for (int32 shard = 0; shard < manifests.Num(); shard++)
+	{
+		const json& shardManifest = manifests[shard];
+		const FString logPath = GetShardPath(sharedDir, videoName, session, shard, shardCount) + TEXT(".irislog");
+		if (!reader.Open(logPath))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Iris merge: %s could not be opened"), *logPath);
+			writer.Close();
+			return false;
+		}
+		for (int32 block = 0; block < reader.GetBlockCount(); block++)
+		{
+			blockFrames.Reset();
+			if (!reader.ReadBlock(block, blockFrames))
+			{
+				UE_LOG(LogTemp, Error, TEXT("Iris merge: %s is corrupted"), *logPath);
+				writer.Close();
+				return false;
+			}
+			for (const iris::FrameData& frameData : blockFrames)
+			{
+				writer.PushFrameData(frameData);
+				CountResult(frameData.luminanceFrameResult, result.totalLuminanceIncidents);
+				CountResult(frameData.redFrameResult, result.totalRedIncidents);
+				result.patternFailFrames += frameData.patternFrameResult == iris::PatternResult::Fail ? 1 : 0;
+			}
+			result.TotalFrame += blockFrames.Num();
+		}
+		reader.Close();
+
+		for (const json& incidentJson : shardManifest.value("Incidents", json::array()))
+		{
+			FIrisIncident incident;
+			if (!ParseCategory(incidentJson.value("Category", std::string()), incident.category))
+			{
+				continue;
+			}
+			incident.startFrame = incidentJson.value("StartFrame", 0u);
+			incident.endFrame = incidentJson.value("EndFrame", 0u);
+			incident.startTimeStampMs = incidentJson.value("StartTimeStampMs", 0u);
+			incident.endTimeStampMs = incidentJson.value("EndTimeStampMs", 0u);
+			incident.peakTransitions = incidentJson.value("PeakTransitions", 0u);
+			incidents.AppendIncident(incident);
+		}
+		result.AnalysisTime += shardManifest.value("AnalysisTimeMs", 0u);
+		fps = shardManifest.value("Fps", fps);
+	}
+	writer.Close();
+	incidents.EndSession(writer.GetFolderPath() / TEXT("Incidents.json"));
+
+	//Same result types as the VideoAnalyser: a failure of each type with failing frames
+	result.VideoLen = fps > 0.0 ? static_cast<float>(result.TotalFrame / fps) : 0.f;
+	if (result.totalLuminanceIncidents.flashFailFrames > 0)
+	{
+		result.Results.push_back(iris::AnalysisResult::LuminanceFlashFailure);
+	}
+	if (result.totalLuminanceIncidents.extendedFailFrames > 0)
+	{
+		result.Results.push_back(iris::AnalysisResult::LuminanceExtendedFlashFailure);
+	}
+	if (result.totalRedIncidents.flashFailFrames > 0)
+	{
+		result.Results.push_back(iris::AnalysisResult::RedFlashFailure);
+	}
+	if (result.totalRedIncidents.extendedFailFrames > 0)
+	{
+		result.Results.push_back(iris::AnalysisResult::RedExtendedFlashFailure);
+	}
+	if (result.patternFailFrames > 0)
+	{
+		result.Results.push_back(iris::AnalysisResult::PatternFailure);
+	}
+	if (!result.Results.empty())
+	{
+		result.OverallResult = iris::AnalysisResult::Fail;
+	}
+	else
+	{
+		const bool bWarning = result.totalLuminanceIncidents.passWithWarningFrames > 0 || result.totalRedIncidents.passWithWarningFrames > 0;
+		result.OverallResult = bWarning ? iris::AnalysisResult::PassWithWarning : iris::AnalysisResult::Pass;
+		result.Results.push_back(result.OverallResult);
+	}
+
+	json resultJson = {
+		{ "VideoLen", result.VideoLen },
+		{ "AnalysisTime", result.AnalysisTime },
+		{ "TotalFrame", result.TotalFrame },
+		{ "OverallResult", result.OverallResult },
+		{ "Results", result.Results },
+		{ "TotalLuminanceIncidents", result.totalLuminanceIncidents },
+		{ "TotalRedIncidents", result.totalRedIncidents },
+		{ "PatternFailFrames", result.patternFailFrames }
+	};
+	FFileHelper::SaveStringToFile(UTF8_TO_TCHAR(resultJson.dump(1, '\t').c_str()), *(writer.GetFolderPath() / TEXT("Result.json")));
+
+	UE_LOG(LogTemp, Log, TEXT("Iris merge: %d shards of %s (%s) merged in %.2fs, %u frames (%.1fs of video) to %s"), shardCount, *videoName, *session,
+		FPlatformTime::Seconds() - startTime, result.TotalFrame, result.VideoLen, *writer.GetFolderPath());
+	return true;
+}
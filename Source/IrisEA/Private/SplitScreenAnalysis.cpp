@@ -0,0 +1,302 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "SplitScreenAnalysis.h"
+#include "ConfigurationSnapshot.h"
+#include "Async/ParallelFor.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "iris/VideoAnalyser.h"
+THIRD_PARTY_INCLUDES_END
+
+iris::FlashResult FViewFlashChannel::Update(float avgDiff, float flashArea, float mean, unsigned long timeStampMs, uint32& outTransitions)
+{
+	if (!bHasLastFrame)
+	{
+		//First frame has 0 variation
+		lastMean = mean;
+	}
+
+	//Same as the frame level check, the variation only counts if enough of the view area changed
+	const uint8 newTransition = FlashTransitionRules::CheckTransition(flashArea >= areaProportion ? avgDiff : 0.f, mean, lastMean, avgDiffAcc, threshold, darkThreshold);
+	transitions.Push(timeStampMs, &newTransition);
+	outTransitions = transitions.GetTransitions()[0];
+	bHasLastFrame = true;
+
+	const uint32 overMinMs = extendedFail.AddFrame(timeStampMs, outTransitions >= transitionParams.minTransitions);
+	return FlashTransitionRules::GetFlashResult(outTransitions, overMinMs, transitionParams);
+}
+
+void FViewFlashChannel::Reset()
+{
+	lastMean = 0.f;
+	avgDiffAcc = 0.f;
+	bHasLastFrame = false;
+	transitions.Reset();
+	extendedFail.Initialize(transitionParams.extendedFailWindowMs);
+}
+
+void SplitScreenAnalysis::Initialize(const ConfigurationSnapshot& configurationSnapshot, const FIrisDisplayTransform& displayTransform)
+{
+	const FIrisConfigurationSnapshot& settings = configurationSnapshot.GetSnapshot();
+
+	for (int32 i = 0; i < MaxViews; i++)
+	{
+		FViewAnalysis& analysis = views[i];
+		analysis.tileGrid.Initialize(settings);
+		analysis.tileGrid.SetDisplayTransform(displayTransform);
+
+		for (FViewFlashChannel* channel : { &analysis.luminance, &analysis.red })
+		{
+			channel->transitionParams.Initialize(settings);
+			channel->Reset();
+		}
+		analysis.luminance.threshold = settings.luminanceFlashThreshold;
+		analysis.luminance.darkThreshold = settings.luminanceDarkThreshold;
+		analysis.luminance.areaProportion = settings.luminanceAreaProportion;
+		analysis.red.threshold = settings.redFlashThreshold;
+		analysis.red.darkThreshold = settings.redDarkThreshold;
+		analysis.red.areaProportion = settings.redAreaProportion;
+
+		analysis.incidentIndex.Reset();
+		analysis.incidentIndex.SetLabel(FString::Printf(TEXT("Player %d"), i + 1));
+		analysis.chart.Reset();
+		analysis.chart.SetChartValues(settings.maxTransitions, settings.warningTransitions);
+		analysis.bActive = false;
+		analysis.bUsed = false;
+	}
+	viewCount = 0;
+}
+
+void SplitScreenAnalysis::Update(const FIrisFrame& frame)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisSplitScreenAnalysis);
+
+	//A player that left the layout closes its open incidents with a passing frame
+	const int32 newViewCount = FMath::Min(frame.views.Num(), MaxViews);
+	for (int32 i = newViewCount; i < viewCount; i++)
+	{
+		if (views[i].bActive)
+		{
+			views[i].incidentIndex.Update(iris::FrameData(frame.frameData.Frame, frame.frameData.TimeStampVal), nullptr);
+			views[i].bActive = false;
+		}
+	}
+	viewCount = newViewCount;
+
+	//The views share the captured frame read only, the rest of their state is their own
+	ParallelFor(viewCount, [this, &frame](int32 i)
+		{
+			UpdateView(views[i], frame, frame.views[i]);
+		});
+}
+
+void SplitScreenAnalysis::UpdateView(FViewAnalysis& analysis, const FIrisFrame& frame, const FBox2f& view)
+{
+	const cv::Rect rect = GetViewRect(frame.frameMatrix.size(), view);
+	if (rect.width < FrameTileGrid::TilesX || rect.height < FrameTileGrid::TilesY)
+	{
+		return;
+	}
+	if (!analysis.bActive || analysis.view != view)
+	{
+		//New layout, the view starts again from this frame
+		analysis.view = view;
+		analysis.tileGrid.Reset();
+		analysis.luminance.Reset();
+		analysis.red.Reset();
+		analysis.bActive = true;
+		analysis.bUsed = true;
+	}
+
+	//Sub-rect of the single readback, no copy
+	const cv::Mat viewFrame = frame.frameMatrix(rect);
+	FrameTileGrid::ComputeTileSignatures(viewFrame, analysis.tileSignatures);
+	analysis.tileGrid.Update(viewFrame, analysis.tileSignatures);
+	const FFrameTileStats& stats = analysis.tileGrid.GetFrameStats();
+
+	iris::FrameData& frameData = analysis.frameData;
+	frameData.Frame = frame.frameData.Frame;
+	frameData.TimeStampVal = frame.frameData.TimeStampVal;
+	frameData.LuminanceAverage = stats.luminanceAverage;
+	frameData.AverageLuminanceDiff = stats.averageLuminanceDiff;
+	frameData.RedAverage = stats.redAverage;
+	frameData.AverageRedDiff = stats.averageRedDiff;
+	frameData.luminanceFrameResult = analysis.luminance.Update(stats.averageLuminanceDiff, stats.luminanceFlashArea, stats.luminanceAverage,
+		frameData.TimeStampVal, frameData.LuminanceTransitions);
+	frameData.redFrameResult = analysis.red.Update(stats.averageRedDiff, stats.redFlashArea, stats.redAverage,
+		frameData.TimeStampVal, frameData.RedTransitions);
+
+	analysis.incidentIndex.Update(frameData, nullptr);
+	analysis.chart.PushFrameDataToArray(frameData);
+}
+
+void SplitScreenAnalysis::EndSession(const FString& resultsFolder)
+{
+	for (int32 i = 0; i < MaxViews; i++)
+	{
+		FViewAnalysis& analysis = views[i];
+		if (analysis.bUsed)
+		{
+			analysis.incidentIndex.EndSession(resultsFolder.IsEmpty() ? FString() : resultsFolder / FString::Printf(TEXT("Incidents_Player%d.json"), i + 1));
+		}
+		analysis.tileGrid.Reset();
+		analysis.chart.Reset();
+		analysis.bActive = false;
+		analysis.bUsed = false;
+	}
+	viewCount = 0;
+}
+
+bool SplitScreenAnalysis::DrawCharts(UCanvas* Canvas, int32 view)
+{
+	if (view < 0 || view >= viewCount || !views[view].bActive)
+	{
+		return false;
+	}
+	views[view].chart.DrawResultsGraph(Canvas);
+	views[view].chart.DrawTransitionsGraph(Canvas);
+	return true;
+}
+
+void SplitScreenAnalysis::ToggleResultsGraph()
+{
+	for (FViewAnalysis& analysis : views)
+	{
+		analysis.chart.ToggleResultsGraph();
+	}
+}
+
+void SplitScreenAnalysis::ToggleTransitionsGraph()
+{
+	for (FViewAnalysis& analysis : views)
+	{
+		analysis.chart.ToggleTransitionsGraph();
+	}
+}
+
+void SplitScreenAnalysis::MoveCharts(DataChart::EDirections moveTo)
+{
+	for (FViewAnalysis& analysis : views)
+	{
+		analysis.chart.MoveChart(moveTo);
+	}
+}
+
+cv::Rect SplitScreenAnalysis::GetViewRect(const cv::Size& frameSize, const FBox2f& view)
+{
+	const int32 x0 = FMath::Clamp(FMath::RoundToInt(view.Min.X * frameSize.width), 0, frameSize.width);
+	const int32 x1 = FMath::Clamp(FMath::RoundToInt(view.Max.X * frameSize.width), x0, frameSize.width);
+	const int32 y0 = FMath::Clamp(FMath::RoundToInt(view.Min.Y * frameSize.height), 0, frameSize.height);
+	const int32 y1 = FMath::Clamp(FMath::RoundToInt(view.Max.Y * frameSize.height), y0, frameSize.height);
+	return cv::Rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+bool SplitScreenAnalysis::GetLayoutViews(const FString& layout, TArray<FBox2f>& outViews)
+{
+	outViews.Reset();
+	if (layout == TEXT("1"))
+	{
+		outViews.Add(FBox2f(FVector2f(0.f, 0.f), FVector2f(1.f, 1.f)));
+	}
+	else if (layout == TEXT("2h"))
+	{
+		outViews.Add(FBox2f(FVector2f(0.f, 0.f), FVector2f(0.5f, 1.f)));
+		outViews.Add(FBox2f(FVector2f(0.5f, 0.f), FVector2f(1.f, 1.f)));
+	}
+	else if (layout == TEXT("2v"))
+	{
+		outViews.Add(FBox2f(FVector2f(0.f, 0.f), FVector2f(1.f, 0.5f)));
+		outViews.Add(FBox2f(FVector2f(0.f, 0.5f), FVector2f(1.f, 1.f)));
+	}
+	else if (layout == TEXT("4"))
+	{
+		for (int32 i = 0; i < 4; i++)
+		{
+			const FVector2f min((i % 2) * 0.5f, (i / 2) * 0.5f);
+			outViews.Add(FBox2f(min, min + FVector2f(0.5f, 0.5f)));
+		}
+	}
+	return outViews.Num() > 0;
+}
+
+bool SplitScreenAnalysis::ValidateOnVideo(iris::VideoAnalyser& reference, const ConfigurationSnapshot& configurationSnapshot, const FString& videoPath, const TArray<FBox2f>& layoutViews)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisSplitScreenValidation);
+
+	cv::VideoCapture video(TCHAR_TO_UTF8(*videoPath));
+	if (!video.isOpened())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Iris split screen validation: could not open %s"), *videoPath);
+		return false;
+	}
+	const double fps = video.get(cv::CAP_PROP_FPS) > 0.0 ? video.get(cv::CAP_PROP_FPS) : 60.0;
+	const int32 layoutViewCount = FMath::Min(layoutViews.Num(), MaxViews);
+
+	//Plugin verdicts of every view, as in a session
+	struct FViewFrameResult
+	{
+		iris::FlashResult luminance;
+		iris::FlashResult red;
+		uint32 luminanceTransitions;
+		uint32 redTransitions;
+	};
+	TArray<FViewFrameResult> viewResults[MaxViews];
+	TUniquePtr<SplitScreenAnalysis> splitScreen = MakeUnique<SplitScreenAnalysis>();
+	splitScreen->Initialize(configurationSnapshot, FIrisDisplayTransform());
+	FIrisFrame frame;
+	frame.views.Append(layoutViews.GetData(), layoutViewCount);
+	for (unsigned int frameIndex = 0; video.read(frame.frameMatrix); frameIndex++)
+	{
+		frame.frameData = iris::FrameData(frameIndex, static_cast<unsigned long>(frameIndex * 1000.0 / fps));
+		splitScreen->Update(frame);
+		for (int32 view = 0; view < layoutViewCount; view++)
+		{
+			const iris::FrameData& frameData = splitScreen->views[view].frameData;
+			viewResults[view].Add({ frameData.luminanceFrameResult, frameData.redFrameResult, frameData.LuminanceTransitions, frameData.RedTransitions });
+		}
+	}
+	splitScreen->EndSession(FString());
+
+	//Each view cropped from the clip and analysed on its own by IRIS
+	int32 totalDifferences = 0;
+	for (int32 view = 0; view < layoutViewCount; view++)
+	{
+		video.release();
+		video.open(TCHAR_TO_UTF8(*videoPath));
+		cv::Mat clipFrame, viewFrame;
+		int32 frames = 0, luminanceDifferences = 0, redDifferences = 0, transitionDifferences = 0, firstDifference = INDEX_NONE;
+		for (unsigned int frameIndex = 0; frameIndex < static_cast<unsigned int>(viewResults[view].Num()) && video.read(clipFrame); frameIndex++)
+		{
+			const cv::Rect rect = GetViewRect(clipFrame.size(), layoutViews[view]);
+			if (frameIndex == 0)
+			{
+				cv::Size analysisSize(rect.height, rect.width);
+				reference.RealTimeInit(analysisSize);
+			}
+			clipFrame(rect).copyTo(viewFrame);
+			iris::FrameData frameData(frameIndex, static_cast<unsigned long>(frameIndex * 1000.0 / fps));
+			reference.AnalyseFrame(viewFrame, frameIndex, frameData);
+
+			const FViewFrameResult& result = viewResults[view][frameIndex];
+			const bool bLuminanceDiffers = result.luminance != frameData.luminanceFrameResult;
+			const bool bRedDiffers = result.red != frameData.redFrameResult;
+			luminanceDifferences += bLuminanceDiffers;
+			redDifferences += bRedDiffers;
+			transitionDifferences += result.luminanceTransitions != frameData.LuminanceTransitions || result.redTransitions != frameData.RedTransitions;
+			if (firstDifference == INDEX_NONE && (bLuminanceDiffers || bRedDiffers))
+			{
+				firstDifference = frameIndex;
+			}
+			frames++;
+		}
+		if (frames > 0)
+		{
+			reference.DeInit();
+		}
+		UE_LOG(LogTemp, Log, TEXT("Iris split screen validation of %s, player %d: %d frames, %d with a different luminance result, %d with a different red result (first at frame %d), %d with different transitions"),
+			*videoPath, view + 1, frames, luminanceDifferences, redDifferences, firstDifference, transitionDifferences);
+		totalDifferences += luminanceDifferences + redDifferences;
+	}
+	return totalDifferences == 0;
+}
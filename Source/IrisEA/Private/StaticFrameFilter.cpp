@@ -0,0 +1,55 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "StaticFrameFilter.h"
+#include "Hash/xxhash.h"
+
+uint64 StaticFrameFilter::ComputeSignature(const TArray<uint64>& tileSignatures)
+{
+	return FXxHash64::HashBuffer(tileSignatures.GetData(), tileSignatures.Num() * sizeof(uint64)).Hash;
+}
+
+bool StaticFrameFilter::TryReuseLastVerdict(FIrisFrame& frame)
+{
+	if (!bHasReference || frame.frameSignature != lastSignature || !IsQuiet(lastFrameData))
+	{
+		return false;
+	}
+
+	//Same verdict as the reference frame, without any variation
+	iris::FrameData frameData(frame.frameData.Frame, frame.frameData.TimeStampVal);
+	frameData.LuminanceAverage = lastFrameData.LuminanceAverage;
+	frameData.AverageLuminanceDiffAcc = lastFrameData.AverageLuminanceDiffAcc;
+	frameData.RedAverage = lastFrameData.RedAverage;
+	frameData.AverageRedDiffAcc = lastFrameData.AverageRedDiffAcc;
+	frame.frameData = frameData;
+
+	skippedFrames++;
+	return true;
+}
+
+void StaticFrameFilter::SetAnalysedFrame(const FIrisFrame& frame)
+{
+	lastSignature = frame.frameSignature;
+	lastFrameData = frame.frameData;
+	bHasReference = true;
+	analysedFrames++;
+}
+
+void StaticFrameFilter::Reset()
+{
+	if (analysedFrames + skippedFrames > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("Iris static frames skipped: %d of %d"), skippedFrames, analysedFrames + skippedFrames);
+	}
+	bHasReference = false;
+	analysedFrames = 0;
+	skippedFrames = 0;
+}
+
+bool StaticFrameFilter::IsQuiet(const iris::FrameData& frameData) const
+{
+	return frameData.LuminanceTransitions == 0 && frameData.RedTransitions == 0
+		&& frameData.LuminanceExtendedFailCount == 0 && frameData.RedExtendedFailCount == 0
+		&& frameData.luminanceFrameResult == iris::FlashResult::Pass && frameData.redFrameResult == iris::FlashResult::Pass
+		&& frameData.patternDetectedLines == 0 && frameData.patternFrameResult == iris::PatternResult::Pass;
+}
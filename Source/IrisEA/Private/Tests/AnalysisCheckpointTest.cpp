@@ -0,0 +1,133 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "Misc/AutomationTest.h"
+#include "RawFrameIngest.h"
+#include "FrameDataBinaryLog.h"
+#include "HAL/FileManager.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/Paths.h"
+#include <FrameStruct.h>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	constexpr int32 StreamFrames = 1200; //20 s at 60 fps
+	constexpr int32 FrameWidth = 160;
+	constexpr int32 FrameHeight = 90;
+
+	//Checkpoints every 8 s are written after frames 480 and 960, the interrupted analysis stops at 17 s and resumes
+	//after the last checkpoint. Its 6 s warm-up tail (extended fail window plus one second) starts in the static span
+	constexpr float CheckpointSeconds = 8.f;
+	constexpr int32 InterruptFrame = 1020;
+	constexpr int32 ResumeFrame = 961;
+
+	FString GetConfigurationDir()
+	{
+		return FPaths::Combine(IPluginManager::Get().FindPlugin("IrisEA")->GetBaseDir(), TEXT("Source/ThirdParty/IrisLibrary/Win64/"));
+	}
+
+	uint64 GetTimeStampUs(int32 frame)
+	{
+		return static_cast<uint64>(frame * 1000000.0 / 60.0);
+	}
+
+	//Quadrant flashing between bright and dark every 3 frames for 9 s, static for 3 s, then flashing every 4 frames.
+	//The 8 bit stream is BGR8, the HDR one linear half float RGBA with the bright level over 1
+	TArray<cv::Mat> MakeStream(bool bHalfFloat)
+	{
+		const cv::Rect quadrant(0, 0, FrameWidth / 2, FrameHeight / 2);
+		TArray<cv::Mat> frames;
+		for (int32 frame = 0; frame < StreamFrames; frame++)
+		{
+			const int32 flashPeriod = frame < 540 ? 3 : 4;
+			const bool bDark = (frame < 540 || frame >= 720) && (frame / flashPeriod) % 2 == 0;
+			cv::Mat image;
+			if (bHalfFloat)
+			{
+				cv::Mat linear(FrameHeight, FrameWidth, CV_32FC4, cv::Scalar(0.4, 0.4, 0.4, 1.0));
+				linear(quadrant).setTo(bDark ? cv::Scalar(0.02, 0.02, 0.02, 1.0) : cv::Scalar(2.5, 2.0, 1.5, 1.0));
+				linear.convertTo(image, CV_16FC4);
+			}
+			else
+			{
+				image = cv::Mat(FrameHeight, FrameWidth, CV_8UC3, cv::Scalar::all(160));
+				image(quadrant).setTo(bDark ? cv::Scalar::all(10) : cv::Scalar(200, 220, 240));
+			}
+			frames.Add(image);
+		}
+		return frames;
+	}
+
+	//Analyses frames [first, last) of the stream, their records are written at their frame index
+	void AnalyseStream(RawFrameAnalyser* analyser, const TArray<cv::Mat>& frames, int32 first, int32 last, bool bHalfFloat, TArray<FIrisFrameRecord>& records)
+	{
+		records.SetNum(frames.Num());
+		for (int32 i = first; i < last; i++)
+		{
+			FIrisRawFrame rawFrame;
+			rawFrame.format = bHalfFloat ? EIrisPixelFormat::RGBA16F : EIrisPixelFormat::BGR8;
+			rawFrame.data = frames[i].data;
+			rawFrame.width = FrameWidth;
+			rawFrame.height = FrameHeight;
+			rawFrame.stride = static_cast<int32>(frames[i].step);
+			rawFrame.timeStampUs = GetTimeStampUs(i);
+			IrisAnalyseRawFrame(analyser, rawFrame, records[i]);
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIrisCheckpointResumeTest, "Iris.AnalysisCheckpoint.ResumeMatchesUninterrupted", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FIrisCheckpointResumeTest::RunTest(const FString& Parameters)
+{
+	const FString configurationDir = GetConfigurationDir();
+	const FString checkpointPath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("IrisResumeTest.irisckpt"));
+
+	for (const bool bHalfFloat : { false, true })
+	{
+		const TCHAR* streamName = bHalfFloat ? TEXT("RGBA16F") : TEXT("BGR8");
+		const TArray<cv::Mat> frames = MakeStream(bHalfFloat);
+		IFileManager::Get().Delete(*checkpointPath);
+
+		TArray<FIrisFrameRecord> uninterrupted;
+		RawFrameAnalyser* analyser = IrisCreateRawAnalyser(*configurationDir, FrameWidth, FrameHeight);
+		if (!TestNotNull(TEXT("Analyser created"), analyser))
+		{
+			return false;
+		}
+		AnalyseStream(analyser, frames, 0, StreamFrames, bHalfFloat, uninterrupted);
+		IrisDestroyRawAnalyser(analyser);
+
+		//Destroying the analyser waits for the checkpoint worker
+		TArray<FIrisFrameRecord> interrupted;
+		analyser = IrisCreateRawAnalyser(*configurationDir, FrameWidth, FrameHeight);
+		IrisEnableRawCheckpoints(analyser, *checkpointPath, CheckpointSeconds);
+		AnalyseStream(analyser, frames, 0, InterruptFrame, bHalfFloat, interrupted);
+		IrisDestroyRawAnalyser(analyser);
+
+		TArray<FIrisFrameRecord> resumed;
+		analyser = IrisResumeRawAnalyser(*configurationDir, *checkpointPath, 0.f);
+		if (!TestNotNull(FString::Printf(TEXT("Analyser resumed from the %s checkpoint"), streamName), analyser))
+		{
+			continue;
+		}
+		AnalyseStream(analyser, frames, ResumeFrame, StreamFrames, bHalfFloat, resumed);
+		IrisDestroyRawAnalyser(analyser);
+
+		TestEqual(FString::Printf(TEXT("%s analysis resumed after the last checkpoint"), streamName), static_cast<int32>(resumed[ResumeFrame].frame), ResumeFrame);
+		int32 firstDifference = INDEX_NONE;
+		bool bFlashFail = false;
+		for (int32 frame = ResumeFrame; frame < StreamFrames && firstDifference == INDEX_NONE; frame++)
+		{
+			firstDifference = resumed[frame] == uninterrupted[frame] ? INDEX_NONE : frame;
+			bFlashFail |= uninterrupted[frame].luminanceFrameResult == static_cast<uint8>(iris::FlashResult::FlashFail);
+		}
+		TestEqual(FString::Printf(TEXT("%s first resumed frame differing from the uninterrupted analysis"), streamName), firstDifference, static_cast<int32>(INDEX_NONE));
+		TestTrue(FString::Printf(TEXT("%s stream fails after the resume"), streamName), bFlashFail);
+	}
+	IFileManager::Get().Delete(*checkpointPath);
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,115 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "Misc/AutomationTest.h"
+#include "HalfFloatConversion.h"
+#include "Math/RandomStream.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	//Not a multiple of the 8 pixels of the SIMD kernels, the tail goes through the scalar kernel
+	constexpr int32 RowPixels = 8 * 64 + 5;
+
+	//Random linear values over the half float range, with the special values at random pixels and channels
+	TArray<FFloat16> MakeRow(int32 seed)
+	{
+		const float specialValues[] = { NAN, -NAN, INFINITY, -INFINITY, 65504.f, -65504.f, 0.f, -0.f, 6e-8f, -1.f, 1.f, 1e-4f, 0.0031308f };
+		FRandomStream random(seed);
+		TArray<FFloat16> row;
+		row.SetNum(RowPixels * 4);
+		for (int32 i = 0; i < row.Num(); i++)
+		{
+			const float value = random.FRand() < 0.1f ? specialValues[random.RandHelper(UE_ARRAY_COUNT(specialValues))]
+				: FMath::Pow(2.f, random.FRandRange(-14.f, 8.f)) * (random.FRand() < 0.9f ? 1.f : -1.f);
+			row[i] = FFloat16(value);
+		}
+		//A full SIMD block of NaN and infinite pixels
+		for (int32 i = 0; i < 8 * 4; i++)
+		{
+			row[i] = FFloat16(i % 3 == 0 ? NAN : (i % 3 == 1 ? INFINITY : -INFINITY));
+		}
+		return row;
+	}
+
+	//The float rounding of the two kernels moves a plane value by one step at most
+#if IRIS_FIXED_POINT_PLANES
+	constexpr float PlaneTolerance = 1.f;
+#else
+	constexpr float PlaneTolerance = 1e-4f;
+#endif
+
+	float GetMaxDifference(const TArray<FrameTileGrid::PlaneValue>& a, const TArray<FrameTileGrid::PlaneValue>& b)
+	{
+		float maxDifference = 0.f;
+		for (int32 i = 0; i < a.Num(); i++)
+		{
+			maxDifference = FMath::Max(maxDifference, FMath::Abs(static_cast<float>(a[i]) - static_cast<float>(b[i])));
+		}
+		return maxDifference;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIrisHalfFloatSimdTest, "Iris.HalfFloatConversion.SimdMatchesScalar", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FIrisHalfFloatSimdTest::RunTest(const FString& Parameters)
+{
+	if (!HalfFloatConversion::HasSimdSupport())
+	{
+		AddInfo(TEXT("No AVX2 on this CPU, the SIMD kernels fall back to the scalar ones"));
+	}
+
+	FIrisDisplayTransform transforms[3];
+	transforms[1].exposure = 4.f;
+	transforms[2].toneMapping = EIrisToneMapping::Reinhard;
+	transforms[2].exposure = 2.f;
+	transforms[2].whitePoint = 4.f;
+
+	for (int32 seed = 0; seed < 4; seed++)
+	{
+		const TArray<FFloat16> row = MakeRow(seed);
+		for (const FIrisDisplayTransform& transform : transforms)
+		{
+			TArray<FrameTileGrid::PlaneValue> scalarLuminance, scalarRed, simdLuminance, simdRed;
+			for (TArray<FrameTileGrid::PlaneValue>* plane : { &scalarLuminance, &scalarRed, &simdLuminance, &simdRed })
+			{
+				plane->SetNumZeroed(RowPixels);
+			}
+			HalfFloatConversion::ConvertRowScalar(row.GetData(), RowPixels, transform, scalarLuminance.GetData(), scalarRed.GetData());
+			HalfFloatConversion::ConvertRowSimd(row.GetData(), RowPixels, transform, simdLuminance.GetData(), simdRed.GetData());
+
+			const FString label = FString::Printf(TEXT("seed %d, exposure %.1f, %s"), seed, transform.exposure,
+				transform.toneMapping == EIrisToneMapping::Reinhard ? TEXT("Reinhard") : TEXT("clamp"));
+			TestTrue(FString::Printf(TEXT("Luminance within a plane step (%s)"), *label), GetMaxDifference(scalarLuminance, simdLuminance) <= PlaneTolerance);
+			TestTrue(FString::Printf(TEXT("Red saturation within a plane step (%s)"), *label), GetMaxDifference(scalarRed, simdRed) <= PlaneTolerance);
+
+			//NaN and infinite inputs give finite values in range
+			bool bInRange = true;
+			for (int32 x = 0; x < RowPixels; x++)
+			{
+				const float luminance = static_cast<float>(simdLuminance[x]) / FrameTileGrid::LuminanceScale;
+				const float red = static_cast<float>(simdRed[x]) / FrameTileGrid::RedScale;
+				bInRange &= FMath::IsFinite(luminance) && luminance >= 0.f && luminance <= 1.f + KINDA_SMALL_NUMBER && FMath::IsFinite(red) && red >= 0.f && red <= 320.f;
+			}
+			TestTrue(FString::Printf(TEXT("Plane values in range (%s)"), *label), bInRange);
+
+			TArray<uint8> scalarBgr, simdBgr;
+			scalarBgr.SetNumZeroed(RowPixels * 3);
+			simdBgr.SetNumZeroed(RowPixels * 3);
+			HalfFloatConversion::EncodeRowBGRScalar(row.GetData(), RowPixels, transform, scalarBgr.GetData());
+			HalfFloatConversion::EncodeRowBGRSimd(row.GetData(), RowPixels, transform, simdBgr.GetData());
+			int32 maxBgrDifference = 0;
+			for (int32 i = 0; i < scalarBgr.Num(); i++)
+			{
+				maxBgrDifference = FMath::Max(maxBgrDifference, FMath::Abs(scalarBgr[i] - simdBgr[i]));
+			}
+			TestTrue(FString::Printf(TEXT("BGR encoding within a gray level (%s)"), *label), maxBgrDifference <= 1);
+			//NaN and negative infinity are black, positive infinity is white
+			TestEqual(FString::Printf(TEXT("NaN pixel encoded black (%s)"), *label), static_cast<int32>(simdBgr[2]), 0);
+			TestEqual(FString::Printf(TEXT("Infinite pixel encoded white (%s)"), *label), static_cast<int32>(simdBgr[1]), 255);
+		}
+	}
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
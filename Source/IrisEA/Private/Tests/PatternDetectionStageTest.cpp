@@ -0,0 +1,185 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "Misc/AutomationTest.h"
+#include "PatternDetectionStage.h"
+#include "PatternFrameCounter.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/Paths.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "iris/Configuration.h"
+#include "src/ConfigurationParams.h"
+THIRD_PARTY_INCLUDES_END
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	constexpr double ClipFps = 60.0;
+	constexpr unsigned long FrameIntervalMs = 17; //rounded up frame interval of the clips
+
+	unsigned long GetFrameTimeMs(int32 frame)
+	{
+		return static_cast<unsigned long>(frame * 1000.0 / ClipFps);
+	}
+
+	FString GetConfigurationDir()
+	{
+		return FPaths::Combine(IPluginManager::Get().FindPlugin("IrisEA")->GetBaseDir(), TEXT("Source/ThirdParty/IrisLibrary/Win64/"));
+	}
+
+	struct FStripeClipResult
+	{
+		int32 failFrames = 0;
+		unsigned long firstFailMs = 0;
+		unsigned long lastFailMs = 0;
+	};
+
+	//60 fps clip of white frames showing full frame black and white stripes from onsetMs to onsetMs + durationMs. With
+	//bSkipStatic the frames repeating the last analysed one go through AdvanceStatic while its verdict has no pattern, as
+	//with the static frame filter of the analysis
+	FStripeClipResult RunStripeClip(const FString& configurationDir, unsigned long onsetMs, unsigned long durationMs, unsigned long clipMs, bool bSkipStatic = false)
+	{
+		const cv::Size frameSize(320, 180);
+		constexpr int32 stripes = 16;
+
+		cv::Mat whiteFrame(frameSize, CV_8UC3, cv::Scalar::all(255));
+		cv::Mat whiteLuminance(frameSize, FrameTileGrid::PlaneType, cv::Scalar::all(FrameTileGrid::LuminanceScale));
+		cv::Mat stripeFrame = whiteFrame.clone();
+		cv::Mat stripeLuminance = whiteLuminance.clone();
+		for (int32 stripe = 0; stripe < stripes; stripe += 2)
+		{
+			const cv::Rect stripeRect(0, stripe * frameSize.height / stripes, frameSize.width, frameSize.height / stripes);
+			stripeFrame(stripeRect).setTo(cv::Scalar::all(0));
+			stripeLuminance(stripeRect).setTo(cv::Scalar::all(0));
+		}
+
+		PatternDetectionStage stage;
+		stage.Initialize(TCHAR_TO_UTF8(*configurationDir));
+		FStripeClipResult clipResult;
+		bool bHasAnalysed = false;
+		bool bAnalysedStripes = false;
+		bool bAnalysedQuiet = false;
+		for (int32 frame = 0; GetFrameTimeMs(frame) < clipMs; frame++)
+		{
+			const unsigned long timeStampMs = GetFrameTimeMs(frame);
+			const bool bStripes = timeStampMs >= onsetMs && timeStampMs < onsetMs + durationMs;
+			bool bFail = false;
+			if (bSkipStatic && bHasAnalysed && bStripes == bAnalysedStripes && bAnalysedQuiet)
+			{
+				bFail = stage.AdvanceStatic(timeStampMs);
+			}
+			else
+			{
+				iris::FrameData frameData(frame, timeStampMs);
+				FPatternFrameResult result(frameData);
+				stage.AnalyseFrame(bStripes ? stripeLuminance : whiteLuminance, FrameTileGrid::LuminanceScale, bStripes ? stripeFrame : whiteFrame, result);
+				bFail = result.patternFrameResult == iris::PatternResult::Fail;
+				bHasAnalysed = true;
+				bAnalysedStripes = bStripes;
+				bAnalysedQuiet = !bFail && result.patternDetectedLines == 0;
+			}
+			if (bFail)
+			{
+				clipResult.firstFailMs = clipResult.failFrames == 0 ? timeStampMs : clipResult.firstFailMs;
+				clipResult.lastFailMs = timeStampMs;
+				clipResult.failFrames++;
+			}
+		}
+		stage.Reset();
+		return clipResult;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIrisPatternFrameCounterTest, "Iris.PatternDetection.FrameCounter", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FIrisPatternFrameCounterTest::RunTest(const FString& Parameters)
+{
+	constexpr float timeThreshold = 0.5f;
+	const unsigned long thresholdMs = static_cast<unsigned long>(timeThreshold * 1000);
+
+	//Pattern frames shorter and longer than the time threshold, from 1 s into the stream
+	const unsigned long durationsMs[] = { 200, thresholdMs - 2 * FrameIntervalMs, thresholdMs + 2 * FrameIntervalMs, 2000 };
+	for (const unsigned long durationMs : durationsMs)
+	{
+		PatternFrameCounter counter;
+		counter.Initialize(timeThreshold);
+		int32 failFrames = 0;
+		unsigned long firstFailMs = 0;
+		for (int32 frame = 0; GetFrameTimeMs(frame) < 4000; frame++)
+		{
+			const unsigned long timeStampMs = GetFrameTimeMs(frame);
+			const bool bPattern = timeStampMs >= 1000 && timeStampMs < 1000 + durationMs;
+			if (counter.AddFrame(timeStampMs, bPattern))
+			{
+				TestTrue(TEXT("Only pattern frames fail"), bPattern);
+				firstFailMs = failFrames == 0 ? timeStampMs : firstFailMs;
+				failFrames++;
+			}
+		}
+
+		if (durationMs < thresholdMs - FrameIntervalMs)
+		{
+			TestEqual(FString::Printf(TEXT("No PatternFail for a %u ms pattern"), durationMs), failFrames, 0);
+		}
+		else
+		{
+			TestTrue(FString::Printf(TEXT("PatternFail for a %u ms pattern"), durationMs), failFrames > 0);
+			//Every frame of a full window has the pattern, the window spans the time threshold minus one frame
+			TestTrue(TEXT("PatternFail once the pattern fills the window"), firstFailMs + FrameIntervalMs >= 1000 + thresholdMs && firstFailMs <= 1000 + thresholdMs);
+		}
+	}
+
+	//A gap longer than the window does not make a single pattern frame fail
+	PatternFrameCounter counter;
+	counter.Initialize(timeThreshold);
+	for (int32 frame = 0; frame < 60; frame++)
+	{
+		counter.AddFrame(GetFrameTimeMs(frame), false);
+	}
+	TestFalse(TEXT("No PatternFail after a gap"), counter.AddFrame(GetFrameTimeMs(60) + 2000, true));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIrisPatternStripeDurationTest, "Iris.PatternDetection.StripeDuration", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FIrisPatternStripeDurationTest::RunTest(const FString& Parameters)
+{
+	const FString configurationDir = GetConfigurationDir();
+	iris::Configuration configuration;
+	configuration.Init(TCHAR_TO_UTF8(*configurationDir));
+	const unsigned long thresholdMs = static_cast<unsigned long>(configuration.GetPatternDetectionParams()->timeThreshold * 1000);
+	const unsigned long sampleIntervalMs = thresholdMs / 4;
+
+	//Stripes shorter than the time threshold never fail, whatever their phase relative to the samples
+	for (const unsigned long onsetMs : { 1000ul, 1000ul + sampleIntervalMs / 2, 1000ul + sampleIntervalMs - FrameIntervalMs })
+	{
+		const FStripeClipResult shortStripes = RunStripeClip(configurationDir, onsetMs, thresholdMs - 2 * FrameIntervalMs, 3000);
+		TestEqual(FString::Printf(TEXT("No PatternFail for stripes shorter than the threshold from %u ms"), onsetMs), shortStripes.failFrames, 0);
+	}
+
+	//Stripes lasting just over the threshold and longer always fail, at every phase relative to the samples and with the
+	//static frames skipped, on the first frame whose window they fill as with every frame checked
+	for (const bool bSkipStatic : { false, true })
+	{
+		for (const unsigned long durationMs : { thresholdMs + 2 * FrameIntervalMs, thresholdMs + sampleIntervalMs + 2 * FrameIntervalMs })
+		{
+			for (unsigned long phaseMs = 0; phaseMs < sampleIntervalMs + FrameIntervalMs; phaseMs += FrameIntervalMs / 2)
+			{
+				const unsigned long onsetMs = 1000 + phaseMs;
+				const FStripeClipResult stripes = RunStripeClip(configurationDir, onsetMs, durationMs, 3000, bSkipStatic);
+				const FString label = FString::Printf(TEXT("%u ms stripes from %u ms%s"), durationMs, onsetMs, bSkipStatic ? TEXT(", static frames skipped") : TEXT(""));
+				if (!TestTrue(FString::Printf(TEXT("PatternFail for %s"), *label), stripes.failFrames > 0))
+				{
+					continue;
+				}
+				TestTrue(FString::Printf(TEXT("PatternFail not reported early for %s"), *label), stripes.firstFailMs + FrameIntervalMs >= onsetMs + thresholdMs);
+				TestTrue(FString::Printf(TEXT("PatternFail reported once the window is full for %s"), *label), stripes.firstFailMs <= onsetMs + thresholdMs + FrameIntervalMs);
+				TestTrue(FString::Printf(TEXT("PatternFail ends with the stripes for %s"), *label), stripes.lastFailMs < onsetMs + durationMs);
+			}
+		}
+	}
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
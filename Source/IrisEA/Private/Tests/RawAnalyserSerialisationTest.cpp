@@ -0,0 +1,132 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "Misc/AutomationTest.h"
+#include "RawFrameIngest.h"
+#include "FrameDataBinaryLog.h"
+#include "Async/Async.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/Paths.h"
+#include <FrameStruct.h>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	constexpr int32 AnalyserCount = 16;
+	constexpr int32 StreamFrames = 180;
+	constexpr int32 FrameWidth = 160;
+	constexpr int32 FrameHeight = 90;
+
+	FString GetConfigurationDir()
+	{
+		return FPaths::Combine(IPluginManager::Get().FindPlugin("IrisEA")->GetBaseDir(), TEXT("Source/ThirdParty/IrisLibrary/Win64/"));
+	}
+
+	//60 fps BGR8 stream of its own: a quadrant flashing between a gray level and black at a period of its own, from a
+	//frame of its own
+	TArray<cv::Mat> MakeStream(int32 stream)
+	{
+		const int32 flashPeriod = 2 + stream % 8;
+		const int32 flashStart = (stream * 7) % 60;
+		const uint8 gray = static_cast<uint8>(128 + stream * 8);
+		const cv::Rect quadrant((stream % 2) * FrameWidth / 2, ((stream / 2) % 2) * FrameHeight / 2, FrameWidth / 2, FrameHeight / 2);
+
+		TArray<cv::Mat> frames;
+		for (int32 frame = 0; frame < StreamFrames; frame++)
+		{
+			cv::Mat bgr(FrameHeight, FrameWidth, CV_8UC3, cv::Scalar::all(gray));
+			if (frame >= flashStart && ((frame - flashStart) / flashPeriod) % 2 == 0)
+			{
+				bgr(quadrant).setTo(cv::Scalar::all(0));
+			}
+			frames.Add(bgr);
+		}
+		return frames;
+	}
+
+	//Analyses the stream with an analyser of its own, empty if the analyser could not be created
+	TArray<FIrisFrameRecord> AnalyseStream(const FString& configurationDir, const TArray<cv::Mat>& frames)
+	{
+		TArray<FIrisFrameRecord> records;
+		RawFrameAnalyser* analyser = IrisCreateRawAnalyser(*configurationDir, FrameWidth, FrameHeight);
+		if (analyser == nullptr)
+		{
+			return records;
+		}
+		records.SetNum(frames.Num());
+		for (int32 i = 0; i < frames.Num(); i++)
+		{
+			FIrisRawFrame rawFrame;
+			rawFrame.format = EIrisPixelFormat::BGR8;
+			rawFrame.data = frames[i].data;
+			rawFrame.width = FrameWidth;
+			rawFrame.height = FrameHeight;
+			rawFrame.stride = static_cast<int32>(frames[i].step);
+			rawFrame.timeStampUs = static_cast<uint64>(i * 1000000.0 / 60.0);
+			IrisAnalyseRawFrame(analyser, rawFrame, records[i]);
+		}
+		IrisDestroyRawAnalyser(analyser);
+		return records;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIrisRawAnalyserSerialisationTest, "Iris.RawFrameIngest.SerialisedAnalysers", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FIrisRawAnalyserSerialisationTest::RunTest(const FString& Parameters)
+{
+	const FString configurationDir = GetConfigurationDir();
+	TArray<TArray<cv::Mat>> streams;
+	for (int32 stream = 0; stream < AnalyserCount; stream++)
+	{
+		streams.Add(MakeStream(stream));
+	}
+
+	//An analyser holds the IRIS library until it is destroyed
+	RawFrameAnalyser* holder = IrisCreateRawAnalyser(*configurationDir, FrameWidth, FrameHeight, 0.f);
+	if (!TestNotNull(TEXT("Analyser created"), holder))
+	{
+		return false;
+	}
+	TestNull(TEXT("No second analyser while the library is held"), IrisCreateRawAnalyser(*configurationDir, FrameWidth, FrameHeight, 0.f));
+	IrisDestroyRawAnalyser(holder);
+
+	TArray<TArray<FIrisFrameRecord>> serialRecords;
+	for (int32 stream = 0; stream < AnalyserCount; stream++)
+	{
+		serialRecords.Add(AnalyseStream(configurationDir, streams[stream]));
+	}
+
+	//The same streams from an analyser thread each, started together: the analysers take the library one after the other
+	//and none may see the state of the one before it
+	TArray<TFuture<TArray<FIrisFrameRecord>>> threadRecords;
+	for (int32 stream = 0; stream < AnalyserCount; stream++)
+	{
+		threadRecords.Add(Async(EAsyncExecution::Thread, [&configurationDir, &streams, stream]()
+			{
+				return AnalyseStream(configurationDir, streams[stream]);
+			}));
+	}
+
+	bool bFlashes = false;
+	for (int32 stream = 0; stream < AnalyserCount; stream++)
+	{
+		const TArray<FIrisFrameRecord>& serial = serialRecords[stream];
+		const TArray<FIrisFrameRecord> threaded = threadRecords[stream].Get();
+		if (!TestEqual(FString::Printf(TEXT("Stream %d analysed serially"), stream), serial.Num(), StreamFrames)
+			|| !TestEqual(FString::Printf(TEXT("Stream %d analysed from its thread"), stream), threaded.Num(), StreamFrames))
+		{
+			continue;
+		}
+		int32 firstDifference = INDEX_NONE;
+		for (int32 frame = 0; frame < StreamFrames && firstDifference == INDEX_NONE; frame++)
+		{
+			firstDifference = serial[frame] == threaded[frame] ? INDEX_NONE : frame;
+			bFlashes |= serial[frame].luminanceTransitions > 0;
+		}
+		TestEqual(FString::Printf(TEXT("Stream %d first frame differing from the serial run"), stream), firstDifference, static_cast<int32>(INDEX_NONE));
+	}
+	TestTrue(TEXT("The streams have luminance transitions"), bFlashes);
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
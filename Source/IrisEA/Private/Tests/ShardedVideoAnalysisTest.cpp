@@ -0,0 +1,217 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "Misc/AutomationTest.h"
+#include "ShardedVideoAnalysis.h"
+#include "IrisAnalysisContext.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include <FrameStruct.h>
+
+THIRD_PARTY_INCLUDES_START
+#include "iris/Configuration.h"
+#include "iris/VideoAnalyser.h"
+#include "utils/JsonWrapper.h"
+THIRD_PARTY_INCLUDES_END
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	constexpr int32 VideoFrames = 480; //16 s at 30 fps
+	constexpr double VideoFps = 30.0;
+	constexpr int32 ShardCount = 4;
+	constexpr double ShardTimeoutSeconds = 600.0;
+
+	FString GetConfigurationDir()
+	{
+		return FPaths::Combine(IPluginManager::Get().FindPlugin("IrisEA")->GetBaseDir(), TEXT("Source/ThirdParty/IrisLibrary/Win64/"));
+	}
+
+	//MJPG video (decoded the same way by every process) of a quadrant flashing at a period changing every 2 s, with a
+	//static span and a red flash span crossing the shard boundaries
+	bool WriteVideo(const FString& videoPath)
+	{
+		const cv::Size frameSize(320, 176);
+		cv::VideoWriter writer(TCHAR_TO_UTF8(*videoPath), cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), VideoFps, frameSize);
+		if (!writer.isOpened())
+		{
+			return false;
+		}
+		const cv::Rect quadrant(0, 0, frameSize.width / 2, frameSize.height / 2);
+		for (int32 frame = 0; frame < VideoFrames; frame++)
+		{
+			const int32 second = static_cast<int32>(frame / VideoFps);
+			const int32 flashPeriod = 2 + (second / 2) % 4;
+			const bool bStatic = second >= 6 && second < 8;
+			const bool bRed = second >= 11 && second < 13;
+			const bool bOn = !bStatic && (frame / flashPeriod) % 2 == 0;
+			cv::Mat image(frameSize, CV_8UC3, cv::Scalar::all(90));
+			image(quadrant).setTo(!bOn ? cv::Scalar::all(20) : (bRed ? cv::Scalar(0, 0, 255) : cv::Scalar::all(235)));
+			writer.write(image);
+		}
+		writer.release();
+		return true;
+	}
+
+	//File named fileName written under directory, the VideoAnalyser may write its results in a folder of the video
+	FString FindResultFile(const FString& directory, const TCHAR* fileName)
+	{
+		TArray<FString> files;
+		IFileManager::Get().FindFilesRecursive(files, *directory, fileName, true, false);
+		return files.IsEmpty() ? FString() : files[0];
+	}
+
+	//Frame rows of a FrameData.csv, without the header and the null terminators of FrameData::ToCSV
+	TArray<std::string> ReadCsvRows(const FString& csvPath)
+	{
+		TArray<std::string> rows;
+		TArray<uint8> bytes;
+		if (csvPath.IsEmpty() || !FFileHelper::LoadFileToArray(bytes, *csvPath))
+		{
+			return rows;
+		}
+		std::string row;
+		for (const uint8 byte : bytes)
+		{
+			if (byte == '\n')
+			{
+				rows.Add(row);
+				row.clear();
+			}
+			else if (byte != '\0' && byte != '\r')
+			{
+				row += static_cast<char>(byte);
+			}
+		}
+		if (!row.empty())
+		{
+			rows.Add(row);
+		}
+		if (!rows.IsEmpty())
+		{
+			rows.RemoveAt(0);
+		}
+		return rows;
+	}
+
+	//Result.json without the analysis time
+	json ReadResult(const FString& resultPath)
+	{
+		FString text;
+		FFileHelper::LoadFileToString(text, *resultPath);
+		json result = json::parse(TCHAR_TO_UTF8(*text), nullptr, false);
+		if (result.is_object())
+		{
+			result.erase("AnalysisTime");
+		}
+		return result;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FIrisShardedVideoTest, "Iris.ShardedVideoAnalysis.MatchesVideoAnalyser", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FIrisShardedVideoTest::RunTest(const FString& Parameters)
+{
+	const FString configurationDir = GetConfigurationDir();
+	const FString sharedDir = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("IrisShards")));
+	const FString videoPath = sharedDir / TEXT("ShardTest.avi");
+	IFileManager::Get().DeleteDirectory(*sharedDir, false, true);
+	IFileManager::Get().MakeDirectory(*sharedDir, true);
+	if (!TestTrue(TEXT("Test video written"), WriteVideo(videoPath)))
+	{
+		return false;
+	}
+
+	//Each shard in a process of its own, as a distributed run
+	TArray<FProcHandle> shardProcesses;
+	for (int32 shard = 0; shard < ShardCount; shard++)
+	{
+		const FString params = FString::Printf(TEXT("\"%s\" -game -nullrhi -nosound -unattended -nosplash -ExecCmds=\"Iris.AnalyseVideoShard %s %d %d %s parallel,Quit\""),
+			*FPaths::GetProjectFilePath(), *videoPath, shard, ShardCount, *sharedDir);
+		shardProcesses.Add(FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *params, false, true, true, nullptr, 0, nullptr, nullptr));
+		TestTrue(FString::Printf(TEXT("Shard %d process started"), shard), shardProcesses.Last().IsValid());
+	}
+
+	//The reference, the whole video analysed by VideoAnalyser::AnalyseVideo as the IRIS application does, while the
+	//shard processes run. It holds the IRIS library statics like an analyser of this process
+	const FString referenceDir = sharedDir / TEXT("Reference");
+	IFileManager::Get().MakeDirectory(*referenceDir, true);
+	{
+		FIrisAnalysisContext libraryHolder;
+		if (TestTrue(TEXT("IRIS library acquired"), libraryHolder.AcquireLibrary(ShardTimeoutSeconds)))
+		{
+			iris::Configuration configuration;
+			configuration.Init(TCHAR_TO_UTF8(*configurationDir));
+			configuration.SetResultsPath(TCHAR_TO_UTF8(*(referenceDir + TEXT("/"))));
+			iris::VideoAnalyser videoAnalyser(&configuration);
+			videoAnalyser.AnalyseVideo(true, TCHAR_TO_UTF8(*videoPath));
+			libraryHolder.ReleaseLibrary();
+		}
+	}
+
+	const double endTime = FPlatformTime::Seconds() + ShardTimeoutSeconds;
+	for (FProcHandle& process : shardProcesses)
+	{
+		while (process.IsValid() && FPlatformProcess::IsProcRunning(process) && FPlatformTime::Seconds() < endTime)
+		{
+			FPlatformProcess::Sleep(0.1f);
+		}
+		if (process.IsValid() && FPlatformProcess::IsProcRunning(process))
+		{
+			AddError(TEXT("A shard process did not finish in time"));
+			FPlatformProcess::TerminateProc(process, true);
+		}
+		FPlatformProcess::CloseProc(process);
+	}
+
+	const FString mergedDir = sharedDir / TEXT("Merged");
+	if (!TestTrue(TEXT("Shards merged"), ShardedVideoAnalysis::MergeShards(sharedDir, TEXT("ShardTest"), ShardCount, TEXT("parallel"), mergedDir)))
+	{
+		return false;
+	}
+	//The shards of another session are not merged
+	TestFalse(TEXT("No merge of a session without shards"), ShardedVideoAnalysis::MergeShards(sharedDir, TEXT("ShardTest"), ShardCount, TEXT("stale"), sharedDir / TEXT("Stale")));
+
+	//Same frame rows as the VideoAnalyser
+	const TArray<std::string> referenceRows = ReadCsvRows(FindResultFile(referenceDir, TEXT("FrameData.csv")));
+	const TArray<std::string> mergedRows = ReadCsvRows(mergedDir / TEXT("FrameData.csv"));
+	TestEqual(TEXT("Reference frames"), referenceRows.Num(), VideoFrames);
+	TestEqual(TEXT("Merged frames"), mergedRows.Num(), referenceRows.Num());
+	int32 firstDifference = INDEX_NONE;
+	for (int32 frame = 0; frame < FMath::Min(referenceRows.Num(), mergedRows.Num()) && firstDifference == INDEX_NONE; frame++)
+	{
+		firstDifference = referenceRows[frame] == mergedRows[frame] ? INDEX_NONE : frame;
+	}
+	if (!TestEqual(TEXT("First merged frame differing from the reference"), firstDifference, static_cast<int32>(INDEX_NONE)))
+	{
+		AddInfo(FString::Printf(TEXT("Reference: %hs"), referenceRows[firstDifference].c_str()));
+		AddInfo(FString::Printf(TEXT("Merged: %hs"), mergedRows[firstDifference].c_str()));
+	}
+
+	//Same failing frames and verdict as the VideoAnalyser Result.json
+	const json reference = ReadResult(FindResultFile(referenceDir, TEXT("Result.json")));
+	const json merged = ReadResult(mergedDir / TEXT("Result.json"));
+	if (!TestTrue(TEXT("Reference result read"), reference.is_object()) || !TestTrue(TEXT("Merged result read"), merged.is_object()))
+	{
+		return false;
+	}
+	for (const char* incidents : { "TotalLuminanceIncidents", "TotalRedIncidents" })
+	{
+		for (const char* frames : { "FlashFailFrames", "ExtendedFailFrames" })
+		{
+			TestEqual(FString::Printf(TEXT("%hs %hs"), incidents, frames), merged.value(incidents, json::object()).value(frames, -1),
+				reference.value(incidents, json::object()).value(frames, -1));
+		}
+	}
+	TestEqual(TEXT("PatternFailFrames"), merged.value("PatternFailFrames", -1), reference.value("PatternFailFrames", -1));
+	TestTrue(TEXT("Same OverallResult"), merged.value("OverallResult", json()) == reference.value("OverallResult", json()));
+	TestTrue(TEXT("The video fails"), reference.value("TotalLuminanceIncidents", json::object()).value("FlashFailFrames", 0) > 0);
+
+	IFileManager::Get().DeleteDirectory(*sharedDir, false, true);
+	return true;
+}
+
+#endif //WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,127 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#include "TieredAnalysis.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "iris/VideoAnalyser.h"
+THIRD_PARTY_INCLUDES_END
+
+TieredAnalysis::TieredAnalysis(iris::VideoAnalyser* analyser)
+	: videoAnalyser(analyser)
+{
+}
+
+void TieredAnalysis::Initialize(const cv::Size& lowSize, const cv::Size& highSize, int suspicionTransitions, float windowSeconds)
+{
+	Reset();
+	lowResolutionSize = lowSize;
+	highResolutionSize = highSize;
+	suspicionLevel = FMath::Max(1, suspicionTransitions);
+	ringSeconds = FMath::Max(windowSeconds, relaxSeconds);
+}
+
+void TieredAnalysis::Reset()
+{
+	switchTask.Wait();
+	frameRing.Empty();
+	quietSinceMs = 0;
+	bConfirming = false;
+}
+
+void TieredAnalysis::AnalyseFrame(cv::Mat& bgrFrame, iris::FrameData& frameData, const UE::Tasks::FTask& concurrentTask)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IrisTieredAnalysis);
+
+	//The VideoAnalyser and the ring belong to the replay until it is done
+	switchTask.Wait();
+
+	PushToRing(bgrFrame, frameData);
+	AnalyseOnActiveTier(bgrFrame, frameData);
+
+	if (!bConfirming)
+	{
+		if (IsSuspicious(frameData))
+		{
+			//The window, this frame included, is confirmed at the high resolution before the next frame
+			quietSinceMs = frameData.TimeStampVal;
+			SwitchTier(true, concurrentTask);
+		}
+		return;
+	}
+
+	if (!IsQuiet(frameData))
+	{
+		quietSinceMs = frameData.TimeStampVal;
+	}
+	else if (frameData.TimeStampVal - quietSinceMs >= relaxSeconds * 1000)
+	{
+		//Current verdict already reported, the next frames are analysed on the low resolution tier
+		SwitchTier(false, concurrentTask);
+	}
+}
+
+void TieredAnalysis::SwitchTier(bool bHighResolution, const UE::Tasks::FTask& prerequisite)
+{
+	bConfirming = bHighResolution;
+	auto replay = [this]()
+		{
+			TRACE_CPUPROFILER_EVENT_SCOPE(IrisTieredAnalysisSwitch);
+			const double startTime = FPlatformTime::Seconds();
+
+			cv::Size tierSize = bConfirming ? highResolutionSize : lowResolutionSize;
+			videoAnalyser->DeInit();
+			videoAnalyser->RealTimeInit(tierSize);
+			for (FIrisFrame& ringFrame : frameRing)
+			{
+				iris::FrameData replayData(ringFrame.frameData.Frame, ringFrame.frameData.TimeStampVal);
+				AnalyseOnActiveTier(ringFrame.frameMatrix, replayData);
+			}
+
+			UE_LOG(LogTemp, Log, TEXT("Iris tiered analysis: %s tier active (%d buffered frames replayed in %.1f ms)"), bConfirming ? TEXT("confirmation") : TEXT("low resolution"),
+				frameRing.Num(), (FPlatformTime::Seconds() - startTime) * 1000.0);
+		};
+	switchTask = prerequisite.IsValid() ? UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(replay), UE::Tasks::Prerequisites(prerequisite))
+		: UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(replay));
+}
+
+void TieredAnalysis::AnalyseOnActiveTier(cv::Mat& capturedFrame, iris::FrameData& frameData)
+{
+	if (bConfirming)
+	{
+		videoAnalyser->AnalyseFrame(capturedFrame, frameData.Frame, frameData);
+		return;
+	}
+
+	//Analyser sizes are {rows, cols}
+	cv::resize(capturedFrame, lowResolutionFrame, cv::Size(lowResolutionSize.height, lowResolutionSize.width), 0, 0, cv::INTER_AREA);
+	videoAnalyser->AnalyseFrame(lowResolutionFrame, frameData.Frame, frameData);
+}
+
+void TieredAnalysis::PushToRing(const cv::Mat& bgrFrame, const iris::FrameData& frameData)
+{
+	FIrisFrame& ringFrame = frameRing.Emplace_GetRef();
+	ringFrame.frameMatrix = bgrFrame;
+	ringFrame.frameData = iris::FrameData(frameData.Frame, frameData.TimeStampVal);
+
+	int32 framesToRemove = 0;
+	while (framesToRemove < frameRing.Num() - 1 && frameData.TimeStampVal - frameRing[framesToRemove].frameData.TimeStampVal > ringSeconds * 1000)
+	{
+		framesToRemove++;
+	}
+	frameRing.RemoveAt(0, framesToRemove);
+}
+
+bool TieredAnalysis::IsSuspicious(const iris::FrameData& frameData) const
+{
+	return static_cast<int>(frameData.LuminanceTransitions) >= suspicionLevel
+		|| static_cast<int>(frameData.RedTransitions) >= suspicionLevel
+		|| frameData.luminanceFrameResult != iris::FlashResult::Pass
+		|| frameData.redFrameResult != iris::FlashResult::Pass;
+}
+
+bool TieredAnalysis::IsQuiet(const iris::FrameData& frameData) const
+{
+	return frameData.LuminanceTransitions == 0 && frameData.RedTransitions == 0
+		&& frameData.LuminanceExtendedFailCount == 0 && frameData.RedExtendedFailCount == 0;
+}
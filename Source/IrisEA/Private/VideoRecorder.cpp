@@ -1,12 +1,11 @@
 //Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
 
 #include "VideoRecorder.h"
+#include "HalfFloatConversion.h"
 
-VideoRecorder::VideoRecorder(iris::Configuration& config)
+VideoRecorder::VideoRecorder()
 {
     fourcc = cv::VideoWriter::fourcc('m', 'p', '4', 'v');
-    FrameManager::GetInstance()->Init(&config);
-    frameManagerIndex = FrameManager::GetInstance()->RegisterNewElem(1.0f, 60);
 }
 
 void VideoRecorder::CreateDirectory()
@@ -25,18 +24,47 @@ void VideoRecorder::Reset()
         videoWriter.release();
         RenameVideo();
     }
-    FrameManager::GetInstance()->FrameTsReset(frameManagerIndex);
+    frameTimeStamps.Empty();
+    framesInWindow = 0;
     lastFramesQueue.Empty();
     framesInsideQueue = 0;
+    lastRecordedFrame.release();
 }
 
-void VideoRecorder::EnqueueLastFrameAndCheck(FIrisFrame irisFrame, std::string lumResultStr, std::string redResultStr, std::string patternResultStr)
+void VideoRecorder::EnqueueLastFrameAndCheck(const FIrisFrame& irisFrame, const cv::Mat& analysedFrame, std::string lumResultStr, std::string redResultStr, std::string patternResultStr)
 {
-    //Update FrameManager
-    FrameManager::GetInstance()->NewFrameEntry(irisFrame.frameData);
-    sessionFPS = FrameManager::GetInstance()->GetFrameNumInWindow(frameManagerIndex);
+    //Frames of the last second, the shared IRIS FrameManager windows belong to the analyser
+    frameTimeStamps.Enqueue(irisFrame.frameData.TimeStampVal);
+    framesInWindow++;
+    unsigned long oldestTimeStamp = 0;
+    while (frameTimeStamps.Peek(oldestTimeStamp) && irisFrame.frameData.TimeStampVal - oldestTimeStamp >= 1000)
+    {
+        frameTimeStamps.Pop();
+        framesInWindow--;
+    }
+    sessionFPS = framesInWindow;
 
-    lastFramesQueue.Enqueue(irisFrame.frameMatrix);
+    //The captured frame is a view of the readback buffer, the recorder keeps its own BGR copy of the analysed frame. A
+    //static frame is the last analysed one, the recorded frame is shared
+    cv::Mat recordedFrame;
+    if (!analysedFrame.empty())
+    {
+        analysedFrame.copyTo(recordedFrame);
+    }
+    else if (!lastRecordedFrame.empty() && lastRecordedFrame.size() == irisFrame.frameMatrix.size())
+    {
+        recordedFrame = lastRecordedFrame;
+    }
+    else if (irisFrame.frameMatrix.depth() == CV_16F)
+    {
+        HalfFloatConversion::EncodeFrameBGR(irisFrame.frameMatrix, displayTransform, recordedFrame);
+    }
+    else
+    {
+        cv::cvtColor(irisFrame.frameMatrix, recordedFrame, cv::COLOR_BGRA2BGR);
+    }
+    lastRecordedFrame = recordedFrame;
+    lastFramesQueue.Enqueue(recordedFrame);
     framesInsideQueue++;
     int framesToSubstract = 0;
 
@@ -0,0 +1,151 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Pipe.h"
+#include <FrameStruct.h>
+#include <atomic>
+
+class IncidentIndex;
+
+/**
+ * Frame of the checkpoint warm-up tail
+ */
+struct FIrisCheckpointFrame
+{
+	uint32 frame = 0;
+	uint32 timeStampMs = 0;
+	bool bHalfFloat = false; //data holds the linear half float RGBA frame instead of a PNG
+	TArray<uint8> data; //PNG of the 8 bit BGR frame given to the IRIS library or zlib compressed half float frame, empty when it repeats the previous frame
+};
+
+/**
+ * Analysis checkpoint (.irisckpt), written every interval of frame time so a soak session or a long offline job can
+ * resume after a crash or a restart.
+ * The time windows, flash accumulators and transition counts of the prebuilt IRIS library can not be read from the
+ * plugin, so the checkpoint keeps the frames of the longest IRIS window (extendedFailWindow seconds plus one second)
+ * instead of their values: replaying this warm-up tail at the start of a new session rebuilds the library windows and
+ * the plugin stages that follow the frames (tile grid, region tracker, pattern persistence, static frame filter), and
+ * the next frames get the verdicts of an uninterrupted analysis. A flash variation still accumulating from before the
+ * tail is the only state the replay does not rebuild. The incidents are stored as they are.
+ * The 8 bit frames are stored as the PNG of the frame given to the IRIS library. The linear half float frames are stored
+ * as they are (zlib), so the replay converts them with the display transform like the analysis did instead of reading
+ * back an 8 bit encoding of them.
+ * The frames are copied on the analysis thread, encoded and written in order on a worker (a task graph pipe).
+ *
+ * Layout: { "IRCK", version, configuration content hash, frame width, height, next frame, last time stamp, time origin,
+ * incidents, tail frame count, then for each tail frame: frame, time stamp, half float flag, frame bytes }
+ */
+class IRISEA_API AnalysisCheckpoint
+{
+public:
+	static constexpr uint32 Version = 2;
+
+	//Frames copied and waiting for the worker, the analysis waits for it beyond
+	static constexpr int32 MaxPendingFrames = 60;
+
+	~AnalysisCheckpoint();
+
+	/// <summary>
+	//Starts recording the analysed frames, a checkpoint is written to path every intervalSeconds of frame time (never
+	//when 0). The tail of a loaded checkpoint is kept so the resumed session can be checkpointed again
+	/// </summary>
+	void Begin(const FString& checkpointPath, float intervalSeconds, uint64 configurationHash, uint32 extendedFailWindowSeconds);
+
+	/// <summary>
+	//Adds an analysed frame: analysisFrame is the frame given to the IRIS library, empty for a skipped static frame, and
+	//sourceFrame the captured frame it was converted from. The frame is copied, then encoded on the worker
+	/// </summary>
+	void PushFrame(const cv::Mat& sourceFrame, const cv::Mat& analysisFrame, const iris::FrameData& frameData);
+
+	bool IsDue(unsigned long timeStampMs) const { return intervalMs > 0 && timeStampMs >= lastSaveMs + intervalMs; }
+
+	/// <summary>
+	//Queues the checkpoint write after the frames pushed so far (through a temporary file, the last checkpoint stays
+	//valid if the process dies while writing), false without a checkpoint path
+	/// </summary>
+	bool Save(IncidentIndex& incidents);
+
+	/// <summary>
+	//Waits until the worker has encoded the pushed frames and written the queued checkpoints
+	/// </summary>
+	void Flush();
+
+	/// <summary>
+	//Loads a checkpoint to resume from, fails if it does not exist or was written with another configuration
+	/// </summary>
+	bool Load(const FString& checkpointPath, uint64 configurationHash);
+
+	/// <summary>
+	//True from Load until the warm-up tail has been replayed
+	/// </summary>
+	bool IsResuming() const { return bResuming; }
+
+	/// <summary>
+	//Decodes the warm-up tail, the repeated frames share the matrix of the previous one
+	/// </summary>
+	void GetTailFrames(TArray<FIrisFrame>& outFrames) const;
+
+	/// <summary>
+	//Gives the incidents back to the index once the tail has been replayed, ends the resume
+	/// </summary>
+	void EndResume(IncidentIndex& incidents);
+
+	const FString& GetPath() const { return path; }
+	uint32 GetNextFrame() const { return nextFrame; }
+	uint32 GetLastTimeStampMs() const { return lastTimeStampMs; }
+	/// <summary>
+	//Value stored for the caller, the raw frame API keeps the time stamp of its first frame in it
+	/// </summary>
+	void SetTimeOrigin(uint64 origin) { timeOrigin = origin; }
+	uint64 GetTimeOrigin() const { return timeOrigin; }
+	cv::Size GetFrameSize() const { return frameSize; }
+
+	/// <summary>
+	//Stops recording and forgets the tail
+	/// </summary>
+	void Reset();
+
+private:
+
+	/// <summary>
+	//Worker. Encodes the frame copy into the tail frame data
+	/// </summary>
+	void EncodeFrame(const cv::Mat& frame, FIrisCheckpointFrame& outTailFrame);
+
+	/// <summary>
+	//Worker. Appends a frame to the tail and removes the frames older than tailMs
+	/// </summary>
+	void AddTailFrame(FIrisCheckpointFrame&& tailFrame);
+
+	/// <summary>
+	//Worker. Writes the checkpoint file
+	/// </summary>
+	void WriteFile(const FString& filePath, const TArray<uint8>& header, const TArray<uint8>& incidentsData);
+
+	FString path;
+	uint64 contentHash = 0;
+	uint32 tailMs = 0;
+	uint32 intervalMs = 0;
+	uint32 lastSaveMs = 0;
+
+	//Frames of the last tailMs, oldest first, the first one always holds its data. Only the worker changes it once the
+	//checkpoint is recording
+	TArray<FIrisCheckpointFrame> tail;
+	std::vector<uchar> encodeBuffer; //reused PNG encoding buffer of the worker
+
+	UE::Tasks::FPipe writePipe{ TEXT("IrisCheckpoint") };
+	UE::Tasks::FTask lastWriteTask; //last task of the pipe
+	std::atomic<int32> pendingFrames{ 0 };
+
+	bool bHasTail = false; //a frame with its data was pushed, the repeated frames are recorded from then
+	cv::Size frameSize; //width x height of the tail frames
+	uint32 nextFrame = 0;
+	uint32 lastTimeStampMs = 0;
+	uint64 timeOrigin = 0;
+
+	//Loaded checkpoint
+	bool bResuming = false;
+	TArray<uint8> incidentState;
+};
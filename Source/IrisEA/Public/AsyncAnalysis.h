@@ -5,17 +5,121 @@
 #include "CoreMinimal.h"
 #include "HAL/Runnable.h"
 #include "HAL/RunnableThread.h"
+#include "StaticFrameFilter.h"
+#include "FrameTileGrid.h"
+#include <string>
+
+struct FIrisAnalysisContext;
+
+/**
+ * Per-frame conversions of a batch frame, made in parallel before the frame is analysed in order
+ */
+struct FIrisPreparedFrame
+{
+	FConvertedTiles tiles; //FrameTileGrid tiles that changed since the previous frame
+	cv::Mat bgrFrame; //conversion buffer of the IRIS library frame
+	cv::Mat analysisFrame; //frame given to the IRIS library
+	bool bPrepared = false; //false for the repeated frames, converted in order if the static frame filter does not skip them
+	bool bPlanes = false; //tiles are only converted when a plugin stage reads the tile grid
+};
 
 class IRISEA_API AsyncAnalysis : public FRunnable
 {
 public:
+	//Frames prepared at once by AnalyseFrames, the prepared buffers never hold more whatever the batch size
+	static constexpr int32 BatchChunkFrames = 32;
+
+	AsyncAnalysis(FIrisAnalysisContext& analysisContext) : context(analysisContext) {};
+
 	bool Init() override;
 	/// <summary>
-	// Async thread, frames are analysed while irisActive and frameQueue is not empty
+	// Async thread, the frames of the context queue are analysed while the context is active
 	/// </summary>
 	uint32 Run() override;
 	void Stop() override;
 
+	/// <summary>
+	//Prepares the analysis of a frame stream, the context session must have begun
+	/// </summary>
+	void BeginAnalysis();
+
+	/// <summary>
+	//Analyses one frame (BGRA, BGR or linear half float RGBA) and fills its frameData, then feeds the context stages and outputs
+	/// </summary>
+	void AnalyseFrame(FIrisFrame& frame);
+
+	/// <summary>
+	//Analyses a batch of consecutive frames in chunks of BatchChunkFrames: the conversions that only depend on the frame
+	//(tile checksums when missing, luminance and red saturation of the tiles that changed since the previous frame, IRIS
+	//library frame) run in parallel, then the frames go through the order dependent stages one by one. Same results as
+	//calling AnalyseFrame on each frame.
+	//Only the plugin preparation is parallel: the IRIS library converts each frame (sRGB, luminance and red saturation)
+	//and runs its time windows inside VideoAnalyser::AnalyseFrame, which stays sequential, so the batch speedup is bounded
+	//by the share of the frame time spent in the preparation
+	/// </summary>
+	void AnalyseFrames(TArrayView<FIrisFrame> frames);
+
+	/// <summary>
+	//Resets the analysis and ends the context session
+	/// </summary>
+	void EndAnalysis();
+
 private:
-	TArray<FString> resultString = { "Pass", "PassWithWarning", "ExtendedFail" ,"FlashFail" };
+
+	void AnalysePreparedFrame(FIrisFrame& frame, FIrisPreparedFrame* prepared);
+
+	/// <summary>
+	//Prepares frames [first, first + count) of the batch in parallel into preparedFrames, returns the summed preparation
+	//time of the frames
+	/// </summary>
+	double PrepareFrames(TArrayView<FIrisFrame> frames, int32 first, int32 count);
+
+	/// <summary>
+	//True if a plugin stage reads the tile grid (region tracking, pattern detection of a relative luminance session),
+	//the IRIS library converts the frames on its own
+	/// </summary>
+	bool NeedsTileGrid() const;
+
+	/// <summary>
+	//Replays the warm-up tail of the loaded checkpoint without session outputs, then restores its incidents
+	/// </summary>
+	void ResumeFromCheckpoint();
+
+	/// <summary>
+	//Makes the 8 bit BGR frame of the IRIS library, in buffer when the frame can not be given as it is
+	/// </summary>
+	void ConvertAnalysisFrame(const cv::Mat& frameMatrix, cv::Mat& buffer, cv::Mat& outAnalysisFrame) const;
+
+	//Analyser state and session outputs
+	FIrisAnalysisContext& context;
+
+	const std::string resultString[4] = { "Pass", "PassWithWarning", "ExtendedFail" ,"FlashFail" };
+
+	//Skips the per-pixel analysis of repeated frames
+	StaticFrameFilter staticFrameFilter;
+
+	//Incremental luminance and red saturation planes of the analysed frames, converted straight from the BGRA readback view
+	FrameTileGrid tileGrid;
+
+	//Relative luminance plane of the pattern detection in CD luminance sessions
+	cv::Mat relativeLuminance;
+
+	//BGR copy of the frame for the IRIS library, only made for the frames it analyses
+	cv::Mat bgrFrame;
+
+	//Conversions of the last batch chunk, the buffers are reused by the next one
+	TArray<FIrisPreparedFrame> preparedFrames;
+
+	//Batch measurements of the session: the preparation scaling is the summed preparation time of the frames over its
+	//wall time
+	int32 batchFrames = 0;
+	double batchPrepareSeconds = 0.0;
+	double batchPrepareFrameSeconds = 0.0;
+	double batchOrderedSeconds = 0.0;
+
+	//Checkpoint tail replay, the frames only update the analyser state
+	bool bWarmingUp = false;
+
+	//Frames given to the IRIS library in a video session
+	unsigned int videoFrames = 0;
 };
@@ -0,0 +1,111 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace iris
+{
+	class Configuration;
+	struct FlashParams;
+	struct TransitionTrackerParams;
+}
+
+struct FIrisSharedConfiguration;
+
+/**
+ * Parsed appsettings.json values used by the plugin
+ */
+struct FIrisConfigurationSnapshot
+{
+	uint64 contentHash = 0; //CityHash64 of appsettings.json
+
+	float luminanceFlashThreshold = 0.f;
+	float luminanceAreaProportion = 0.f;
+	float luminanceDarkThreshold = 0.f;
+	float redFlashThreshold = 0.f;
+	float redAreaProportion = 0.f;
+	float redDarkThreshold = 0.f;
+
+	uint32 maxTransitions = 0;
+	uint32 minTransitions = 0;
+	uint32 extendedFailSeconds = 0;
+	uint32 extendedFailWindow = 0;
+	uint32 warningTransitions = 0;
+
+	int32 patternMinStripes = 0;
+	float patternDarkLuminanceThreshold = 0.f;
+	float patternTimeThreshold = 0.f;
+	float patternAreaProportion = 0.f;
+
+	uint8 luminanceType = 0; //iris::Configuration::LuminanceType
+	uint8 bPatternDetectionEnabled = 0;
+	uint8 bAnalyseByTime = 0;
+	uint8 padding = 0;
+
+	float sRgbValues[256] = {};
+	float cdLuminanceValues[256] = {};
+};
+
+/**
+ * Snapshot of the parsed configuration, so the plugin stages and analysis workers get their parameters and look up
+ * tables without an iris::Configuration of their own. It is taken from the iris::Configuration parsed for the
+ * VideoAnalyser, appsettings.json is only parsed once.
+ * The iris::Configuration parameters are private and only filled by its JSON parse, so parsed configurations are not
+ * cached on disk: the analysers of the process share the configuration parsed from the same appsettings.json content
+ * instead (LoadShared).
+ */
+class IRISEA_API ConfigurationSnapshot
+{
+public:
+
+	/// <summary>
+	//Reads the appsettings.json of configurationDir, parses it into configuration and stores the snapshot with the hash of
+	//the content read. False if the file can not be read (hash 0)
+	/// </summary>
+	bool Load(iris::Configuration& configuration, const FString& configurationDir);
+
+	/// <summary>
+	//Configuration parsed from the appsettings.json of configurationDir, shared by the analysers of the process: the file
+	//is read and hashed, and only parsed if no configuration was parsed from the same directory and content before. Null
+	//if the file can not be read
+	/// </summary>
+	static TSharedPtr<FIrisSharedConfiguration, ESPMode::ThreadSafe> LoadShared(const FString& configurationDir);
+
+	/// <summary>
+	//Copies the values of a parsed configuration, contentHash identifies the appsettings.json content it was parsed from
+	/// </summary>
+	void Store(iris::Configuration& configuration, uint64 contentHash);
+
+	bool IsLoaded() const { return bLoaded; }
+
+	/// <summary>
+	//Snapshot, valid once stored
+	/// </summary>
+	const FIrisConfigurationSnapshot& GetSnapshot() const { check(bLoaded); return snapshot; }
+
+	iris::FlashParams GetLuminanceFlashParams() const;
+	iris::FlashParams GetRedSaturationFlashParams() const;
+	iris::TransitionTrackerParams GetTransitionTrackerParams() const;
+
+	void Reset();
+
+private:
+
+	FIrisConfigurationSnapshot snapshot;
+	bool bLoaded = false;
+};
+
+/**
+ * Parsed configuration of the VideoAnalysers and its snapshot, shared by the analysers of the process that load the
+ * same appsettings.json. The IRIS library is analysed by one analyser at a time (FIrisAnalysisContext::BeginSession),
+ * so the session settings an analyser writes to the configuration are not seen by another one mid-session
+ */
+struct IRISEA_API FIrisSharedConfiguration
+{
+	FIrisSharedConfiguration();
+	~FIrisSharedConfiguration();
+
+	TUniquePtr<iris::Configuration> configuration;
+	ConfigurationSnapshot snapshot;
+};
@@ -0,0 +1,114 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <FrameStruct.h>
+
+struct FIrisConfigurationSnapshot;
+
+/**
+ * IRIS flash and transition rules applied by the plugin where the VideoAnalyser is not run (screen regions of the
+ * RegionTransitionTracker, split screen views), from the frame values of a FrameTileGrid:
+ *  - a channel makes a transition when its accumulated average variation reaches the flash threshold in a new
+ *    direction and the darker of the two frames is under the dark threshold
+ *  - the transitions are counted over the last second (TransitionWindow), the frame fails over the max transitions
+ *    and warns from the warning transitions
+ *  - extended fail when the frames at or over the min transitions span extendedFailSeconds of the extended fail
+ *    window (ExtendedFailWindow)
+ * The windows drop their oldest frames while the new frame is a full window after them, like the IRIS FrameManager.
+ * SplitScreenAnalysis::ValidateOnVideo compares the verdicts with the VideoAnalyser on recorded clips.
+ */
+struct FFlashTransitionParams
+{
+	uint32 maxTransitions = 6;
+	uint32 minTransitions = 4;
+	uint32 warningTransitions = 4;
+	uint32 extendedFailMs = 4000;
+	uint32 extendedFailWindowMs = 5000;
+
+	void Initialize(const FIrisConfigurationSnapshot& settings);
+};
+
+class IRISEA_API FlashTransitionRules
+{
+public:
+
+	/// <summary>
+	//Accumulates the average variation of a channel and returns true if it makes a new transition
+	/// </summary>
+	static bool CheckTransition(float avgDiff, float mean, float& lastMean, float& avgDiffAcc, float threshold, float darkThreshold)
+	{
+		const float lastAcc = avgDiffAcc;
+		const bool bSameSign = (avgDiff <= 0.f && lastAcc <= 0.f) || (avgDiff >= 0.f && lastAcc >= 0.f);
+		const float acc = bSameSign ? lastAcc + avgDiff : avgDiff;
+
+		//New transition if the accumulated variation reaches the threshold in a new direction, and the darker frame is dark enough
+		const bool bOverThreshold = FMath::Abs(acc) >= threshold;
+		const bool bNewDirection = !bSameSign || FMath::Abs(lastAcc) < threshold;
+		const bool bDark = FMath::Min(mean, lastMean) < darkThreshold;
+
+		avgDiffAcc = acc;
+		lastMean = mean;
+		return bOverThreshold && bNewDirection && bDark;
+	}
+
+	/// <summary>
+	//Flash result of a frame from the transitions of the last second and the time spent over the min transitions in
+	//the extended fail window
+	/// </summary>
+	static iris::FlashResult GetFlashResult(uint32 transitions, uint32 overMinMs, const FFlashTransitionParams& params);
+};
+
+/**
+ * Transitions of the last second of several channels, the new transitions of each frame are kept as one row so the
+ * window update is a vector add/subtract
+ */
+class IRISEA_API TransitionWindow
+{
+public:
+
+	explicit TransitionWindow(int32 channels = 1);
+
+	/// <summary>
+	//Adds the new transitions of a frame (a value per channel) and drops the frames out of the one second window
+	/// </summary>
+	void Push(unsigned long timeStampMs, const uint8* newTransitions);
+
+	//Transitions of each channel in the last second
+	const uint8* GetTransitions() const { return transitions.GetData(); }
+
+	void Reset();
+
+private:
+	int32 channelCount;
+	TArray<uint8> history; //a row of channelCount values per frame (oldest first)
+	TArray<unsigned long> timeStamps;
+	TArray<uint8> transitions;
+};
+
+/**
+ * Time the transitions of a channel spent at or over the min transitions during the extended fail window, a frame
+ * counts from the previous frame
+ */
+class IRISEA_API ExtendedFailWindow
+{
+public:
+
+	void Initialize(uint32 windowMs);
+
+	/// <summary>
+	//Adds a frame and returns the time spent over the min transitions in the window
+	/// </summary>
+	uint32 AddFrame(unsigned long timeStampMs, bool bOverMinTransitions);
+
+	void Reset();
+
+private:
+	uint32 extendedFailWindowMs = 5000;
+	TArray<unsigned long> timeStamps;
+	TArray<uint32> frameOverMinMs;
+	uint32 overMinMs = 0;
+	bool bHasLastFrame = false;
+	unsigned long lastTimeStamp = 0;
+};
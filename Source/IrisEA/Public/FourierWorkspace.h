@@ -0,0 +1,55 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <FrameStruct.h>
+
+/**
+ * Reusable power spectrum computation for the pattern detection of a fixed frame size.
+ * Every buffer is allocated once at cv::getOptimalDFTSize dimensions and the per-size plan (fftshift
+ * index tables and frequency band mask) is built on Initialize: a frame then costs one real-input
+ * forward DFT into the same spectrum buffer and a single pass that writes the centered power spectrum
+ * through the index tables, without quadrant copies or temporary Mats.
+ */
+class IRISEA_API FourierWorkspace
+{
+public:
+
+	/// <summary>
+	//Allocates the buffers and builds the plan for luminance frames of the given size (cols x rows).
+	//Frequencies under minFrequency cycles per frame (in both axes) are left out of the band
+	/// </summary>
+	void Initialize(const cv::Size& frameSize, int32 minFrequency);
+
+	/// <summary>
+	//Computes the centered power spectrum of the luminance frame (CV_32F, or CV_16U divided by scale)
+	/// </summary>
+	void ComputePowerSpectrum(const cv::Mat& luminance, double scale = 1.0);
+
+	/// <summary>
+	//Ratio between the strongest frequency of the band and the mean band power of the last spectrum,
+	//periodic patterns concentrate their energy in a few peaks
+	/// </summary>
+	float GetPeakRatio() const;
+
+	const cv::Mat& GetPowerSpectrum() const { return power; }
+	const cv::Size& GetFrameSize() const { return frameSize; }
+	bool IsInitialized() const { return !power.empty(); }
+
+	void Reset();
+
+private:
+
+	cv::Size frameSize;
+	cv::Size dftSize; //optimal DFT size, frameSize padded with zeros
+
+	cv::Mat padded; //CV_32F input, only the frameSize region is written
+	cv::Mat spectrum; //CV_32FC2 output of the forward DFT
+	cv::Mat power; //CV_32F centered power spectrum
+	cv::Mat bandMask; //CV_8U, frequencies checked for peaks
+
+	//Plan, centered spectrum position -> DFT output position
+	TArray<int32> shiftRows;
+	TArray<int32> shiftCols;
+};
@@ -14,7 +14,10 @@ public:
 
     void Tick(float DeltaTime);
     
-    void Initialize();
+    /// <summary>
+    //Prepares the capture of a session, a resumed session continues from the given frame number and time stamp
+    /// </summary>
+    void Initialize(int firstFrame = 0, float sessionTimeMs = 0.f);
 
     /// <summary>
     //Destroy the OpenCV debug window (if there's any), if a video of the session has been recorded it must be released
@@ -23,9 +26,15 @@ public:
 
 private:
     /// <summary>
-    //Function that captures the Unreal Engine frame texture and saves it into MatDest 
+    //Function that captures the Unreal Engine frame texture into the frame, as a BGRA (linear half float RGBA for the HDR
+    //capture) view of the mapped readback buffer
+    /// </summary>
+    void CaptureFrame(FIrisFrame& frame);
+
+    /// <summary>
+    //Normalized rects of the local player views, empty when the viewport is not split
     /// </summary>
-    void CaptureFrame(cv::Mat& MatDest);
+    void GetSplitScreenViews(TArray<FBox2f, TInlineAllocator<4>>& outViews) const;
 
     /// <summary>
     // Function called when the Unreal Engine Viewport has been resized, the Iris session must end
@@ -38,8 +47,14 @@ private:
 
     TSharedPtr<PixelCaptureCapturerRHIToBGRMat> pixelCapturer;
 
+    FIntPoint capturerViewportSize{ 0, 0 }; //viewport size of the current capturer
+
+    EPixelFormat captureFormat = PF_B8G8R8A8; //PF_FloatRGBA for the HDR capture
+
     int frameCounter;
 
+    int firstFrameNumber = 0; //number of the first analysed frame of the session
+
     float resizeProportion;
 
     float currentSessionTime{ 0.f };
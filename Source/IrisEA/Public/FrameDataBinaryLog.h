@@ -0,0 +1,196 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <FrameStruct.h>
+
+class IFileHandle;
+
+/**
+ * Compact copy of the FrameData of a frame, without strings, so it can be queued and stored without allocations.
+ * The area percentages are kept as hundredths and the time stamp string is rebuilt from the time stamp value.
+ */
+struct FIrisFrameRecord
+{
+	uint32 frame = 0;
+	uint32 timeStampMs = 0;
+	float luminanceAverage = 0.f;
+	float averageLuminanceDiff = 0.f;
+	float averageLuminanceDiffAcc = 0.f;
+	float redAverage = 0.f;
+	float averageRedDiff = 0.f;
+	float averageRedDiffAcc = 0.f;
+	uint32 luminanceTransitions = 0;
+	uint32 redTransitions = 0;
+	uint32 luminanceExtendedFailCount = 0;
+	uint32 redExtendedFailCount = 0;
+	int32 patternDetectedLines = 0;
+	uint16 luminanceFlashArea = 0; //hundredths of a percentage
+	uint16 redFlashArea = 0;
+	uint16 patternArea = 0;
+	uint8 luminanceFrameResult = 0;
+	uint8 redFrameResult = 0;
+	uint8 patternFrameResult = 0;
+
+	bool operator==(const FIrisFrameRecord& other) const
+	{
+		return frame == other.frame && timeStampMs == other.timeStampMs
+			&& luminanceAverage == other.luminanceAverage && averageLuminanceDiff == other.averageLuminanceDiff && averageLuminanceDiffAcc == other.averageLuminanceDiffAcc
+			&& redAverage == other.redAverage && averageRedDiff == other.averageRedDiff && averageRedDiffAcc == other.averageRedDiffAcc
+			&& luminanceTransitions == other.luminanceTransitions && redTransitions == other.redTransitions
+			&& luminanceExtendedFailCount == other.luminanceExtendedFailCount && redExtendedFailCount == other.redExtendedFailCount
+			&& patternDetectedLines == other.patternDetectedLines
+			&& luminanceFlashArea == other.luminanceFlashArea && redFlashArea == other.redFlashArea && patternArea == other.patternArea
+			&& luminanceFrameResult == other.luminanceFrameResult && redFrameResult == other.redFrameResult && patternFrameResult == other.patternFrameResult;
+	}
+};
+
+/**
+ * Binary columnar log of the session FrameData (.irislog), for sessions too long to keep as CSV.
+ *
+ * Layout: header { "IRIS", version, frames per block } followed by the blocks and the time index.
+ * A block holds up to BlockFrames frames as { "IRIB", byte size of the rest of the block, frame count, then for each
+ * column: byte size + encoded values }.
+ * Every column is encoded on its own, starting from zero on each block so blocks decode independently:
+ *  - Delta: zigzag varint of the difference with the previous value (frame index, time stamp, flash areas)
+ *  - Xor: varint of the float bits xor the previous ones (averages and variations, repeated values take 1 byte)
+ *  - RunLength: varint value + varint run length (transitions, fail counts, results, pattern values)
+ * The time index { first time stamp, last time stamp, offset, frames } of every block is written after the last
+ * block, followed by its offset, the block count and "IRIX"; a reader seeks a time stamp with a binary search on it.
+ * A log without time index (session that did not close) is recovered by a forward scan of its blocks, up to the last
+ * complete one.
+ * The text values (time stamp string and area percentages) are rebuilt from the time stamp and the area hundredths
+ * so the CSV and JSON converted back from a log are identical to the ones written during the session.
+ */
+class IRISEA_API FrameDataBinaryLog
+{
+public:
+	static constexpr uint32 Version = 2;
+	static constexpr int32 BlockFrames = 4096;
+	static constexpr int32 ColumnCount = 19;
+
+	enum class EColumnEncoding : uint8 { Delta, Xor, RunLength };
+
+	struct FBlockIndex
+	{
+		uint64 firstTimeStampMs = 0;
+		uint64 lastTimeStampMs = 0;
+		int64 offset = 0;
+		int32 frames = 0;
+	};
+
+	/// <summary>
+	//Record of the frame data, the area strings are parsed once here
+	/// </summary>
+	static void ToRecord(const iris::FrameData& frameData, FIrisFrameRecord& record);
+	static void FromRecord(const FIrisFrameRecord& record, iris::FrameData& frameData);
+
+	/// <summary>
+	//Column values of a frame, areas as hundredths of a percentage and floats as their bits
+	/// </summary>
+	static void ToColumnValues(const FIrisFrameRecord& record, uint64* values);
+	static void FromColumnValues(const uint64* values, iris::FrameData& frameData);
+
+	static EColumnEncoding GetColumnEncoding(int32 column);
+};
+
+/**
+ * Writes FrameData to a binary columnar log
+ */
+class IRISEA_API FrameDataLogWriter
+{
+public:
+	~FrameDataLogWriter();
+
+	bool Open(const FString& path);
+
+	/// <summary>
+	//Adds the frame to the current block, the block is encoded and written once full
+	/// </summary>
+	void Append(const FIrisFrameRecord& record);
+
+	/// <summary>
+	//Writes the last block and the time index, logs the size and write throughput
+	/// </summary>
+	void Close();
+
+	bool IsOpen() const { return file.IsValid(); }
+
+private:
+
+	void WriteBlock();
+
+	/// <summary>
+	//Writes to the log, the log is closed on the first failed write
+	/// </summary>
+	bool Write(const uint8* data, int64 size);
+
+	TUniquePtr<IFileHandle> file;
+	FString filePath;
+
+	//Current block, one array of values per column
+	TArray<uint64> blockValues[FrameDataBinaryLog::ColumnCount];
+	int32 blockFrames = 0;
+	TArray<uint8> encoded; //reused encoding buffer
+	TArray<FrameDataBinaryLog::FBlockIndex> index;
+
+	//Session measurements
+	int64 frames = 0;
+	int64 bytes = 0;
+	double writeSeconds = 0.0;
+};
+
+/**
+ * Reads the blocks of a binary columnar log
+ */
+class IRISEA_API FrameDataLogReader
+{
+public:
+	~FrameDataLogReader();
+
+	/// <summary>
+	//Opens the log and loads its time index
+	/// </summary>
+	bool Open(const FString& path);
+
+	void Close();
+
+	int32 GetBlockCount() const { return index.Num(); }
+	const TArray<FrameDataBinaryLog::FBlockIndex>& GetIndex() const { return index; }
+	int64 GetFileSize() const { return fileSize; }
+
+	/// <summary>
+	//Returns the block holding the given time stamp (or the first one after it), INDEX_NONE if it is after the log end. O(log n)
+	/// </summary>
+	int32 FindBlock(uint64 timeStampMs) const;
+
+	/// <summary>
+	//Decodes the frames of a block, appended to outFrames
+	/// </summary>
+	bool ReadBlock(int32 block, TArray<iris::FrameData>& outFrames);
+
+private:
+
+	/// <summary>
+	//Reads the time index written when the log was closed
+	/// </summary>
+	bool ReadIndex();
+
+	/// <summary>
+	//Rebuilds the time index from the blocks, returns false if the log has no complete block
+	/// </summary>
+	bool RecoverIndex();
+
+	/// <summary>
+	//Reads and decodes the block at the offset into blockValues, the block and the frame counts are set on success
+	/// </summary>
+	bool DecodeBlock(int64 offset, int64 maxSize, int64& outBlockSize, int32& outFrames);
+
+	TUniquePtr<IFileHandle> file;
+	int64 fileSize = 0;
+	int64 indexEnd = 0; //offset of the time index, end of the last block
+	TArray<FrameDataBinaryLog::FBlockIndex> index;
+	TArray<uint8> encoded; //reused block buffer
+	TArray<uint64> blockValues[FrameDataBinaryLog::ColumnCount];
+};
@@ -8,9 +8,32 @@
 #include "opencv2/opencv.hpp"
 #define check(expr)				UE_CHECK_IMPL(expr)
 
+struct FIrisReadbackSlot;
+
+enum class EIrisToneMapping : uint8
+{
+	Clamp, //linear values over 1 are clipped
+	Reinhard //extended Reinhard, whitePoint maps to 1
+};
+
+/**
+ * Display transform of the linear half float (HDR) frames: the values are scaled by the exposure and tone mapped to
+ * the [0, 1] display range the IRIS flash thresholds are defined on
+ */
+struct FIrisDisplayTransform
+{
+	float exposure = 1.f;
+	EIrisToneMapping toneMapping = EIrisToneMapping::Clamp;
+	float whitePoint = 4.f;
+};
+
 struct FIrisFrame
 {
-	cv::Mat frameMatrix;
+	cv::Mat frameMatrix; //BGRA or linear half float RGBA (HDR capture), a view of the mapped readback buffer held by readbackSlot (owned copy when null)
+	TSharedPtr<FIrisReadbackSlot, ESPMode::ThreadSafe> readbackSlot;
 	iris::FrameData frameData;
+	TArray<uint64> tileSignatures; //Content checksum of each FrameTileGrid tile, computed by the analysis when empty
+	uint64 frameSignature = 0; //Hash of the tile checksums, used to detect static frames
+	TArray<FBox2f, TInlineAllocator<4>> views; //Normalized rect of each local player view when the split screen analysis is active
 
 };
\ No newline at end of file
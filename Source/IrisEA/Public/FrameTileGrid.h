@@ -0,0 +1,241 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <FrameStruct.h>
+#include <vector>
+
+struct FIrisConfigurationSnapshot;
+
+//Stores the luminance and red saturation planes as 16 bit fixed point values instead of floats (half the memory bandwidth
+//of the plugin stages, the IRIS library converts its frames to float planes of its own)
+#define IRIS_FIXED_POINT_PLANES 1
+
+/**
+ * Luminance flash value of the configuration (appsettings LuminanceType)
+ */
+enum class EIrisLuminanceModel : uint8
+{
+	Relative, //relative luminance in [0, 1] of the sRGB linearized pixels
+	CD //cd/m2 of the 8 bit gray pixels (BT.601 as cv::COLOR_BGR2GRAY) from the CdLuminanceValues table
+};
+
+/**
+ * Per-tile cached values of the last analysed frame
+ */
+struct FTileStats
+{
+	double luminanceSum = 0.0;
+	double redSum = 0.0;
+	double luminanceDiffSum = 0.0; //sum of frame(n) - frame(n-1) luminance values
+	double redDiffSum = 0.0; //sum of frame(n) - frame(n-1) red saturation values
+	int32 luminanceOverThreshold = 0; //pixels whose luminance variation reaches the flash threshold
+	int32 redOverThreshold = 0; //pixels whose red saturation variation reaches the flash threshold
+	int32 pixels = 0;
+	bool bDirty = false; //tile content changed in the last frame
+};
+
+/**
+ * Frame level values assembled from the tile aggregates
+ */
+struct FFrameTileStats
+{
+	float luminanceAverage = 0.f;
+	float redAverage = 0.f;
+	float averageLuminanceDiff = 0.f;
+	float averageRedDiff = 0.f;
+	float luminanceFlashArea = 0.f; //proportion of the frame over the luminance flash threshold
+	float redFlashArea = 0.f; //proportion of the frame over the red saturation flash threshold
+	int32 dirtyTiles = 0;
+};
+
+/**
+ * Tiles of a frame converted ahead of its Update, in whole frame planes where only the converted tiles are written
+ */
+struct FConvertedTiles
+{
+	cv::Mat luminance;
+	cv::Mat red;
+	TBitArray<> tiles; //converted tiles, row-major tile order
+};
+
+/**
+ * Incremental conversion of the captured frames into relative luminance and red saturation planes.
+ * The frame is split in a grid of tiles, each one with a content checksum computed by the analysis; only the tiles
+ * whose checksum changed are converted again, the rest keep their cached sums and have no variation.
+ * With IRIS_FIXED_POINT_PLANES the planes hold value * scale rounded to uint16: the error of a stored value is at most
+ * 0.5 / scale, so a variation can only be classified differently against a flash threshold when it is within
+ * 1 / scale of it (1.5e-5 for the 0.1 relative luminance threshold, 4e-3 for the 20 cd/m2 threshold, 5e-3 for the red
+ * saturation threshold of 20).
+ * The conversion is specialised at compile time for each luminance model and input format (BGR, BGRA, linear half float
+ * RGBA) so the per-pixel math is inlined in the row loop; the model is picked once per session.
+ * The IRIS VideoAnalyser converts the frames it analyses on its own, the planes and tile sums only feed the plugin stages
+ * (region tracking, pattern detection, split screen views): the analysis only updates the grid while one of them reads it.
+ */
+class IRISEA_API FrameTileGrid
+{
+public:
+	static constexpr int32 TilesX = 8;
+	static constexpr int32 TilesY = 8;
+	static constexpr int32 TileCount = TilesX * TilesY;
+
+#if IRIS_FIXED_POINT_PLANES
+	using PlaneValue = uint16;
+	static constexpr int32 PlaneType = CV_16U;
+	static constexpr float LuminanceScale = 65535.f; //relative luminance in [0, 1]
+	static constexpr float CdLuminanceScale = 256.f; //cd/m2 in [0, 256)
+	static constexpr float RedScale = 200.f; //red saturation in [0, 320]
+#else
+	using PlaneValue = float;
+	static constexpr int32 PlaneType = CV_32F;
+	static constexpr float LuminanceScale = 1.f;
+	static constexpr float CdLuminanceScale = 1.f;
+	static constexpr float RedScale = 1.f;
+#endif
+
+	/// <summary>
+	//Plane value of a luminance or red saturation flash value
+	/// </summary>
+	static FORCEINLINE PlaneValue EncodePlaneValue(float value, float scale)
+	{
+#if IRIS_FIXED_POINT_PLANES
+		return static_cast<uint16>(FMath::Min(value * scale, 65535.f) + 0.5f);
+#else
+		return value;
+#endif
+	}
+
+	/// <summary>
+	//Computes the content checksum of every tile of the frame (row-major tile order)
+	/// </summary>
+	static void ComputeTileSignatures(const cv::Mat& frame, TArray<uint64>& outSignatures);
+
+	/// <summary>
+	//Returns the rect of the tile in a frame of the given size
+	/// </summary>
+	static cv::Rect GetTileRect(const cv::Size& frameSize, int32 tile);
+
+	/// <summary>
+	//Sets the luminance model, look up tables and flash thresholds, called when a session starts
+	/// </summary>
+	void Initialize(const FIrisConfigurationSnapshot& settings);
+
+	/// <summary>
+	//Sets the display transform of the linear half float frames
+	/// </summary>
+	void SetDisplayTransform(const FIrisDisplayTransform& transform) { displayTransform = transform; }
+
+	/// <summary>
+	//Converts the dirty tiles of the new frame (BGR, BGRA or linear half float RGBA, any stride) and assembles the frame level values.
+	//The dirty tiles converted ahead (ConvertTiles of the same frame) are read from the given planes
+	/// </summary>
+	void Update(const cv::Mat& bgrFrame, const TArray<uint64>& tileSignatures, const FConvertedTiles* convertedTiles = nullptr);
+
+	/// <summary>
+	//Converts the tiles of a frame whose checksum differs from the reference frame (every tile without reference) for
+	//Update, the grid is not modified so several frames can be converted in parallel
+	/// </summary>
+	void ConvertTiles(const cv::Mat& frame, const TArray<uint64>& tileSignatures, const TArray<uint64>* referenceSignatures, FConvertedTiles& outTiles) const;
+
+	/// <summary>
+	//Tile checksums of the last frame, null when the next frame is converted whole
+	/// </summary>
+	const TArray<uint64>* GetLastSignatures() const { return bHasFrame ? &lastSignatures : nullptr; }
+
+	/// <summary>
+	//Forgets the last frame when frames are not given to the grid, the next one is converted whole with no variation
+	/// </summary>
+	void Invalidate() { bHasFrame = false; }
+
+	/// <summary>
+	//Ends the session (the next frame is converted whole) and logs the session measurements, the planes are kept allocated
+	/// </summary>
+	void Reset();
+
+	const FFrameTileStats& GetFrameStats() const { return frameStats; }
+	const TArray<FTileStats>& GetTileStats() const { return tileStats; }
+
+	/// <summary>
+	//Planes of the last frame (PlaneType), divide by GetLuminanceScale / RedScale to get the flash values
+	/// </summary>
+	const cv::Mat& GetLuminancePlane() const { return luminancePlane; }
+	const cv::Mat& GetRedPlane() const { return redPlane; }
+
+	EIrisLuminanceModel GetLuminanceModel() const { return luminanceModel; }
+	float GetLuminanceScale() const { return luminanceModel == EIrisLuminanceModel::CD ? CdLuminanceScale : LuminanceScale; }
+
+	/// <summary>
+	//Relative luminance plane of a frame (LuminanceScale) whatever the session model, used by the pattern detection
+	/// </summary>
+	void ConvertRelativeLuminance(const cv::Mat& frame, cv::Mat& outLuminance);
+
+	/// <summary>
+	//Logs the conversion time of each specialisation against the conversion before the specialisation (ConvertRows templated
+	//on the channel count, relative luminance only), on synthetic frames of the given size, and the grid update time as a proportion of the IRIS per-frame analysis time (baselineFrameMs) when it is measured
+	/// </summary>
+	static void BenchmarkConversion(const FIrisConfigurationSnapshot& settings, const FIrisDisplayTransform& transform, const cv::Size& frameSize, int32 iterations, double baselineFrameMs = 0.0);
+
+private:
+
+	/// <summary>
+	//Converts a tile of the frame, updating its planes, sums and variation with the previous frame
+	/// </summary>
+	void UpdateTile(const cv::Mat& bgrFrame, int32 tile, const FConvertedTiles* convertedTiles);
+
+	void AssembleFrameStats();
+
+	/// <summary>
+	//Converts a region of the frame into luminance and red saturation plane values
+	/// </summary>
+	void ConvertRegion(const cv::Mat& bgrRegion, cv::Mat& luminance, cv::Mat& red) const;
+
+	enum class EInputFormat : uint8 { BGR8, BGRA8, RGBA16F, Count };
+
+	static EInputFormat GetInputFormat(const cv::Mat& frame);
+
+	template<EIrisLuminanceModel Model, EInputFormat Input>
+	static void ConvertRegionTyped(const FrameTileGrid& grid, const cv::Mat& region, cv::Mat& luminance, cv::Mat& red);
+
+	using ConvertRegionFunction = void(*)(const FrameTileGrid&, const cv::Mat&, cv::Mat&, cv::Mat&);
+	static const ConvertRegionFunction RelativeConversions[static_cast<int32>(EInputFormat::Count)];
+	static const ConvertRegionFunction CdConversions[static_cast<int32>(EInputFormat::Count)];
+
+	/// <summary>
+	//Non-shipping builds only. Converts the whole frame and checks the assembled values match the tile aggregates
+	/// </summary>
+	void ValidateAgainstFullFrame(const cv::Mat& bgrFrame);
+
+	float sRgbTable[256] = {};
+	float cdLuminanceTable[256] = {};
+	FIrisDisplayTransform displayTransform;
+	EIrisLuminanceModel luminanceModel = EIrisLuminanceModel::Relative;
+	const ConvertRegionFunction* conversions = RelativeConversions; //conversions of the session luminance model
+
+	//Red plane of the relative luminance conversion, not used
+	cv::Mat relativeRedScratch;
+	float luminanceThreshold = 0.f;
+	float redThreshold = 0.f;
+
+	bool bHasFrame = false; //false until the first frame of the session, the planes are kept between sessions
+	cv::Mat luminancePlane; //luminance of the last frame, in the session model
+	cv::Mat redPlane; //red saturation of the last frame
+
+	//Tile sized buffers reused by the dirty tiles conversion
+	cv::Mat tileLuminance;
+	cv::Mat tileRed;
+	cv::Mat tileDiff;
+	cv::Mat tileMask;
+
+	TArray<uint64> lastSignatures;
+	TArray<FTileStats> tileStats;
+	FFrameTileStats frameStats;
+
+	//Session measurements
+	const int32 validationInterval{ 300 };
+	int32 updates = 0;
+	int64 dirtyTilesTotal = 0;
+	double incrementalSeconds = 0.0;
+	double fullFrameSeconds = 0.0;
+	int32 fullFrameRuns = 0;
+};
@@ -0,0 +1,60 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Float16.h"
+#include "FrameTileGrid.h"
+
+/**
+ * Conversion of linear half float RGBA pixels (PF_FloatRGBA captures) straight into relative luminance and red
+ * saturation plane values: the values are already linear so there is no sRGB decode, only the display transform.
+ * The CD luminance model is defined on 8 bit gray values, its rows go through EncodeRowBGR first.
+ * The kernels take plain row pointers so they can be checked on synthetic rows; ConvertRow and EncodeRowBGR use the
+ * F16C/AVX2 kernel when the CPU supports it and the scalar one otherwise, both give the same values up to float
+ * rounding (Iris.HalfFloatConversion.SimdMatchesScalar).
+ * The IRIS library only takes 8 bit BGR frames, EncodeFrameBGR gives it the display transformed, sRGB encoded frame.
+ */
+class IRISEA_API HalfFloatConversion
+{
+public:
+
+	/// <summary>
+	//Converts a row of RGBA half floats into luminance and red saturation plane values
+	/// </summary>
+	static void ConvertRow(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform,
+		FrameTileGrid::PlaneValue* luminance, FrameTileGrid::PlaneValue* red);
+
+	static void ConvertRowScalar(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform,
+		FrameTileGrid::PlaneValue* luminance, FrameTileGrid::PlaneValue* red);
+
+	/// <summary>
+	//F16C/AVX2 kernel, only valid when HasSimdSupport returns true
+	/// </summary>
+	static void ConvertRowSimd(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform,
+		FrameTileGrid::PlaneValue* luminance, FrameTileGrid::PlaneValue* red);
+
+	static bool HasSimdSupport();
+
+	/// <summary>
+	//Display transform of a linear value, in [0, 1]
+	/// </summary>
+	static float ApplyDisplayTransform(float value, const FIrisDisplayTransform& transform);
+
+	/// <summary>
+	//Converts a row of RGBA half floats into 8 bit sRGB BGR pixels
+	/// </summary>
+	static void EncodeRowBGR(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform, uint8* bgr);
+
+	static void EncodeRowBGRScalar(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform, uint8* bgr);
+
+	/// <summary>
+	//F16C/AVX2 kernel, only valid when HasSimdSupport returns true
+	/// </summary>
+	static void EncodeRowBGRSimd(const FFloat16* rgba, int32 pixels, const FIrisDisplayTransform& transform, uint8* bgr);
+
+	/// <summary>
+	//Converts a linear half float RGBA frame (any stride) into an 8 bit sRGB BGR frame
+	/// </summary>
+	static void EncodeFrameBGR(const cv::Mat& rgbaHalf, const FIrisDisplayTransform& transform, cv::Mat& outBgr);
+};
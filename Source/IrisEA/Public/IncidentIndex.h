@@ -0,0 +1,100 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include <FrameStruct.h>
+
+class RegionTransitionTracker;
+
+/**
+ * Failing result category of an incident
+ */
+enum class EIncidentCategory : uint8
+{
+	LuminanceFlashFail,
+	LuminanceExtendedFail,
+	RedFlashFail,
+	RedExtendedFail,
+	PatternFail,
+	Count
+};
+
+/**
+ * Consecutive frames with the same failing result
+ */
+struct FIrisIncident
+{
+	EIncidentCategory category = EIncidentCategory::LuminanceFlashFail;
+	uint32 startFrame = 0;
+	uint32 endFrame = 0;
+	uint32 startTimeStampMs = 0;
+	uint32 endTimeStampMs = 0; //last failing frame
+	uint32 peakTransitions = 0; //detected lines for patterns
+	TArray<int32> regions; //failing regions seen during the incident (region tracking only)
+};
+
+/**
+ * Session index of the incidents: the consecutive failing frames of each category are merged in one interval,
+ * logged when it starts and when it ends instead of on every frame.
+ * The incidents of a category never overlap and are stored in time order, so a time range query is two binary
+ * searches per category (O(log n) plus the incidents returned).
+ */
+class IRISEA_API IncidentIndex
+{
+public:
+
+	/// <summary>
+	//Opens, extends or closes the incidents with the results of the analysed frame. The failing regions are added
+	//to the open incidents when the tracker is given
+	/// </summary>
+	void Update(const iris::FrameData& frameData, const RegionTransitionTracker* regionTracker);
+
+	/// <summary>
+	//Returns the incidents of the category (or of all of them with Count) overlapping [fromMs, toMs], safe to call from any thread
+	/// </summary>
+	void GetIncidents(uint32 fromMs, uint32 toMs, TArray<FIrisIncident>& outIncidents, EIncidentCategory category = EIncidentCategory::Count) const;
+
+	/// <summary>
+	//Closes the open incidents, logs the session summary and writes it to reportPath (Incidents.json) if not empty.
+	//The incidents are kept until the next session
+	/// </summary>
+	void EndSession(const FString& reportPath);
+
+	/// <summary>
+	//Adds a closed incident of a later time range (video shards), merged with the last incident of its category when
+	//it starts on the frame after its end
+	/// </summary>
+	void AppendIncident(const FIrisIncident& incident);
+
+	/// <summary>
+	//Clears the incidents, called when a session starts
+	/// </summary>
+	void Reset();
+
+	/// <summary>
+	//Saves or restores the incidents and the open ones (analysis checkpoints)
+	/// </summary>
+	void Serialize(FArchive& ar);
+
+	/// <summary>
+	//Sets the name the incidents are logged with (e.g. the player of a split screen view), empty for the whole screen
+	/// </summary>
+	void SetLabel(const FString& newLabel) { label = newLabel.IsEmpty() ? FString() : newLabel + TEXT(" "); }
+
+	static const TCHAR* GetCategoryName(EIncidentCategory category);
+
+private:
+
+	void CloseIncident(int32 category);
+
+	static constexpr int32 CategoryCount = static_cast<int32>(EIncidentCategory::Count);
+
+	TArray<FIrisIncident> incidents; //in start order
+	TArray<int32> categoryIncidents[CategoryCount]; //incidents of each category, in time order
+	int32 openIncidents[CategoryCount] = { INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE, INDEX_NONE };
+	TArray<int32> failingRegions; //reused regions buffer
+	FString label; //log prefix
+	mutable FCriticalSection incidentsSection;
+};
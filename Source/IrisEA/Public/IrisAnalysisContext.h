@@ -0,0 +1,114 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "RegionTransitionTracker.h"
+#include "PatternDetectionStage.h"
+#include "IncidentIndex.h"
+#include "SplitScreenAnalysis.h"
+#include <FrameStruct.h>
+
+namespace iris
+{
+	class Configuration;
+	class VideoAnalyser;
+}
+class ConfigurationSnapshot;
+class TieredAnalysis;
+class DataChart;
+class SessionResultsWriter;
+class VideoRecorder;
+class AnalysisCheckpoint;
+
+/**
+ * State of one analyser: the IRIS VideoAnalyser, the plugin analysis stages fed by it and the session outputs
+ * it writes to. The analysis of a frame stream (AsyncAnalysis) reaches all of its state through its context
+ * instead of the module; the session outputs are optional for headless analysers.
+ * The time windows (FrameManager), profiler and flash fps kept as statics inside the prebuilt IRIS library are
+ * shared by every VideoAnalyser of the process and reset by their DeInit, so only one context of the process
+ * analyses at a time: a session holds the library from BeginSession to EndSession, the other contexts wait for it or
+ * fail to begin. Streams are analysed concurrently by separate processes (ShardedVideoAnalysis.h).
+ */
+struct IRISEA_API FIrisAnalysisContext
+{
+	FIrisAnalysisContext() {};
+	~FIrisAnalysisContext();
+
+	/// <summary>
+	//Creates the VideoAnalyser and the tiered analysis for the configuration (not owned)
+	/// </summary>
+	void Initialize(iris::Configuration* analyserConfiguration, const ConfigurationSnapshot* settings);
+
+	/// <summary>
+	//Initializes the analysers for a session on frames of the given size ({rows, cols}), the low tier size is only
+	//used by the tiered analysis. The IRIS library is initialized for the video of videoPath when it is set. Waits up to libraryWaitSeconds (without limit if negative) for the context holding
+	//the IRIS library, false if it is still held
+	/// </summary>
+	bool BeginSession(const cv::Size& frameSize, const cv::Size& lowTierFrameSize, const char* configurationPath, float libraryWaitSeconds = 0.f);
+
+	/// <summary>
+	//Releases the session analysers and the IRIS library, writes the incidents report and closes the session outputs,
+	//called from the analysis thread
+	/// </summary>
+	void EndSession();
+
+	/// <summary>
+	//Deletes the analysers
+	/// </summary>
+	void Release();
+
+	/// <summary>
+	//Takes the IRIS library statics for this context until ReleaseLibrary, waiting up to waitSeconds (without limit if
+	//negative) for the context holding them. False if they are still held by another context
+	/// </summary>
+	bool AcquireLibrary(float waitSeconds);
+
+	void ReleaseLibrary();
+
+	bool HoldsLibrary() const;
+
+	bool IsInitialized() const { return videoAnalyser != nullptr; }
+
+	iris::Configuration* configuration = nullptr;
+	const ConfigurationSnapshot* configurationSnapshot = nullptr;
+	iris::VideoAnalyser* videoAnalyser = nullptr;
+	TieredAnalysis* tieredAnalysis = nullptr;
+
+	//Locates the flashing regions of the screen
+	RegionTransitionTracker regionTracker;
+
+	//Pattern detection with the spectrum pre-check, replaces the VideoAnalyser one when active
+	PatternDetectionStage patternDetection;
+
+	//Failing intervals of the session
+	IncidentIndex incidentIndex;
+
+	//Per local player views analysis, when the captured frames carry a split screen layout
+	SplitScreenAnalysis splitScreen;
+
+	//Captured frames waiting for the analysis
+	TQueue<FIrisFrame> framesToAnalyse;
+
+	TAtomic<bool> bActive{ false };
+
+	//Session settings, tiered analysis and pattern detection are fixed when the session begins
+	bool bTieredAnalysis = false;
+	bool bPatternDetection = false;
+	TAtomic<bool> bRegionTracking{ false };
+	FIrisDisplayTransform displayTransform; //linear half float frames only
+	cv::Size analysisFrameSize; //{rows, cols} of the frames given to the analysis
+
+	//Video file analysed frame by frame: the IRIS library is initialized like VideoAnalyser::AnalyseVideo (windows of
+	//the video frame rate, frame positions from the first analysed frame) instead of RealTimeInit (time stamp windows),
+	//every frame must reach it. Empty for the real time sessions
+	FString videoPath;
+	bool IsVideoSession() const { return !videoPath.IsEmpty(); }
+
+	//Session outputs, null when not used
+	DataChart* chart = nullptr;
+	SessionResultsWriter* resultsWriter = nullptr;
+	TAtomic<VideoRecorder*> videoRecorder{ nullptr }; //set while the failures are recorded
+	AnalysisCheckpoint* checkpoint = nullptr; //records the analysed frames for the session checkpoints, resumes from a loaded one
+};
@@ -8,7 +8,6 @@
 
 THIRD_PARTY_INCLUDES_START
 #include "iris/Configuration.h"
-#include "iris/VideoAnalyser.h"
 #include "iris/FrameData.h"
 #include "iris/Log.h"
 #include "VideoRecorder.h"
@@ -17,6 +16,10 @@ THIRD_PARTY_INCLUDES_END
 #include <DataChart.h>
 #include "FrameCapturerManager.h"
 #include "AsyncAnalysis.h"
+#include "IrisAnalysisContext.h"
+#include "SessionResultsWriter.h"
+#include "ConfigurationSnapshot.h"
+#include "AnalysisCheckpoint.h"
 
 #define LOCAL_SAVE_VIDEO 1
 #define DEBUG_FRAME_OPENCV 1
@@ -52,35 +55,42 @@ public:
 
 	void EndIrisSession();
 
+	/// <summary>
+	//Starts a session that resumes the analysis of a checkpoint (the last session checkpoint if no path is given)
+	/// </summary>
+	void ResumeIrisSession(const TArray<FString, FDefaultAllocator>& Args);
+
 	/// <summary>
 	/// Enqueues frames to be analysed
 	/// </summary>
 	/// <param name="frame">captured frame to analyse</param>
-	void EnqueueIrisFrame(const FIrisFrame& frame) { framesToAnalyse.Enqueue(frame); };
+	void EnqueueIrisFrame(const FIrisFrame& frame) { analysisContext.framesToAnalyse.Enqueue(frame); };
 
 	float GetFrameResizeProportion() const { return frameResizeProportion; }
 
+	bool IsTieredAnalysisActive() const { return bTieredAnalysis; }
+
 	FTextureRHIRef GetFrameBuffer() const { return gameBuffer; }
-	
-	/// <summary>
-	//Reset the parameters to be ready for the next Iris session
-	/// </summary>
-	void IrisReset();
 
-	bool GetIsVideoRecording() { return bVideoRecording; }
+	bool IsRegionTrackingActive() const { return analysisContext.bRegionTracking; }
+
+	RegionTransitionTracker* GetRegionTracker() { return &analysisContext.regionTracker; }
 
-	VideoRecorder* GetVideoRecorder() { return videoRecorder; }
+	bool IsSplitScreenActive() const { return bSplitScreen; }
 
-	TQueue<FIrisFrame>* GetFramesToAnalyse() { return &framesToAnalyse; }
+	bool IsHdrCaptureActive() const { return bHdrCapture; }
 
-	iris::VideoAnalyser* GetVideoAnalyser() { return vA; }
+	/// <summary>
+	//Display transform of the HDR frames of the current session
+	/// </summary>
+	const FIrisDisplayTransform& GetDisplayTransform() const { return analysisContext.displayTransform; }
 
-	DataChart* GetChartManager() { return &chartManager; }
+	bool IsResultsSavingActive() const { return bSaveResults; }
 
 private:
 
 	/// <summary>
-	//Iris setup
+	//Iris setup, done once on the first session (the analyser, LUTs and capture buffers are kept between sessions)
 	/// </summary>
 	void IrisInit();
 
@@ -92,12 +102,12 @@ private:
 	/// <summary>
 	//Toggle resutls graph visibility
 	/// </summary>
-	void ToggleResultsGraph() { chartManager.ToggleResultsGraph(); }
+	void ToggleResultsGraph() { chartManager.ToggleResultsGraph(); analysisContext.splitScreen.ToggleResultsGraph(); }
 
 	/// <summary>
 	//Toggle transitions graph visibility
 	/// </summary>
-	void ToggleTransitionsGraph() { chartManager.ToggleTransitionsGraph(); }
+	void ToggleTransitionsGraph() { chartManager.ToggleTransitionsGraph(); analysisContext.splitScreen.ToggleTransitionsGraph(); }
 
 	/// <summary>
 	//Toggle last rendered frame visibility (OpenCV)
@@ -109,6 +119,86 @@ private:
 	/// </summary>
 	void ToggleFramesSave() { bSaveFramesAsPNGs = !bSaveFramesAsPNGs; }
 
+	/// <summary>
+	//Toggle the tiered (low resolution + confirmation) analysis, applied on the next session
+	/// </summary>
+	void ToggleTieredAnalysis();
+
+	/// <summary>
+	//Toggle the per-region transition tracking (failing regions in the logs and heatmap in the debug frame)
+	/// </summary>
+	void ToggleRegionTracking() { analysisContext.bRegionTracking = !analysisContext.bRegionTracking; }
+
+	/// <summary>
+	//Toggle the analysis of each local player view of a split screen
+	/// </summary>
+	void ToggleSplitScreen();
+
+	/// <summary>
+	//Toggle the linear half float (HDR) frame capture, applied on the next session
+	/// </summary>
+	void ToggleHdrCapture();
+
+	/// <summary>
+	//Sets the display transform of the HDR frames (exposure and optional Reinhard white point), applied on the next session
+	/// </summary>
+	void SetDisplayTransform(const TArray<FString, FDefaultAllocator>& Args);
+
+	/// <summary>
+	//Sets the interval of the session checkpoints in seconds (0 disables them), applied on the next session
+	/// </summary>
+	void SetCheckpointInterval(const TArray<FString, FDefaultAllocator>& Args);
+
+	/// <summary>
+	//Logs the time of the luminance and red saturation conversion of each luminance model and capture format
+	/// </summary>
+	void BenchmarkConversion(const TArray<FString, FDefaultAllocator>& Args);
+
+	/// <summary>
+	//Analyses a shard of a video file into a shared directory (ShardedVideoAnalysis.h)
+	/// </summary>
+	void AnalyseVideoShard(const TArray<FString, FDefaultAllocator>& Args);
+
+	/// <summary>
+	//Merges the shards of a video into the FrameData, Incidents and Result files of a sequential run
+	/// </summary>
+	void MergeVideoShards(const TArray<FString, FDefaultAllocator>& Args);
+
+	/// <summary>
+	//Toggle the real-time pattern detection, applied on the next session
+	/// </summary>
+	void TogglePatternDetection();
+
+	/// <summary>
+	//Checks the pattern detection cascade against the IRIS pattern detection on recorded clips
+	/// </summary>
+	void ValidatePatternCascade(const TArray<FString, FDefaultAllocator>& Args);
+
+	/// <summary>
+	//Checks the split screen view verdicts against the VideoAnalyser on recorded split screen clips
+	/// </summary>
+	void ValidateSplitScreen(const TArray<FString, FDefaultAllocator>& Args);
+
+	/// <summary>
+	//Toggle the session results saving (FrameData.csv and FrameData.json), applied on the next session
+	/// </summary>
+	void ToggleResultsSaving();
+
+	/// <summary>
+	//Toggle the session binary log saving (FrameData.irislog), applied on the next session
+	/// </summary>
+	void ToggleBinaryLogSaving();
+
+	/// <summary>
+	//Converts a binary log to FrameData.csv and FrameData.json in its directory
+	/// </summary>
+	void ConvertBinaryLog(const TArray<FString, FDefaultAllocator>& Args);
+
+	/// <summary>
+	//Logs the incidents of the current or last session, optionally between two times in seconds
+	/// </summary>
+	void ListIncidents(const TArray<FString, FDefaultAllocator>& Args);
+
 	/// <summary>
 	//Function called by the drawDelegateHandle
 	/// </summary>
@@ -142,29 +232,55 @@ private:
 
 	void ToggleRecordEvents();
 
-	void ToggleRecordWarnings() { videoRecorder->ToggleWarningSaving();	}
+	void ToggleRecordWarnings() { bWarningRecording = !bWarningRecording; }
 
 	const float frameResizeProportion{ 0.2f }; //Resize proportion of the captured frame for IRIS analysis
 	cv::Size frameSize; //Size of the captured frame (resize proportion applied)
+
+	const float lowTierResizeProportion{ 0.1f }; //Resize proportion of the quiet frames analysed by the tiered analysis, suspicious windows are confirmed at frameResizeProportion
+	cv::Size lowTierFrameSize; //Size of the low resolution tier frames (low tier resize proportion applied)
 	
 	iris::Configuration configuration;
+
+	FString configurationDir; //appsettings.json directory
+
+	ConfigurationSnapshot configurationSnapshot; //parsed appsettings.json snapshot
 	
 	iris::Log log;
 
 	bool bIrisActive = false;
 
+	bool bIrisInitialized = false;
+
 	bool bDebugCapturedFrame = false;
 
-	bool bWarningRecording = false;
+	bool bWarningRecording = false; //PassWithWarning events recorded on video, applied to the video recorder when a session is set up
 
 	bool bSaveFramesAsPNGs = false;
 
+	bool bTieredAnalysis = false;
+
+	bool bPatternDetection = false;
+
+	bool bSplitScreen = false;
+
+	bool bHdrCapture = false;
+
+	FIrisDisplayTransform displayTransform; //display transform of the next sessions
+
+	float checkpointSeconds = 0.f; //interval of the session checkpoints, 0 when disabled
+
+	//Checkpoints of the session, or the loaded checkpoint of a resumed session
+	AnalysisCheckpoint sessionCheckpoint;
+
+	bool bSaveResults = false;
+
+	bool bSaveBinaryLog = false;
+
 	inline static FIrisEAModule* instance = nullptr;
 
 	FrameCapturerManager* frameCapturer = nullptr;
 
-	TQueue<FIrisFrame> framesToAnalyse;
-
 	//When this delegate is called, the DrawGraph function  is executed
 	FDelegateHandle drawDelegateHandle;	
 
@@ -174,14 +290,18 @@ private:
 
 	float irisSessionStartTime{ 0.f };
 
-	iris::VideoAnalyser* vA = nullptr;
-
 	bool bVideoRecording = false;
 
 	//Manages how to draw the debug charts
 	DataChart chartManager;
 
-	VideoRecorder* videoRecorder;
+	//Streams the session FrameData to disk
+	SessionResultsWriter resultsWriter;
+
+	VideoRecorder* videoRecorder = nullptr;
+
+	//Analyser of the game frames, its stages and the session outputs it writes to
+	FIrisAnalysisContext analysisContext;
 
 	AsyncAnalysis* irisAnalysis = nullptr;
 	FRunnableThread* asyncAnalysisThread = nullptr;
@@ -0,0 +1,204 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FourierWorkspace.h"
+#include "FrameTileGrid.h"
+#include "PatternFrameCounter.h"
+
+namespace iris
+{
+	class Configuration;
+	class PatternDetection;
+}
+
+/**
+ * Cascade stages of the pattern detection, a frame stops at the first stage that rejects it
+ */
+enum class EPatternCascadeStage : uint8
+{
+	Contrast, //fewer pixels under the dark luminance threshold than the dark components of a harmful pattern cover
+	CoarseSpectrum, //no dominant periodic peak in the spectrum of the half resolution frame
+	Spectrum, //no dominant periodic peak in the spectrum of the frame
+	Contours, //IRIS pattern region and stripes detection
+	Count
+};
+
+/**
+ * Pattern values of a frame, written by the pattern detection apart from the frame FrameData so it can run
+ * at the same time as the flash analysis
+ */
+struct FPatternFrameResult
+{
+	FPatternFrameResult() {};
+	FPatternFrameResult(const iris::FrameData& frameData) : frame(frameData.Frame), timeStampMs(frameData.TimeStampVal) {};
+
+	/// <summary>
+	//Copies the pattern values into the frame data once both detections are done
+	/// </summary>
+	void MergeInto(iris::FrameData& frameData) const
+	{
+		frameData.patternArea = patternArea;
+		frameData.patternDetectedLines = patternDetectedLines;
+		frameData.patternFrameResult = patternFrameResult;
+	}
+
+	unsigned int frame = 0;
+	unsigned long timeStampMs = 0;
+	std::string patternArea = "0.00%";
+	int patternDetectedLines = 0;
+	iris::PatternResult patternFrameResult = iris::PatternResult::Pass;
+};
+
+/**
+ * Real-time pattern detection run next to the IRIS flash analysis.
+ * The luminance plane of every analysed frame goes through a cascade of cheap tests (luminance contrast bound,
+ * half resolution spectrum, full resolution spectrum), only the frames that pass all of them, or follow a
+ * frame with a pattern, run the IRIS pattern region and stripes detection. The spectra of the cascade are computed in
+ * the FourierWorkspace buffers of the stage; the IRIS detection is prebuilt and still computes its own transform on
+ * the candidate frames. It takes whole frames, its contour analysis can not be restricted to candidate regions without
+ * changing its verdicts. The IRIS pattern frame counter only sees the candidate frames, so the persistence (PatternFail
+ * after the appsettings TimeThreshold seconds) is counted by a PatternFrameCounter that every frame of the session goes
+ * through, with the same window and fail rule.
+ *
+ * Frames are sampled every timeThreshold / sampleDivisor ms (g) while no pattern is present, and every frame once a
+ * pattern is found. The planes of the frames between two samples are kept and the frames are only counted at the next
+ * sample: when it finds a pattern, the kept frames are checked by IRIS from the newest until one has none, so the
+ * frame counter gets the same frames with a pattern as if every frame had been checked. The kept frames pass, the
+ * window still holds the previous sample, which had no pattern. Static frames repeat the last analysed frame and are
+ * kept or sampled the same way.
+ * Coverage: a pattern continuously present from t0 is found by a sample before t0 + g + one frame, before its first
+ * full window since g + one frame < timeThreshold, and its frames are counted from t0: any pattern lasting longer than
+ * the threshold is reported as PatternFail on the same frames as with every frame checked.
+ */
+class IRISEA_API PatternDetectionStage
+{
+public:
+	~PatternDetectionStage();
+
+	/// <summary>
+	//Loads the pattern detection configuration, called when a session starts
+	/// </summary>
+	void Initialize(const char* configurationPath);
+
+	/// <summary>
+	//Checks the relative luminance plane of the captured frame for patterns, only reads the planes so it can run
+	//concurrently with the flash analysis of the same frame
+	/// </summary>
+	void AnalyseFrame(const cv::Mat& luminance, double luminanceScale, const cv::Mat& bgrFrame, FPatternFrameResult& result);
+
+	/// <summary>
+	//Frame identical to the last analysed one, which had no pattern detected. Returns true if the pattern fails on it,
+	//when the last analysed frame was not sampled and the pattern is found once the frame is
+	/// </summary>
+	bool AdvanceStatic(unsigned long timeStampMs);
+
+	/// <summary>
+	//Releases the IRIS pattern detection and logs the session reject rates of the cascade stages, the workspace
+	//buffers are kept for the next session at the same frame size
+	/// </summary>
+	void Reset();
+
+	/// <summary>
+	//Runs every frame of a recorded clip through the stage and through the IRIS pattern detection alone, logs the reject
+	//rate of each cascade test, the pattern frames it would miss, the lowest peak ratios of the pattern frames and the
+	//frames whose PatternFail verdict differs. Returns true if the verdicts of the clip are the same
+	/// </summary>
+	static bool ValidateOnVideo(const char* configurationPath, const FIrisConfigurationSnapshot& settings, const FString& videoPath);
+
+private:
+
+	/// <summary>
+	//Creates the IRIS pattern detection and the workspace buffers for the captured frame size (cols x rows)
+	/// </summary>
+	void SetFrameSize(const cv::Size& frameSize);
+
+	/// <summary>
+	//Checks a sampled frame with the cascade then IRIS (IRIS only while a pattern is followed), returns true if a pattern
+	//was found
+	/// </summary>
+	bool SampleFrame(const cv::Mat& luminance, double luminanceScale, const cv::Mat& bgrFrame, FPatternFrameResult& result);
+
+	/// <summary>
+	//Keeps the planes of a frame that is not sampled, it is counted at the next sample
+	/// </summary>
+	void KeepFrame(const cv::Mat& luminance, double luminanceScale, const cv::Mat& bgrFrame, const FPatternFrameResult& result);
+
+	/// <summary>
+	//Counts the kept frames before the sample: with a pattern from its onset when the sample found one
+	/// </summary>
+	void CountKeptFrames(bool bSamplePattern);
+
+	/// <summary>
+	//Runs the cheap tests in order of cost, returns the stage that rejected the frame or Contours
+	/// </summary>
+	EPatternCascadeStage RunCascade(const cv::Mat& luminance, double luminanceScale);
+
+	/// <summary>
+	//IRIS pattern region and stripes detection, returns true if a pattern was found
+	/// </summary>
+	bool CheckContours(const cv::Mat& luminance, double luminanceScale, const cv::Mat& bgrFrame, iris::FrameData& patternData);
+
+	/// <summary>
+	//Checks a rejected frame with the validation IRIS pattern detection, which has its own frame counter and buffers
+	//so the verdicts of the session are not changed
+	/// </summary>
+	bool CheckValidationContours(const cv::Mat& luminance, double luminanceScale, const cv::Mat& bgrFrame, iris::FrameData& patternData);
+
+	void CountFrame(bool bPattern, FPatternFrameResult& result);
+
+	iris::Configuration* configuration = nullptr;
+	iris::PatternDetection* patternDetection = nullptr;
+
+	FourierWorkspace coarseWorkspace;
+	FourierWorkspace fourierWorkspace;
+	cv::Mat coarseLuminance; //half resolution luminance plane
+	cv::Mat luminanceFrame; //CV_32F luminance given to the IRIS pattern detection
+	cv::Mat originalFrame; //header of the captured frame given to the IRIS pattern detection
+
+	//Temporal sampling
+	const int32 sampleDivisor{ 4 };
+	unsigned long sampleIntervalMs = 125;
+	unsigned long lastSampleMs = 0;
+	bool bHasSample = false;
+
+	//Frames since the last sample, a static frame shares the planes of the frame it repeats
+	struct FKeptFrame
+	{
+		unsigned int frame = 0;
+		unsigned long timeStampMs = 0;
+		int32 plane = 0;
+	};
+	TArray<FKeptFrame> keptFrames;
+	TArray<cv::Mat> keptLuminance; //buffers kept allocated for the next frames, keptPlanes are in use
+	TArray<cv::Mat> keptBgr;
+	int32 keptPlanes = 0;
+	double keptLuminanceScale = 1.0;
+
+	//Peak ratios under which a frame is rejected, Iris.ValidatePatternCascade logs the lowest ratios of the IRIS patterns
+	//of recorded clips. The coarse one is lower, downscaling attenuates the thinnest stripes
+	const float coarsePeakRatioThreshold{ 12.f };
+	const float peakRatioThreshold{ 25.f };
+	float darkLuminanceThreshold = 0.8f;
+	float minDarkProportion = 0.0625f; //quarter of the appsettings AreaProportion, a harmful pattern region is about half dark
+	float timeThreshold = 0.5f;
+	PatternFrameCounter patternFrames;
+	bool bLastFramePattern = false;
+
+	//Session measurements
+	int32 frames = 0;
+	int32 unsampledFrames = 0;
+	int32 backfilledFrames = 0; //kept frames counted with the pattern found by the next sample
+	int32 stageFrames[static_cast<int32>(EPatternCascadeStage::Count)] = {}; //frames that stopped at each stage
+	double cascadeSeconds = 0.0;
+	double contoursSeconds = 0.0;
+
+	//Non-shipping builds only, rejected frames are periodically checked by IRIS to verify the cascade does not change verdicts
+	iris::PatternDetection* validationDetection = nullptr;
+	cv::Mat validationLuminance;
+	const int32 validationInterval{ 120 };
+	int32 rejectedSinceValidation = 0;
+	int32 validatedFrames = 0;
+	int32 validationMisses = 0;
+};
@@ -0,0 +1,41 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Pattern frames of the last TimeThreshold seconds, the IRIS PatternDetection Counter run over the FrameManager time
+ * window: a new frame removes the oldest frames until the window spans less than the time threshold, then it is added
+ * with the cumulative count of pattern frames (count), the count of the removed frames is kept in passed.
+ * A pattern fails when the frames with a pattern in the window reach the frames of a full window (m_frameTimeThresh,
+ * timeThreshold * fps at a steady frame rate), that is when every frame of the last TimeThreshold seconds has it.
+ * Every frame of the session must be added, a frame that was not checked is added without a pattern.
+ */
+class IRISEA_API PatternFrameCounter
+{
+public:
+
+	void Initialize(float timeThresholdSeconds);
+
+	/// <summary>
+	//Adds the next frame of the session, returns true if the pattern fails on it
+	/// </summary>
+	bool AddFrame(unsigned long timeStampMs, bool bPattern);
+
+	void Reset();
+
+	int32 GetPatternFrames() const { return current; }
+	int32 GetFramesInWindow() const { return frameTimeStamps.Num(); }
+
+private:
+
+	void UpdatePassed();
+
+	float timeBarrierMs = 500.f;
+	TArray<unsigned long> frameTimeStamps; //frames in the window
+	TArray<int32> count; //cumulative pattern frames of the frames in the window
+	int32 passed = 0; //cumulative pattern frames of the last removed frame
+	int32 current = 0; //pattern frames in the window
+	int32 frameTimeThresh = 0; //frames in the window the last time it was full, 0 until the window is full
+};
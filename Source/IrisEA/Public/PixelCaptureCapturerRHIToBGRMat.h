@@ -4,6 +4,7 @@
 
 #include "RHI.h"
 #include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
 
 THIRD_PARTY_INCLUDES_START
 #include "PixelCaptureCapturer.h"
@@ -13,10 +14,53 @@ THIRD_PARTY_INCLUDES_START
 THIRD_PARTY_INCLUDES_END
 
 /**
- * A basic capturer that will capture RHI texture frames to OpenCV BGR mat utilizing cpu functions.
- * Involves CPU readback of GPU textures and processing of that readback data.
+ * CPU readback texture kept mapped while it is in use. A captured frame is a view of its mapped memory, the slot is
+ * not captured into again while a frame holds a reference to it
+ */
+struct FIrisReadbackSlot
+{
+	FTextureRHIRef texture;
+	void* data = nullptr;
+	int32 stride = 0; //in pixels
+};
+
+/**
+ * Readback slots of a capture size. A slot is handed out as a shared reference whose deleter gives it back to the pool
+ * when the last frame holding it is released. Closing the pool (capturer resized or destroyed) unmaps the free slots,
+ * the ones still held by frames are unmapped when they are released, the frames keep the pool alive until then
+ */
+class ReadbackSlotPool : public TSharedFromThis<ReadbackSlotPool, ESPMode::ThreadSafe>
+{
+public:
+	/// <summary>
+	//Creates and maps slotCount readback textures
+	/// </summary>
+	void Initialize(const FRHITextureCreateDesc& readbackDesc, int32 slotCount);
+
+	/// <summary>
+	//Returns a free slot, null if every slot is held by a frame
+	/// </summary>
+	TSharedPtr<FIrisReadbackSlot, ESPMode::ThreadSafe> Acquire();
+
+	void Close();
+
+private:
+	void Release(FIrisReadbackSlot* slot);
+
+	static void Unmap(FIrisReadbackSlot* slot);
+
+	FCriticalSection lock;
+	TArray<FIrisReadbackSlot*> freeSlots;
+	bool bClosed = false;
+};
+
+/**
+ * A basic capturer that will capture RHI texture frames to OpenCV BGRA mats without CPU copies.
+ * The frames are read back into a pool of persistently mapped textures and output as strided views of the mapped
+ * memory (B, G, R, A bytes); when every slot is still held by the analysis the frame is copied out of a spare slot.
+ * HDR captures use PF_FloatRGBA textures instead, the frames are then linear R, G, B, A half floats.
  * Input: FPixelCaptureInputFrameRHI
- * Output: FPixelCaptureOutputFrameI420
+ * Output: PixelCaptureOutputFrameBGR
  */
 class IRISEA_API PixelCaptureCapturerRHIToBGRMat : public FPixelCaptureCapturer, public TSharedFromThis<PixelCaptureCapturerRHIToBGRMat>
 {
@@ -24,8 +68,9 @@ public:
 	/**
 	 * Creates a new Capturer capturing the input frame at the given scale.
 	 * @param InScale The scale of the resulting output capture.
+	 * @param InFormat PF_B8G8R8A8 or PF_FloatRGBA (HDR capture).
 	 */
-	static TSharedPtr<PixelCaptureCapturerRHIToBGRMat> Create(float InScale);
+	static TSharedPtr<PixelCaptureCapturerRHIToBGRMat> Create(float InScale, EPixelFormat InFormat = PF_B8G8R8A8);
 	virtual ~PixelCaptureCapturerRHIToBGRMat();
 
 protected:
@@ -36,14 +81,16 @@ protected:
 
 private:
 	float Scale = 1.0f;
+	EPixelFormat Format = PF_B8G8R8A8;
 
 	FTextureRHIRef StagingTexture;
-	FTextureRHIRef ReadbackTexture;
 
-	void* ResultsBuffer = nullptr;
-	int32 MappedStride = 0;
+	//Slots handed to the frames, plus the spare whose frames are copied so it is always free
+	static constexpr int32 ReadbackSlotCount = 3;
+	TSharedPtr<ReadbackSlotPool, ESPMode::ThreadSafe> ReadbackSlots;
+	TSharedPtr<FIrisReadbackSlot, ESPMode::ThreadSafe> SpareSlot;
 
-	PixelCaptureCapturerRHIToBGRMat(float InScale);
-	void OnRHIStageComplete(IPixelCaptureOutputFrame* OutputBuffer);
+	PixelCaptureCapturerRHIToBGRMat(float InScale, EPixelFormat InFormat);
+	void OnRHIStageComplete(IPixelCaptureOutputFrame* OutputBuffer, TSharedPtr<FIrisReadbackSlot, ESPMode::ThreadSafe> Slot, bool bCopy);
 	void CleanUp();
 };
@@ -11,8 +11,11 @@ THIRD_PARTY_INCLUDES_START
 #include "opencv2/opencv.hpp"
 #define check(expr)				UE_CHECK_IMPL(expr)
 THIRD_PARTY_INCLUDES_END
+
+struct FIrisReadbackSlot;
+
 /**
- * 
+ * Captured BGRA (or linear half float RGBA) frame, a view of the mapped readback slot it holds (or an owned copy without slot)
  */
 class IRISEA_API PixelCaptureOutputFrameBGR : public IPixelCaptureOutputFrame
 {
@@ -26,11 +29,25 @@ public:
 
 	virtual int32 GetWidth() const override { return width; }
 	virtual int32 GetHeight() const override { return height; }
-	void SetMat(cv::Mat &BGRMat) { BGRmat = BGRMat; }
-	cv::Mat& GetMat() { return BGRmat; }
+	void SetMat(const cv::Mat& BGRAMat, const TSharedPtr<FIrisReadbackSlot, ESPMode::ThreadSafe>& Slot)
+	{
+		BGRAmat = BGRAMat;
+		ReadbackSlot = Slot;
+	}
+
+	/// <summary>
+	//Moves the frame and its readback slot out, the output buffer does not keep the slot from being captured into again
+	/// </summary>
+	void TakeMat(cv::Mat& OutMat, TSharedPtr<FIrisReadbackSlot, ESPMode::ThreadSafe>& OutSlot)
+	{
+		OutMat = BGRAmat;
+		OutSlot = MoveTemp(ReadbackSlot);
+		BGRAmat.release();
+	}
 
 private:
-	cv::Mat BGRmat;
+	cv::Mat BGRAmat;
+	TSharedPtr<FIrisReadbackSlot, ESPMode::ThreadSafe> ReadbackSlot;
 	int32 width;
 	int32 height;
 };
@@ -0,0 +1,109 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FIrisFrameRecord;
+class RawFrameAnalyser;
+
+/**
+ * Raw buffer ingestion API: frames from sources that do not use OpenCV (engine readbacks, ffmpeg pipes, shared
+ * memory) are analysed straight from their pixel buffer, with the frame index kept by the analyser.
+ *
+ * The buffer is only read during the IrisAnalyseRawFrame call. BGRA8, BGR8 and RGBA16F frames are analysed in place
+ * (RGBA16F as linear half floats through the default display transform, clamped to [0, 1]), the other formats are
+ * converted once to BGR in a buffer reused by the analyser:
+ *  - RGBA8: channel swap
+ *  - NV12: Y plane and interleaved UV plane at half resolution (BT.601)
+ *
+ * Analysers never run concurrently. The prebuilt IRIS library keeps its time windows (FrameManager::GetInstance) and
+ * the flash frame rate (Flash::fps) as process-wide statics, shared by every analyser of the process, so an analyser
+ * holds the library from its creation to its destruction (FIrisAnalysisContext): analysers created on several threads
+ * are serialised and analyse one after the other, and none can be created while a session of the module is running.
+ * Streams are only analysed in parallel by separate processes (ShardedVideoAnalysis.h).
+ */
+
+enum class EIrisPixelFormat : uint8
+{
+	BGRA8,
+	RGBA8,
+	BGR8,
+	NV12,
+	RGBA16F
+};
+
+enum class EIrisIngestStatus : uint8
+{
+	Ok,
+	InvalidArguments, //null analyser or data, negative stride or stride smaller than a row, NV12 without UV plane or of odd size
+	SizeMismatch, //frame size differs from the size the analyser was created with
+	UnsupportedFormat
+};
+
+struct FIrisRawFrame
+{
+	EIrisPixelFormat format = EIrisPixelFormat::BGRA8;
+	const uint8* data = nullptr;
+	int32 width = 0;
+	int32 height = 0;
+	int32 stride = 0; //bytes between rows, 0 for tightly packed rows
+	uint64 timeStampUs = 0; //capture time, any origin, must not go backwards
+
+	//NV12 UV plane (required, height / 2 rows of width bytes), uvStride 0 for the stride of the Y plane
+	const uint8* uvData = nullptr;
+	int32 uvStride = 0;
+};
+
+/// <summary>
+//Creates an analyser for frames of the given size with the appsettings.json of configurationDir, once the analyser
+//holding the IRIS library is destroyed. Null if the configuration can not be loaded or the library is still held
+//after waitSeconds (no limit if negative, do not wait on the thread of an analyser that holds it)
+/// </summary>
+IRISEA_API RawFrameAnalyser* IrisCreateRawAnalyser(const TCHAR* configurationDir, int32 width, int32 height, float waitSeconds = -1.f);
+
+/// <summary>
+//Creates an analyser for the frames of a video file, its IRIS library is initialized like VideoAnalyser::AnalyseVideo
+//(windows of the video frame rate instead of the time stamps). Every frame from the first analysed one must be given
+//in order, repeated frames included. Null like IrisCreateRawAnalyser or if the library can not open the video
+/// </summary>
+IRISEA_API RawFrameAnalyser* IrisCreateRawVideoAnalyser(const TCHAR* configurationDir, const TCHAR* videoPath, int32 width, int32 height, float waitSeconds = -1.f);
+
+/// <summary>
+//Analyses a frame and writes its results to outResult (owned by the caller), frames are numbered from 0 in the
+//order they are given and their time stamps are relative to the first frame
+/// </summary>
+IRISEA_API EIrisIngestStatus IrisAnalyseRawFrame(RawFrameAnalyser* analyser, const FIrisRawFrame& frame, FIrisFrameRecord& outResult);
+
+/// <summary>
+//Analyses consecutive frames, same results as IrisAnalyseRawFrame on each of them: the plugin per-frame conversions
+//run on the task graph workers, then the frames are analysed in order. The IRIS library frame conversion and analysis
+//stay sequential, so only the preparation is sped up. outResults needs a record per frame. The frames are checked
+//first, none is analysed if one of them is rejected
+/// </summary>
+IRISEA_API EIrisIngestStatus IrisAnalyseRawFrames(RawFrameAnalyser* analyser, TArrayView<const FIrisRawFrame> frames, TArrayView<FIrisFrameRecord> outResults);
+
+/// <summary>
+//Numbers the frames from firstFrame and measures their time stamps from timeOriginUs instead of the first frame, for
+//analysers that start in the middle of a stream (video shards). Only valid before the first frame
+/// </summary>
+IRISEA_API bool IrisSetRawFrameOrigin(RawFrameAnalyser* analyser, uint32 firstFrame, uint64 timeOriginUs);
+
+/// <summary>
+//Writes a checkpoint of the analysis to checkpointPath every intervalSeconds of frame time (AnalysisCheckpoint.h), the
+//warm-up tail is recorded from this call
+/// </summary>
+IRISEA_API bool IrisEnableRawCheckpoints(RawFrameAnalyser* analyser, const TCHAR* checkpointPath, float intervalSeconds);
+
+/// <summary>
+//Creates an analyser that resumes the analysis of a checkpoint, for frames of the checkpoint size: its warm-up tail is
+//replayed, then the frames continue its numbering and time stamps. The checkpoint keeps being written every
+//intervalSeconds if it is not 0. Null if the checkpoint can not be loaded or was written with another configuration,
+//waits for the IRIS library like IrisCreateRawAnalyser
+/// </summary>
+IRISEA_API RawFrameAnalyser* IrisResumeRawAnalyser(const TCHAR* configurationDir, const TCHAR* checkpointPath, float intervalSeconds, float waitSeconds = -1.f);
+
+/// <summary>
+//Closes the analysis (open incidents are logged) and deletes the analyser
+/// </summary>
+IRISEA_API void IrisDestroyRawAnalyser(RawFrameAnalyser* analyser);
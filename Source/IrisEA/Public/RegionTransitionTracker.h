@@ -0,0 +1,97 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "FrameTileGrid.h"
+#include "FlashTransitionRules.h"
+
+namespace iris
+{
+	struct FlashParams;
+	struct TransitionTrackerParams;
+}
+
+/**
+ * Tracks luminance and red saturation flash transitions per screen region (one region per FrameTileGrid tile)
+ * to locate the flashing elements of a failing frame.
+ * The state of all the regions is stored as structure-of-arrays and updated with branchless loops, the
+ * transitions use the plugin IRIS rules (FlashTransitionRules.h) with a channel per region.
+ */
+class IRISEA_API RegionTransitionTracker
+{
+public:
+	static constexpr int32 RegionCount = FrameTileGrid::TileCount;
+
+	/// <summary>
+	//Sets the flash and transition parameters, called when a session starts
+	/// </summary>
+	void Initialize(const iris::FlashParams& luminanceParams, const iris::FlashParams& redParams, const iris::TransitionTrackerParams& transitionParams);
+
+	/// <summary>
+	//Checks the regions for new transitions using the variation of the tiles in the last frame
+	/// </summary>
+	void Update(const TArray<FTileStats>& tileStats, unsigned long timeStampMs);
+
+	/// <summary>
+	//Advances the one second window for a frame without variation (static frame)
+	/// </summary>
+	void AdvanceStatic(unsigned long timeStampMs);
+
+	/// <summary>
+	//Returns the regions whose luminance (or red) transitions in the last second are over the max transitions
+	/// </summary>
+	void GetFailingRegions(bool bRed, TArray<int32>& outRegions) const;
+
+	/// <summary>
+	//Returns a copy of the transitions of every region (max of luminance and red), safe to call from any thread
+	/// </summary>
+	void GetHeatmap(TArray<uint8>& outTransitions) const;
+
+	/// <summary>
+	//Draws the regions transitions heatmap over the frame (green = no transitions, red = fail)
+	/// </summary>
+	void DrawHeatmap(cv::Mat& frame) const;
+
+	static FString DescribeRegions(const TArray<int32>& regions);
+
+	void Reset();
+
+private:
+
+	/// <summary>
+	//Accumulates the regions variation and writes the new transitions of the frame in newTransitions
+	/// </summary>
+	void CheckTransitions(const float* avgDiff, const float* mean, float* lastMean, float* avgDiffAcc, float threshold, float darkThreshold, uint8* newTransitions);
+
+	void PushTransitions(unsigned long timeStampMs);
+
+	float luminanceThreshold = 0.1f;
+	float luminanceDarkThreshold = 0.8f;
+	float luminanceArea = 0.25f;
+	float redThreshold = 20.f;
+	float redDarkThreshold = 321.f;
+	float redArea = 0.25f;
+	int32 maxTransitions = 6;
+
+	//Structure-of-arrays regions state
+	float luminanceDiff[RegionCount] = {};
+	float redDiff[RegionCount] = {};
+	float luminanceMean[RegionCount] = {};
+	float redMean[RegionCount] = {};
+	float lastLuminanceMean[RegionCount] = {};
+	float lastRedMean[RegionCount] = {};
+	float luminanceDiffAcc[RegionCount] = {};
+	float redDiffAcc[RegionCount] = {};
+	uint8 newLuminanceTransitions[RegionCount] = {};
+	uint8 newRedTransitions[RegionCount] = {};
+
+	//Transitions of the last second, a channel per region
+	TransitionWindow luminanceWindow{ RegionCount };
+	TransitionWindow redWindow{ RegionCount };
+	bool bHasLastFrame = false;
+
+	mutable FCriticalSection heatmapSection;
+	TArray<uint8> heatmap;
+};
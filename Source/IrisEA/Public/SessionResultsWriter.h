@@ -0,0 +1,96 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Containers/CircularQueue.h"
+#include "FrameDataBinaryLog.h"
+#include <FrameStruct.h>
+#include <string>
+
+class IFileHandle;
+
+/**
+ * Writes the FrameData of every analysed frame of a session to FrameData.csv and FrameData.json
+ * (/Saved/IrisSessions/Results/Date&Time/) from a background thread.
+ * The analysis thread only enqueues a compact record of the frame data (FIrisFrameRecord) in a lock-free ring; the
+ * writer rebuilds the text values, formats them and writes large chunks, the CSV directly and the JSON one spill file per column. The columns are stitched when the session ends, producing the
+ * same bytes as serializing an iris::FrameDataJson with nlohmann::json::dump() while only keeping a chunk per
+ * column in memory.
+ * The frames can also be written to FrameData.irislog (FrameDataBinaryLog) on the same thread, for sessions too long
+ * to keep as text; Iris.ConvertBinaryLog turns it back into the CSV and JSON files.
+ */
+class IRISEA_API SessionResultsWriter : public FRunnable
+{
+public:
+	SessionResultsWriter();
+	~SessionResultsWriter();
+
+	/// <summary>
+	//Creates the results files (CSV and JSON and/or the binary log) and starts the writer thread.
+	//The files go to a new session directory unless a folder is given
+	/// </summary>
+	void Open(bool bText, bool bBinary, const FString& folder = FString());
+
+	/// <summary>
+	//Enqueues the frame data to be written, called from the analysis thread. Blocks until the writer frees a slot only
+	//if it is a full ring of frames behind, every frame is written
+	/// </summary>
+	void PushFrameData(const iris::FrameData& frameData);
+
+	/// <summary>
+	//Writes the remaining frames, stitches the JSON columns and closes the files
+	/// </summary>
+	void Close();
+
+	bool IsOpen() const { return thread != nullptr; }
+
+	const FString& GetFolderPath() const { return folderPath; }
+
+	uint32 Run() override;
+	void Stop() override { bStopping = true; }
+
+private:
+
+	struct FColumn
+	{
+		std::string name;
+		int32 valueIndex = 0; //FrameDataJson column
+		std::string buffer; //elements not yet written to the spill file
+		FString spillPath;
+		TUniquePtr<IFileHandle> spillFile;
+	};
+
+	void WriteFrame(const FIrisFrameRecord& record);
+
+	void WriteJson();
+
+	/// <summary>
+	//Value of a FrameDataJson column for a frame, serialized as nlohmann::json does
+	/// </summary>
+	static std::string FormatColumnValue(int32 column, const iris::FrameData& data);
+
+	static void WriteString(IFileHandle* file, const std::string& value);
+
+	const int32 chunkSize{ 1024 * 1024 }; //CSV and JSON writes
+	const int32 columnChunkSize{ 64 * 1024 }; //JSON column spill writes, one buffer per column
+
+	TCircularQueue<FIrisFrameRecord> pendingFrames{ 4096 };
+	FEvent* framesEvent = nullptr;
+	FEvent* spaceEvent = nullptr; //triggered by the writer when it dequeues a frame while the analysis thread waits
+	TAtomic<bool> bWaitingForSpace{ false };
+	FRunnableThread* thread = nullptr;
+	TAtomic<bool> bStopping{ false };
+
+	FString folderPath;
+	bool bWriteText = true;
+	FrameDataLogWriter binaryLog;
+	TUniquePtr<IFileHandle> csvFile;
+	std::string csvBuffer;
+	iris::FrameData frameData; //reused to format the records
+	TArray<FColumn> columns; //sorted by name, as nlohmann::json orders the object keys
+	int64 writtenFrames = 0;
+	int64 fullQueueWaits = 0; //frames the analysis thread waited for the writer
+};
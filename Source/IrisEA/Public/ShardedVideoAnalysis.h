@@ -0,0 +1,67 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace cv
+{
+	class VideoCapture;
+}
+
+/**
+ * Analysis of a video split in shards, each one analysed by its own process (or machine) into a shared directory,
+ * then merged into the results of a single sequential run.
+ *
+ * A shard covers the frames [frameCount * shard / shardCount, frameCount * (shard + 1) / shardCount) of the container
+ * frame count, the last shard reads until the end of the video. It starts analysing the longest IRIS time window
+ * before its range (extended fail window plus one second), so the flash windows are full on its first frame, and only
+ * keeps the frames of its range. Frames are numbered and time stamped from the start of the video, like the sequential
+ * run. A frame that can not be read while the video has more frames fails the shard, only the end of the video ends
+ * it early.
+ *
+ * The shards of a run share a session name, so the files of an earlier run in the shared directory are never merged.
+ * A shard writes to the shared directory:
+ *  - <video>.<session>.shard<k>of<n>.irislog: the FrameData of its range (FrameDataBinaryLog columns)
+ *  - <video>.<session>.shard<k>of<n>.json: its manifest, written last so it marks the shard as complete, with the
+ *    session, frame range, container frame count, frame rate, analysis time and the incidents of the range (same
+ *    fields as Incidents.json)
+ * The merge checks that every shard of the session is complete and that they cover the video with no gap,
+ * concatenates their frames into FrameData.csv, FrameData.json and FrameData.irislog, stitches the incidents that
+ * continue across a shard boundary into Incidents.json and rebuilds the iris::Result of the video (frame counts of
+ * each result type) into Result.json.
+ *
+ * The shards use a raw video analyser (IrisCreateRawVideoAnalyser), initialized like VideoAnalyser::AnalyseVideo so
+ * the IRIS windows follow the video frame rate, and holding the IRIS library of its process: a shard fails if a
+ * session or another analyser of the process is running.
+ */
+class IRISEA_API ShardedVideoAnalysis
+{
+public:
+
+	/// <summary>
+	//Analyses a shard of the video with the appsettings.json of configurationDir, warmUpSeconds of frames before its range
+	/// </summary>
+	static bool AnalyseShard(const FString& configurationDir, const FString& videoPath, int32 shard, int32 shardCount, const FString& session, float warmUpSeconds, const FString& sharedDir);
+
+	/// <summary>
+	//Merges the shardCount shards of the session of the video (base name of the video file) into the results of outputDir,
+	//fails if one of them is missing, not finished or from another video
+	/// </summary>
+	static bool MergeShards(const FString& sharedDir, const FString& videoName, int32 shardCount, const FString& session, const FString& outputDir);
+
+	static FString GetShardPath(const FString& sharedDir, const FString& videoName, const FString& session, int32 shard, int32 shardCount);
+
+private:
+
+	/// <summary>
+	//True if the video has no frame after a failed read, a frame that could not be decoded is followed by others
+	/// </summary>
+	static bool IsEndOfVideo(cv::VideoCapture& video);
+
+	//Frames grabbed after a failed read before the video is considered ended
+	static constexpr int32 EndOfVideoProbeFrames = 8;
+
+	//Frames decoded and analysed together (IrisAnalyseRawFrames)
+	static constexpr int32 BatchFrames = 32;
+};
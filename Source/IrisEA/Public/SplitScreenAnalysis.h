@@ -0,0 +1,125 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <FrameStruct.h>
+#include "FrameTileGrid.h"
+#include "IncidentIndex.h"
+#include "DataChart.h"
+#include "FlashTransitionRules.h"
+
+class ConfigurationSnapshot;
+namespace iris
+{
+	class VideoAnalyser;
+}
+
+/**
+ * Frame level flash transitions of one channel (luminance or red saturation) of a view, with the plugin IRIS rules
+ * (FlashTransitionRules.h)
+ */
+struct FViewFlashChannel
+{
+	float threshold = 0.f;
+	float darkThreshold = 0.f;
+	float areaProportion = 0.f;
+
+	/// <summary>
+	//Adds the frame variation and returns the flash result of the frame, transitions of the last second in outTransitions
+	/// </summary>
+	iris::FlashResult Update(float avgDiff, float flashArea, float mean, unsigned long timeStampMs, uint32& outTransitions);
+
+	void Reset();
+
+	//Transition rules, shared by the channels of every view
+	FFlashTransitionParams transitionParams;
+
+private:
+	float lastMean = 0.f;
+	float avgDiffAcc = 0.f;
+	bool bHasLastFrame = false;
+
+	TransitionWindow transitions;
+	ExtendedFailWindow extendedFail;
+};
+
+/**
+ * Analysis of the local player views of a split screen: each view is cut from the single captured frame (no extra
+ * readback or copy) and analysed on its own, so a flash covering one view is not diluted below the area proportion
+ * by the rest of the screen. The views run in parallel on the task graph workers, each one with its own tile grid,
+ * flash transitions, incidents and chart (drawn in the player view).
+ * The prebuilt IRIS library keeps its time windows in process wide singletons, so the view verdicts are computed by
+ * the plugin from the tile grid frame values with the rules shared with the region tracker; the whole frame is still
+ * analysed by the VideoAnalyser. ValidateOnVideo checks the view verdicts against the VideoAnalyser on recorded clips.
+ */
+class IRISEA_API SplitScreenAnalysis
+{
+public:
+	static constexpr int32 MaxViews = 4;
+
+	/// <summary>
+	//Sets the flash and transition parameters of the views, called when a session starts
+	/// </summary>
+	void Initialize(const ConfigurationSnapshot& configurationSnapshot, const FIrisDisplayTransform& displayTransform);
+
+	/// <summary>
+	//Analyses the views of the frame, a view that is no longer in the layout closes its incidents
+	/// </summary>
+	void Update(const FIrisFrame& frame);
+
+	/// <summary>
+	//Closes the incidents of the views and writes them to resultsFolder/Incidents_Player<N>.json if not empty
+	/// </summary>
+	void EndSession(const FString& resultsFolder);
+
+	int32 GetViewCount() const { return viewCount; }
+
+	/// <summary>
+	//Draws the charts of the view, returns false if the view is not analysed
+	/// </summary>
+	bool DrawCharts(UCanvas* Canvas, int32 view);
+
+	void ToggleResultsGraph();
+	void ToggleTransitionsGraph();
+	void MoveCharts(DataChart::EDirections moveTo);
+
+	/// <summary>
+	//Returns the view rect of a normalized local player rect in a frame of the given size
+	/// </summary>
+	static cv::Rect GetViewRect(const cv::Size& frameSize, const FBox2f& view);
+
+	/// <summary>
+	//Returns the normalized views of a layout: 1 (full frame), 2h (side by side), 2v (top and bottom) or 4 (quadrants),
+	//false if the layout is not known
+	/// </summary>
+	static bool GetLayoutViews(const FString& layout, TArray<FBox2f>& outViews);
+
+	/// <summary>
+	//Analyses a recorded split screen clip with the views of the layout, then each view cropped from the clip with the
+	//VideoAnalyser (its IRIS library must be held by the caller). Logs the frames whose flash results or transitions
+	//differ, returns true if the flash results of every view are the same
+	/// </summary>
+	static bool ValidateOnVideo(iris::VideoAnalyser& reference, const ConfigurationSnapshot& configurationSnapshot, const FString& videoPath, const TArray<FBox2f>& layoutViews);
+
+private:
+
+	struct FViewAnalysis
+	{
+		FBox2f view{ ForceInit };
+		FrameTileGrid tileGrid;
+		TArray<uint64> tileSignatures;
+		FViewFlashChannel luminance;
+		FViewFlashChannel red;
+		iris::FrameData frameData;
+		IncidentIndex incidentIndex;
+		DataChart chart;
+		bool bActive = false; //view in the current layout
+		bool bUsed = false; //view analysed during the session
+	};
+
+	void UpdateView(FViewAnalysis& analysis, const FIrisFrame& frame, const FBox2f& view);
+
+	FViewAnalysis views[MaxViews];
+	int32 viewCount = 0;
+};
@@ -0,0 +1,48 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <FrameStruct.h>
+
+/**
+ * Skips the analysis of frames identical to the last analysed one (paused game, menus, loading screens).
+ * A repeated frame has no luminance or red variation, so it is only skipped while the analysis is quiet
+ * (no transitions, extended fail counts or patterns in the last verdict): the IRIS time windows then hold
+ * only zeros and treat the skipped frames as a frame drop, which gives the same verdicts as analysing them.
+ */
+class IRISEA_API StaticFrameFilter
+{
+public:
+
+	/// <summary>
+	//Computes the signature of a captured frame from the content checksums of its tiles
+	/// </summary>
+	static uint64 ComputeSignature(const TArray<uint64>& tileSignatures);
+
+	/// <summary>
+	//Returns true if the frame does not need to be analysed, its frameData is then filled from the last analysed frame
+	/// </summary>
+	bool TryReuseLastVerdict(FIrisFrame& frame);
+
+	/// <summary>
+	//Registers the frame that has just been analysed as the reference for the next frames
+	/// </summary>
+	void SetAnalysedFrame(const FIrisFrame& frame);
+
+	/// <summary>
+	//Forgets the reference frame and logs the skipped frames of the session
+	/// </summary>
+	void Reset();
+
+private:
+
+	bool IsQuiet(const iris::FrameData& frameData) const;
+
+	uint64 lastSignature = 0;
+	iris::FrameData lastFrameData;
+	bool bHasReference = false;
+
+	int32 analysedFrames = 0;
+	int32 skippedFrames = 0;
+};
@@ -0,0 +1,92 @@
+//Copyright(c) 2024 Electronic Arts Inc.All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tasks/Task.h"
+#include <FrameStruct.h>
+
+namespace iris
+{
+	class VideoAnalyser;
+}
+
+/**
+ * Two-tier real-time analysis.
+ * Frames are captured at the session analysis resolution (the confirmation tier) but analysed below it, at the low
+ * resolution tier, while the content is quiet, so quiet content costs less than analysing every frame at the session
+ * resolution.
+ * The frames of the longest IRIS time window (extended fail window plus one second) are kept in a ring. When the low
+ * resolution transitions reach the suspicion level the VideoAnalyser is re-initialized at the confirmation resolution
+ * and the ring is replayed into it on a task graph worker, which rebuilds all its time windows (the extended fail
+ * count included) as if every frame had been analysed at that resolution; its verdicts are the ones reported until
+ * the content settles down, then the ring is replayed the same way into the low resolution tier. A switch does not
+ * lose the analyser state, it only changes the resolution it was built at.
+ * The frame that triggers a switch keeps the verdict of the tier it was analysed on (it is part of the replayed
+ * window), the next frame waits for the replay before it reaches the VideoAnalyser. A switch waits for the tasks that
+ * use the IRIS library on the same frame (pattern detection) before the VideoAnalyser is re-initialized.
+ */
+class IRISEA_API TieredAnalysis
+{
+public:
+	TieredAnalysis(iris::VideoAnalyser* analyser);
+
+	/// <summary>
+	//Sets the analysis sizes ({rows, cols} as expected by VideoAnalyser::RealTimeInit), the transitions that trigger a
+	//confirmation and the seconds of frames replayed on a switch (longest IRIS time window)
+	/// </summary>
+	void Initialize(const cv::Size& lowSize, const cv::Size& highSize, int suspicionTransitions, float windowSeconds);
+
+	/// <summary>
+	//Analyses the captured frame (BGR, kept in the frame ring) on the active tier, frameData holds the reported verdict.
+	//A switch triggered by the frame starts once concurrentTask (IRIS library work on the same frame) is done
+	/// </summary>
+	void AnalyseFrame(cv::Mat& bgrFrame, iris::FrameData& frameData, const UE::Tasks::FTask& concurrentTask = UE::Tasks::FTask());
+
+	/// <summary>
+	//Waits for the replay in progress, clears the frame ring and goes back to the low resolution tier, called when the
+	//session ends before the VideoAnalyser is released
+	/// </summary>
+	void Reset();
+
+	bool IsConfirming() const { return bConfirming; }
+
+	//Tier switch in progress, the other users of the IRIS library start after it
+	const UE::Tasks::FTask& GetSwitchTask() const { return switchTask; }
+
+private:
+
+	/// <summary>
+	//Re-initializes the VideoAnalyser at the tier resolution and replays the buffered window on a worker
+	/// </summary>
+	void SwitchTier(bool bHighResolution, const UE::Tasks::FTask& prerequisite);
+
+	void AnalyseOnActiveTier(cv::Mat& capturedFrame, iris::FrameData& frameData);
+
+	void PushToRing(const cv::Mat& bgrFrame, const iris::FrameData& frameData);
+
+	bool IsSuspicious(const iris::FrameData& frameData) const;
+
+	bool IsQuiet(const iris::FrameData& frameData) const;
+
+	iris::VideoAnalyser* videoAnalyser = nullptr;
+
+	cv::Size lowResolutionSize;
+	cv::Size highResolutionSize;
+	cv::Mat lowResolutionFrame;
+
+	//Captured frames of the last ringSeconds, oldest first, only changed while no replay is running
+	TArray<FIrisFrame> frameRing;
+	float ringSeconds = 6.f;
+
+	//Re-initialization and replay of the frame ring
+	UE::Tasks::FTask switchTask;
+
+	//Frames must stay quiet this long on the confirmation tier before going back to the low resolution tier
+	const float relaxSeconds{ 1.f };
+	unsigned long quietSinceMs = 0;
+
+	int suspicionLevel = 2;
+
+	bool bConfirming = false;
+};
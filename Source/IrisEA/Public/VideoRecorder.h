@@ -3,7 +3,6 @@
 #pragma once
 
 THIRD_PARTY_INCLUDES_START
-#include "src/FrameManager.h"
 #include "iris/FrameData.h"
 THIRD_PARTY_INCLUDES_END
 #include "FrameStruct.h"
@@ -13,11 +12,12 @@ THIRD_PARTY_INCLUDES_END
 class IRISEA_API VideoRecorder
 {
 public:
-	VideoRecorder(iris::Configuration& config);
+	VideoRecorder();
 	~VideoRecorder() {};
 
-	//Enqueues last frame and writes to videofile when needed
-	void EnqueueLastFrameAndCheck(FIrisFrame irisFrame, std::string lumResultStr, std::string redResultStr, std::string patternResultStr);
+	//Enqueues last frame and writes to videofile when needed. analysedFrame is the 8 bit BGR frame given to the IRIS library,
+	//copied instead of converting the captured frame again, empty for the static frames (the last recorded frame is repeated)
+	void EnqueueLastFrameAndCheck(const FIrisFrame& irisFrame, const cv::Mat& analysedFrame, std::string lumResultStr, std::string redResultStr, std::string patternResultStr);
 	
 	//When a new sessions starts, a directory is created with its local date and time (/Saved/IrisSessions/Videos/Date&Time)
 	void CreateDirectory();
@@ -25,7 +25,11 @@ public:
 	//Resets the VideoRecorder parameters when a session ends
 	void Reset();
 
-	void ToggleWarningSaving() { bWarningSaving = !bWarningSaving; }
+	//Includes the PassWithWarning events in the recordings, set when a session starts
+	void SetWarningSaving(bool bSave) { bWarningSaving = bSave; }
+
+	//Display transform of the recorded half float frames, set when a session starts
+	void SetDisplayTransform(const FIrisDisplayTransform& transform) { displayTransform = transform; }
 
 private:
 
@@ -48,7 +52,9 @@ private:
 
 	cv::VideoWriter videoWriter;
 
-	int frameManagerIndex;
+	//Time stamps of the frames of the last second, used as the video frame rate
+	TQueue<unsigned long> frameTimeStamps;
+	int framesInWindow = 0;
 
 	int fourcc;
 	int sessionFPS = 60;
@@ -56,9 +62,11 @@ private:
 	int remainingFramesToFill = sessionFPS * extraSecondsToRecord;
 
 	bool bWarningSaving = false;
+	FIrisDisplayTransform displayTransform;
 	//Last extraSecondsToRecord of frames
 	TQueue<cv::Mat> lastFramesQueue;
 	int framesInsideQueue = 0; 
+	cv::Mat lastRecordedFrame;
 
 	std::string tempVideoFile = "";
 	std::string finalVideoFile = "";